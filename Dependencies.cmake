@@ -30,6 +30,10 @@ set(INTERPROCEDURAL_OPTIMIZATION ON)
 # exceptions (the option is ignored).
 set(FLOATING_POINT_EXCEPTIONS_ENABLED OFF)
 
+# Compile Jolt's debug renderer into Debug and Release builds, for the physics
+# debug view in the Dev Panel. Distribution builds leave it out.
+set(DEBUG_RENDERER_IN_DEBUG_AND_RELEASE ON)
+
 # Number of bits to use in ObjectLayer. Can be 16 or 32.
 set(OBJECT_LAYER_BITS 16)
 
@@ -0,0 +1,165 @@
+#include "allocation_stats.h"
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+#include <Jolt/Core/Memory.h>
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+// clang-format off
+#include <windows.h>
+#include <psapi.h>
+// clang-format on
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+std::atomic<std::uint64_t> allocations{0};
+
+void count_allocation()
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// flecs
+ecs_os_api_malloc_t flecs_malloc{nullptr};
+ecs_os_api_calloc_t flecs_calloc{nullptr};
+ecs_os_api_realloc_t flecs_realloc{nullptr};
+
+void *counting_flecs_malloc(const ecs_size_t size)
+{
+    count_allocation();
+    return flecs_malloc(size);
+}
+
+void *counting_flecs_calloc(const ecs_size_t size)
+{
+    count_allocation();
+    return flecs_calloc(size);
+}
+
+void *counting_flecs_realloc(void *block, const ecs_size_t size)
+{
+    count_allocation();
+    return flecs_realloc(block, size);
+}
+
+// Jolt
+#ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
+JPH::AllocateFunction jolt_allocate{nullptr};
+JPH::AlignedAllocateFunction jolt_aligned_allocate{nullptr};
+
+void *counting_jolt_allocate(const std::size_t size)
+{
+    count_allocation();
+    return jolt_allocate(size);
+}
+
+void *counting_jolt_aligned_allocate(const std::size_t size,
+                                     const std::size_t alignment)
+{
+    count_allocation();
+    return jolt_aligned_allocate(size, alignment);
+}
+#endif
+} // namespace
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// Replacing these two is enough: the array, nothrow and sized forms all
+// forward to them by default
+void *operator new(const std::size_t size)
+{
+    count_allocation();
+    void *block{std::malloc(size == 0 ? 1 : size)};
+    if (block == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+    return block;
+}
+
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+#endif
+
+void install_flecs_allocation_hooks()
+{
+    ecs_os_set_api_defaults();
+    ecs_os_api_t os_api{ecs_os_api};
+    flecs_malloc = os_api.malloc_;
+    flecs_calloc = os_api.calloc_;
+    flecs_realloc = os_api.realloc_;
+    os_api.malloc_ = counting_flecs_malloc;
+    os_api.calloc_ = counting_flecs_calloc;
+    os_api.realloc_ = counting_flecs_realloc;
+    ecs_os_set_api(&os_api);
+}
+
+void install_jolt_allocation_hooks()
+{
+#ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
+    // The allocator outlives any one engine now, so the hooks may already be
+    // in place
+    if (JPH::Allocate == counting_jolt_allocate)
+    {
+        return;
+    }
+    jolt_allocate = JPH::Allocate;
+    jolt_aligned_allocate = JPH::AlignedAllocate;
+    JPH::Allocate = counting_jolt_allocate;
+    JPH::AlignedAllocate = counting_jolt_aligned_allocate;
+#endif
+}
+
+std::uint64_t allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+bool counts_operator_new()
+{
+#ifdef COUNT_HEAP_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::size_t peak_resident_bytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ==
+        0)
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    // bytes on macOS
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    // kilobytes on Linux
+    constexpr std::size_t kKilobyte{1'024};
+    return static_cast<std::size_t>(usage.ru_maxrss) * kKilobyte;
+#endif
+#endif
+}
@@ -0,0 +1,27 @@
+#ifndef SRC_ALLOCATION_STATS_H
+#define SRC_ALLOCATION_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide heap allocation counter. flecs and Jolt allocate through their
+// own hooks, which have to be installed before they are used. Global operator
+// new is only replaced, and counted, in builds configured with
+// COUNT_HEAP_ALLOCATIONS, so the shipping executable keeps the standard one.
+
+// Call before the first flecs world is created
+void install_flecs_allocation_hooks();
+
+// Call after the first PhysicsEngine::initialise, which registers Jolt's
+// default allocator through JoltRuntime
+void install_jolt_allocation_hooks();
+
+[[nodiscard]] std::uint64_t allocation_count();
+
+// Whether allocation_count includes global operator new
+[[nodiscard]] bool counts_operator_new();
+
+// Peak resident set size of the process, 0 where it is not supported
+[[nodiscard]] std::size_t peak_resident_bytes();
+
+#endif
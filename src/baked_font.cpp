@@ -0,0 +1,70 @@
+#include "baked_font.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+bool load_baked_font(Font &font)
+{
+    BakedFontHeader header{};
+    if (kBakedFontDataSize < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, kBakedFontData, sizeof(header));
+    if (header._magic != kBakedFontMagic ||
+        header._version != kBakedFontVersion || header._glyph_count <= 0)
+    {
+        return false;
+    }
+
+    const auto glyph_count{static_cast<std::size_t>(header._glyph_count)};
+    const std::size_t glyphs_offset{sizeof(header)};
+    const std::size_t pixels_offset{glyphs_offset +
+                                    glyph_count * sizeof(BakedGlyph)};
+    const auto pixel_bytes{static_cast<std::size_t>(
+        GetPixelDataSize(header._atlas_width,
+                         header._atlas_height,
+                         header._atlas_format))};
+    if (kBakedFontDataSize != pixels_offset + pixel_bytes)
+    {
+        return false;
+    }
+
+    // UnloadFont frees these with raylib's allocator, which also zeroes them
+    Font baked{};
+    baked.baseSize = header._base_size;
+    baked.glyphCount = header._glyph_count;
+    baked.glyphPadding = header._glyph_padding;
+    baked.recs = static_cast<Rectangle *>(
+        MemAlloc(static_cast<unsigned int>(glyph_count * sizeof(Rectangle))));
+    baked.glyphs = static_cast<GlyphInfo *>(
+        MemAlloc(static_cast<unsigned int>(glyph_count * sizeof(GlyphInfo))));
+    for (std::size_t index{0}; index < glyph_count; ++index)
+    {
+        BakedGlyph glyph{};
+        std::memcpy(&glyph,
+                    kBakedFontData + glyphs_offset + index * sizeof(glyph),
+                    sizeof(glyph));
+        baked.glyphs[index].value = glyph._value;
+        baked.glyphs[index].offsetX = glyph._offset_x;
+        baked.glyphs[index].offsetY = glyph._offset_y;
+        baked.glyphs[index].advanceX = glyph._advance_x;
+        baked.recs[index] = glyph._atlas_rectangle;
+    }
+
+    // LoadTextureFromImage only reads the pixels, but wants them mutable
+    std::vector<unsigned char> pixels(kBakedFontData + pixels_offset,
+                                      kBakedFontData + kBakedFontDataSize);
+    const Image atlas{pixels.data(),
+                      header._atlas_width,
+                      header._atlas_height,
+                      1,
+                      header._atlas_format};
+    baked.texture = LoadTextureFromImage(atlas);
+
+    font = baked;
+    return true;
+}
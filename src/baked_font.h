@@ -0,0 +1,54 @@
+#ifndef SRC_BAKED_FONT_H
+#define SRC_BAKED_FONT_H
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// The scene text font is rasterised at build time by tools/bake_font.cpp and
+// linked in as one blob: a BakedFontHeader, one BakedGlyph per glyph, then
+// the atlas pixels. The blob is only ever read by the build that wrote it, so
+// it uses the native layout.
+
+// Same parameters raylib's LoadFont uses for a TTF
+inline constexpr int kBakedFontBaseSize{32};
+inline constexpr int kBakedFontFirstCodepoint{32};
+inline constexpr int kBakedFontGlyphCount{95};
+inline constexpr int kBakedFontGlyphPadding{4};
+
+inline constexpr std::uint32_t kBakedFontMagic{0x544E4642}; // "BFNT"
+inline constexpr std::uint32_t kBakedFontVersion{1};
+
+struct BakedFontHeader
+{
+    std::uint32_t _magic{kBakedFontMagic};
+    std::uint32_t _version{kBakedFontVersion};
+    std::int32_t _base_size{0};
+    std::int32_t _glyph_count{0};
+    std::int32_t _glyph_padding{0};
+    std::int32_t _atlas_width{0};
+    std::int32_t _atlas_height{0};
+    std::int32_t _atlas_format{0};
+};
+
+struct BakedGlyph
+{
+    std::int32_t _value{0};
+    std::int32_t _offset_x{0};
+    std::int32_t _offset_y{0};
+    std::int32_t _advance_x{0};
+    Rectangle _atlas_rectangle{0.F, 0.F, 0.F, 0.F};
+};
+
+// Defined in the source file generated at build time
+extern const unsigned char kBakedFontData[];
+extern const std::size_t kBakedFontDataSize;
+
+// Uploads the embedded atlas, so it needs a GL context. Returns false, leaving
+// font untouched, if the blob does not match this build; fall back to
+// LoadFont then. Glyph images are left empty, which only matters to
+// ImageDrawText. Release with UnloadFont as usual.
+bool load_baked_font(Font &font);
+
+#endif
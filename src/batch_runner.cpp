@@ -0,0 +1,247 @@
+#include "batch_runner.h"
+
+#include "components.h"
+#include "constants.h"
+#include "physics.h"
+#include "systems.h"
+#include "transform_snapshot.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/flecs.hpp>
+#include <flecs/addons/cpp/world.hpp>
+#include <raylib.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr int kSpheresPerWorld{200};
+
+// Creating and destroying a flecs world initialises and releases the shared
+// OS API, which is not thread safe
+std::mutex world_lifetime_mutex;
+
+// Drop a random cloud of spheres onto the floor and see where they end up.
+// Every world gets its own seed, so the outcome only depends on the seed.
+BatchWorldResult run_world(const std::uint32_t seed, const int ticks)
+{
+    std::unique_ptr<flecs::world> world;
+    {
+        const std::lock_guard<std::mutex> lock{world_lifetime_mutex};
+        world = std::make_unique<flecs::world>();
+    }
+    spawn_floor_system(*world);
+
+    std::mt19937 random{seed};
+    std::uniform_real_distribution<float> horizontal{-4.F, 4.F};
+    std::uniform_real_distribution<float> height{2.F, 12.F};
+    std::uniform_real_distribution<float> speed{-3.F, 3.F};
+    for (int sphere{0}; sphere < kSpheresPerWorld; ++sphere)
+    {
+        // evaluated in order so the cloud is the same on every compiler
+        const float x{horizontal(random)};
+        const float y{height(random)};
+        const float z{horizontal(random)};
+        const float velocity_x{speed(random)};
+        const float velocity_z{speed(random)};
+        world->entity()
+            .set<Position>(Position{Vector3{x, y, z}})
+            .set<SphereCollider>(SphereCollider{constants::kBallRadius})
+            .set<Velocity>(Velocity{Vector3{velocity_x, 0.F, velocity_z}})
+            .add<RigidBodyTransform>();
+    }
+
+    // The batch already keeps every core busy, so each engine steps on the
+    // thread that owns it
+    PhysicsCapacity capacity{};
+    capacity._temp_allocator_bytes = 4 * 1'024 * 1'024;
+    capacity._job_threads = 0;
+    PhysicsEngine physics_engine{};
+    physics_engine.initialise(capacity);
+    create_entity_colliders_system(*world, physics_engine);
+    physics_engine.start_simulation();
+
+    const float frame_time{1.F / static_cast<float>(constants::kTickrate)};
+    TransformSnapshot snapshot{};
+    SnapshotSyncStats sync_stats{};
+    for (int tick{0}; tick < ticks; ++tick)
+    {
+        physics_engine.step(frame_time);
+    }
+    physics_engine.read_transforms(snapshot);
+    apply_transform_snapshot_system(*world, snapshot, sync_stats);
+
+    BatchWorldResult result{};
+    result._seed = seed;
+    float total_height{0.F};
+    world->each([&result, &total_height](const SphereCollider & /* collider */,
+                                         const Position &position) {
+        total_height += position._centre.y;
+        if (position._centre.y > 0.F)
+        {
+            ++result._spheres_on_floor;
+        }
+    });
+    result._mean_height = total_height / static_cast<float>(kSpheresPerWorld);
+
+    physics_engine.cleanup();
+    {
+        const std::lock_guard<std::mutex> lock{world_lifetime_mutex};
+        world.reset();
+    }
+    return result;
+}
+
+// Run every world once, handing them out to threads as they become free
+std::vector<BatchWorldResult> run_worlds(const int worlds,
+                                         const int ticks,
+                                         const int thread_count)
+{
+    std::vector<BatchWorldResult> results(static_cast<std::size_t>(worlds));
+    std::atomic<int> next_world{0};
+    const auto run_worlds_on_thread{[&]() {
+        for (int world{next_world++}; world < worlds; world = next_world++)
+        {
+            results[static_cast<std::size_t>(world)] =
+                run_world(static_cast<std::uint32_t>(world), ticks);
+        }
+    }};
+
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<std::size_t>(thread_count));
+    for (int thread{0}; thread < thread_count; ++thread)
+    {
+        threads.emplace_back(run_worlds_on_thread);
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    return results;
+}
+
+bool same_outcomes(const std::vector<BatchWorldResult> &lhs,
+                   const std::vector<BatchWorldResult> &rhs)
+{
+    return std::equal(lhs.begin(),
+                      lhs.end(),
+                      rhs.begin(),
+                      rhs.end(),
+                      [](const BatchWorldResult &left,
+                         const BatchWorldResult &right) {
+                          return left._seed == right._seed &&
+                                 left._mean_height == right._mean_height &&
+                                 left._spheres_on_floor ==
+                                     right._spheres_on_floor;
+                      });
+}
+
+void log_outcomes(const std::vector<BatchWorldResult> &results)
+{
+    const auto [lowest, highest]{std::minmax_element(
+        results.begin(),
+        results.end(),
+        [](const BatchWorldResult &lhs, const BatchWorldResult &rhs) {
+            return lhs._spheres_on_floor < rhs._spheres_on_floor;
+        })};
+    double total_on_floor{0.0};
+    double total_height{0.0};
+    for (const BatchWorldResult &result : results)
+    {
+        total_on_floor += result._spheres_on_floor;
+        total_height += result._mean_height;
+    }
+    const auto count{static_cast<double>(results.size())};
+    spdlog::info("Spheres left on the floor: mean {:.1f} of {}, fewest {} "
+                 "(seed {}), most {} (seed {}); mean height {:.3f}",
+                 total_on_floor / count,
+                 kSpheresPerWorld,
+                 lowest->_spheres_on_floor,
+                 lowest->_seed,
+                 highest->_spheres_on_floor,
+                 highest->_seed,
+                 total_height / count);
+}
+} // namespace
+
+int run_batch(const int worlds, const int ticks)
+{
+    const int cores{
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+    std::vector<int> thread_counts;
+    for (int threads{1}; threads < std::min(cores, worlds); threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(std::min(cores, worlds));
+
+    spdlog::info("Running {} worlds of {} spheres for {} ticks on up to {} "
+                 "threads",
+                 worlds,
+                 kSpheresPerWorld,
+                 ticks,
+                 thread_counts.back());
+
+    // contact and activation logging would dominate the step times
+    spdlog::set_level(spdlog::level::warn);
+    struct Run
+    {
+        int _threads{0};
+        double _seconds{0.0};
+    };
+    std::vector<Run> runs;
+    std::vector<BatchWorldResult> first_results;
+    bool deterministic{true};
+    for (const int threads : thread_counts)
+    {
+        const auto start{std::chrono::steady_clock::now()};
+        const std::vector<BatchWorldResult> results{
+            run_worlds(worlds, ticks, threads)};
+        runs.push_back(
+            {threads,
+             std::chrono::duration<double>{std::chrono::steady_clock::now() -
+                                           start}
+                 .count()});
+        if (first_results.empty())
+        {
+            first_results = results;
+        }
+        else
+        {
+            deterministic = deterministic && same_outcomes(first_results, results);
+        }
+    }
+    spdlog::set_level(spdlog::level::info);
+
+    const double world_ticks{static_cast<double>(worlds) *
+                             static_cast<double>(ticks)};
+    for (const Run &run : runs)
+    {
+        const double speedup{runs.front()._seconds / run._seconds};
+        spdlog::info("{:>3} threads: {:.2f} s, {:.0f} world ticks/s, "
+                     "{:.2f}x speedup, {:.0f}% efficiency",
+                     run._threads,
+                     run._seconds,
+                     world_ticks / run._seconds,
+                     speedup,
+                     100.0 * speedup / run._threads);
+    }
+    log_outcomes(first_results);
+    if (!deterministic)
+    {
+        spdlog::warn("Outcomes changed with the thread count, a world is "
+                     "sharing state it should not");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef SRC_BATCH_RUNNER_H
+#define SRC_BATCH_RUNNER_H
+
+#include <cstdint>
+
+// Outcome of one independent simulation in a batch
+struct BatchWorldResult
+{
+    std::uint32_t _seed{0};
+    float _mean_height{0.F}; // of the spheres after the last tick
+    int _spheres_on_floor{0};
+};
+
+// Run a Monte Carlo batch of independent worlds, each with its own flecs world
+// and PhysicsEngine, spread over 1, 2, 4... up to every core in turn. Logs the
+// aggregate world ticks per second at each thread count, how that scales
+// against one thread, and the spread of the outcomes.
+int run_batch(int worlds, int ticks);
+
+#endif
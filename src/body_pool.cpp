@@ -0,0 +1,54 @@
+#include "body_pool.h"
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+#include <Jolt/Physics/Body/BodyID.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+
+#include <vector>
+
+bool BodyPool::acquire(const JPH::Shape *shape, JPH::BodyID &body_id)
+{
+    const auto free_bodies{_free_bodies.find(shape)};
+    if (free_bodies == _free_bodies.end() || free_bodies->second.empty())
+    {
+        return false;
+    }
+    body_id = free_bodies->second.back();
+    free_bodies->second.pop_back();
+    ++_stats._reused;
+    --_stats._pooled;
+    return true;
+}
+
+void BodyPool::release(const JPH::Shape *shape, const JPH::BodyID &body_id)
+{
+    _free_bodies[shape].push_back(body_id);
+    ++_stats._released;
+    ++_stats._pooled;
+}
+
+void BodyPool::count_created()
+{
+    ++_stats._created;
+}
+
+std::vector<JPH::BodyID> BodyPool::drain()
+{
+    std::vector<JPH::BodyID> body_ids;
+    body_ids.reserve(_stats._pooled);
+    for (auto &[shape, free_bodies] : _free_bodies)
+    {
+        body_ids.insert(body_ids.end(), free_bodies.begin(), free_bodies.end());
+    }
+    _free_bodies.clear();
+    _stats._pooled = 0;
+    return body_ids;
+}
+
+const BodyPoolStats &BodyPool::stats() const
+{
+    return _stats;
+}
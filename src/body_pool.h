@@ -0,0 +1,51 @@
+#ifndef SRC_BODY_POOL_H
+#define SRC_BODY_POOL_H
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+#include <Jolt/Physics/Body/BodyID.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct BodyPoolStats
+{
+    std::uint64_t _reused{0};
+    std::uint64_t _created{0};
+    std::uint64_t _released{0};
+    std::size_t _pooled{0};
+};
+
+// Bodies that were removed from the physics system but not destroyed, grouped
+// by shape. Shapes come from the ShapeCache, so identical colliders share a
+// shape pointer and therefore a free list.
+class BodyPool
+{
+public:
+    BodyPool() = default;
+
+    // mutator methods
+
+    // Take a pooled body using shape, if there is one
+    bool acquire(const JPH::Shape *shape, JPH::BodyID &body_id);
+    void release(const JPH::Shape *shape, const JPH::BodyID &body_id);
+    void count_created();
+
+    // Empty the pool, returning every pooled body so it can be destroyed
+    std::vector<JPH::BodyID> drain();
+
+    // accessor methods
+    [[nodiscard]] const BodyPoolStats &stats() const;
+
+private:
+    std::unordered_map<const JPH::Shape *, std::vector<JPH::BodyID>>
+        _free_bodies{};
+    BodyPoolStats _stats{};
+};
+
+#endif
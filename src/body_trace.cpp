@@ -0,0 +1,493 @@
+#include "body_trace.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+struct BodyTraceFileHeader
+{
+    std::uint32_t _magic{kBodyTraceMagic};
+    std::uint32_t _version{kBodyTraceVersion};
+};
+
+struct BodyTraceBlockHeader
+{
+    std::uint32_t _payload_bytes{0};
+    std::uint32_t _bodies{0};
+    std::uint64_t _step{0};
+    float _delta_time{0.F};
+    std::uint32_t _reserved{0};
+};
+
+// Uncompressed size of one body, for the compression ratio
+constexpr std::size_t kRawBodyBytes{sizeof(std::uint64_t) +
+                                    6 * sizeof(float) + sizeof(std::uint8_t) +
+                                    sizeof(std::uint16_t)};
+
+void put_varint(std::vector<std::uint8_t> &block, std::uint64_t value)
+{
+    constexpr std::uint64_t kContinuation{0x80};
+    while (value >= kContinuation)
+    {
+        block.push_back(static_cast<std::uint8_t>(value | kContinuation));
+        value >>= 7U;
+    }
+    block.push_back(static_cast<std::uint8_t>(value));
+}
+
+bool get_varint(const std::uint8_t *&cursor,
+                const std::uint8_t *end,
+                std::uint64_t &value)
+{
+    constexpr std::uint8_t kContinuation{0x80};
+    constexpr std::uint8_t kPayload{0x7F};
+    value = 0;
+    for (unsigned shift{0}; shift < 64 && cursor != end; shift += 7)
+    {
+        const std::uint8_t byte{*cursor++};
+        value |= static_cast<std::uint64_t>(byte & kPayload) << shift;
+        if ((byte & kContinuation) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint64_t zigzag(const std::uint64_t delta)
+{
+    const auto signed_delta{static_cast<std::int64_t>(delta)};
+    return (delta << 1U) ^ static_cast<std::uint64_t>(signed_delta >> 63);
+}
+
+std::uint64_t unzigzag(const std::uint64_t value)
+{
+    return (value >> 1U) ^ (~(value & 1U) + 1U);
+}
+
+std::uint32_t float_bits(const float value)
+{
+    std::uint32_t bits{0};
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bits_float(const std::uint32_t bits)
+{
+    float value{0.F};
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Floats are XORed with the same body on the previous step, which is the
+// body at the same index unless bodies were added or removed
+bool same_body(const BodyTraceColumns &previous,
+               const BodyTraceColumns &columns,
+               const std::size_t index)
+{
+    return index < previous.size() &&
+           previous._entities[index] == columns._entities[index];
+}
+
+void encode(const BodyTraceColumns &columns,
+            const BodyTraceColumns &previous,
+            std::vector<std::uint8_t> &block)
+{
+    const std::size_t bodies{columns.size()};
+    block.clear();
+
+    std::uint64_t previous_entity{0};
+    for (const std::uint64_t entity : columns._entities)
+    {
+        put_varint(block, zigzag(entity - previous_entity));
+        previous_entity = entity;
+    }
+
+    const auto encode_floats{[&](const std::vector<float> &column,
+                                 const std::vector<float> &previous_column) {
+        for (std::size_t index{0}; index < bodies; ++index)
+        {
+            const std::uint32_t reference{
+                same_body(previous, columns, index)
+                    ? float_bits(previous_column[index])
+                    : 0U};
+            put_varint(block, float_bits(column[index]) ^ reference);
+        }
+    }};
+    for (std::size_t axis{0}; axis < 3; ++axis)
+    {
+        encode_floats(columns._position[axis], previous._position[axis]);
+    }
+    for (std::size_t axis{0}; axis < 3; ++axis)
+    {
+        encode_floats(columns._velocity[axis], previous._velocity[axis]);
+    }
+
+    for (std::size_t first{0}; first < bodies; first += 8)
+    {
+        std::uint8_t bits{0};
+        for (std::size_t bit{0}; bit < 8 && first + bit < bodies; ++bit)
+        {
+            if (columns._sleeping[first + bit] != 0)
+            {
+                bits = static_cast<std::uint8_t>(bits | (1U << bit));
+            }
+        }
+        block.push_back(bits);
+    }
+
+    for (const std::uint16_t contacts : columns._contacts)
+    {
+        put_varint(block, contacts);
+    }
+}
+
+bool decode(const std::vector<std::uint8_t> &block,
+            const BodyTraceColumns &previous,
+            BodyTraceColumns &columns)
+{
+    const std::size_t bodies{columns.size()};
+    const std::uint8_t *cursor{block.data()};
+    const std::uint8_t *end{block.data() + block.size()};
+    std::uint64_t value{0};
+
+    std::uint64_t previous_entity{0};
+    for (std::uint64_t &entity : columns._entities)
+    {
+        if (!get_varint(cursor, end, value))
+        {
+            return false;
+        }
+        entity = previous_entity + unzigzag(value);
+        previous_entity = entity;
+    }
+
+    const auto decode_floats{[&](std::vector<float> &column,
+                                 const std::vector<float> &previous_column) {
+        for (std::size_t index{0}; index < bodies; ++index)
+        {
+            if (!get_varint(cursor, end, value))
+            {
+                return false;
+            }
+            const std::uint32_t reference{
+                same_body(previous, columns, index)
+                    ? float_bits(previous_column[index])
+                    : 0U};
+            column[index] =
+                bits_float(static_cast<std::uint32_t>(value) ^ reference);
+        }
+        return true;
+    }};
+    for (std::size_t axis{0}; axis < 3; ++axis)
+    {
+        if (!decode_floats(columns._position[axis], previous._position[axis]))
+        {
+            return false;
+        }
+    }
+    for (std::size_t axis{0}; axis < 3; ++axis)
+    {
+        if (!decode_floats(columns._velocity[axis], previous._velocity[axis]))
+        {
+            return false;
+        }
+    }
+
+    for (std::size_t first{0}; first < bodies; first += 8)
+    {
+        if (cursor == end)
+        {
+            return false;
+        }
+        const std::uint8_t bits{*cursor++};
+        for (std::size_t bit{0}; bit < 8 && first + bit < bodies; ++bit)
+        {
+            columns._sleeping[first + bit] =
+                static_cast<std::uint8_t>((bits >> bit) & 1U);
+        }
+    }
+
+    for (std::uint16_t &contacts : columns._contacts)
+    {
+        if (!get_varint(cursor, end, value))
+        {
+            return false;
+        }
+        contacts = static_cast<std::uint16_t>(value);
+    }
+    return cursor == end;
+}
+} // namespace
+
+void BodyTraceColumns::resize(const std::size_t bodies)
+{
+    _entities.resize(bodies);
+    for (std::vector<float> &column : _position)
+    {
+        column.resize(bodies);
+    }
+    for (std::vector<float> &column : _velocity)
+    {
+        column.resize(bodies);
+    }
+    _sleeping.resize(bodies);
+    _contacts.resize(bodies);
+}
+
+std::size_t BodyTraceColumns::size() const
+{
+    return _entities.size();
+}
+
+BodyContactCounter::BodyContactCounter(const std::size_t max_bodies)
+    : _counts{std::make_unique<std::atomic<std::uint16_t>[]>(max_bodies)},
+      _size{max_bodies}
+{
+}
+
+void BodyContactCounter::add(const std::uint32_t body_index)
+{
+    if (body_index < _size)
+    {
+        _counts[body_index].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::uint16_t BodyContactCounter::take(const std::uint32_t body_index)
+{
+    return body_index < _size
+               ? _counts[body_index].exchange(0, std::memory_order_relaxed)
+               : std::uint16_t{0};
+}
+
+BodyTraceWriter::~BodyTraceWriter()
+{
+    close();
+}
+
+bool BodyTraceWriter::open(const std::string &path)
+{
+    close();
+    _output.open(path, std::ios::binary | std::ios::trunc);
+    if (!_output)
+    {
+        return false;
+    }
+    const BodyTraceFileHeader header{};
+    _output.write(reinterpret_cast<const char *>(&header), // NOLINT
+                  sizeof(header));
+    if (!_output.good())
+    {
+        _output.close();
+        return false;
+    }
+    _previous = BodyTraceColumns{};
+    _queued.reserve(kMaxQueuedSteps);
+    _writing.reserve(kMaxQueuedSteps);
+    _closing = false;
+    _failed.store(false, std::memory_order_relaxed);
+    _steps.store(0, std::memory_order_relaxed);
+    _dropped_steps.store(0, std::memory_order_relaxed);
+    _raw_bytes.store(sizeof(header), std::memory_order_relaxed);
+    _written_bytes.store(sizeof(header), std::memory_order_relaxed);
+    _thread = std::thread{&BodyTraceWriter::run, this};
+    return true;
+}
+
+void BodyTraceWriter::write(const BodyTraceColumns &columns)
+{
+    {
+        const std::lock_guard<std::mutex> lock{_mutex};
+        if (_queued.size() >= kMaxQueuedSteps ||
+            _failed.load(std::memory_order_relaxed))
+        {
+            _dropped_steps.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (_spare.empty())
+        {
+            _queued.push_back(columns);
+        }
+        else
+        {
+            // copy assignment keeps the spare's capacity
+            _queued.push_back(std::move(_spare.back()));
+            _spare.pop_back();
+            _queued.back() = columns;
+        }
+    }
+    _queued_changed.notify_one();
+}
+
+bool BodyTraceWriter::close()
+{
+    if (!_thread.joinable())
+    {
+        return !_failed.load(std::memory_order_relaxed);
+    }
+    {
+        const std::lock_guard<std::mutex> lock{_mutex};
+        _closing = true;
+    }
+    _queued_changed.notify_one();
+    _thread.join();
+    _output.close();
+    if (_output.fail())
+    {
+        _failed.store(true, std::memory_order_relaxed);
+    }
+    return !_failed.load(std::memory_order_relaxed);
+}
+
+void BodyTraceWriter::run()
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    while (true)
+    {
+        _queued_changed.wait(lock,
+                             [this]() { return !_queued.empty() || _closing; });
+        if (_queued.empty())
+        {
+            return;
+        }
+        _writing.swap(_queued);
+        lock.unlock();
+        for (const BodyTraceColumns &columns : _writing)
+        {
+            write_step(columns);
+        }
+        lock.lock();
+        for (BodyTraceColumns &columns : _writing)
+        {
+            _spare.push_back(std::move(columns));
+        }
+        _writing.clear();
+    }
+}
+
+void BodyTraceWriter::write_step(const BodyTraceColumns &columns)
+{
+    // the rest of the trace could not be decoded without this step
+    if (_failed.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    encode(columns, _previous, _block);
+
+    BodyTraceBlockHeader header{};
+    header._payload_bytes = static_cast<std::uint32_t>(_block.size());
+    header._bodies = static_cast<std::uint32_t>(columns.size());
+    header._step = columns._step;
+    header._delta_time = columns._delta_time;
+    _output.write(reinterpret_cast<const char *>(&header), // NOLINT
+                  sizeof(header));
+    _output.write(reinterpret_cast<const char *>(_block.data()), // NOLINT
+                  static_cast<std::streamsize>(_block.size()));
+    if (!_output.good())
+    {
+        _failed.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    // copy assignment keeps the capacity, so this stops allocating once the
+    // body count settles
+    _previous = columns;
+    _steps.fetch_add(1, std::memory_order_relaxed);
+    _raw_bytes.fetch_add(sizeof(header) + columns.size() * kRawBodyBytes,
+                         std::memory_order_relaxed);
+    _written_bytes.fetch_add(sizeof(header) + _block.size(),
+                             std::memory_order_relaxed);
+}
+
+bool BodyTraceWriter::is_open() const
+{
+    return _output.is_open();
+}
+
+bool BodyTraceWriter::failed() const
+{
+    return _failed.load(std::memory_order_relaxed);
+}
+
+std::uint64_t BodyTraceWriter::steps() const
+{
+    return _steps.load(std::memory_order_relaxed);
+}
+
+std::uint64_t BodyTraceWriter::dropped_steps() const
+{
+    return _dropped_steps.load(std::memory_order_relaxed);
+}
+
+std::uint64_t BodyTraceWriter::raw_bytes() const
+{
+    return _raw_bytes.load(std::memory_order_relaxed);
+}
+
+std::uint64_t BodyTraceWriter::written_bytes() const
+{
+    return _written_bytes.load(std::memory_order_relaxed);
+}
+
+bool BodyTraceReader::open(const std::string &path)
+{
+    _input.open(path, std::ios::binary);
+    BodyTraceFileHeader header{};
+    _input.read(reinterpret_cast<char *>(&header), // NOLINT
+                sizeof(header));
+    _failed = !_input || header._magic != kBodyTraceMagic ||
+              header._version != kBodyTraceVersion;
+    _previous = BodyTraceColumns{};
+    return !_failed;
+}
+
+bool BodyTraceReader::read(BodyTraceColumns &columns)
+{
+    if (_failed)
+    {
+        return false;
+    }
+    BodyTraceBlockHeader header{};
+    _input.read(reinterpret_cast<char *>(&header), // NOLINT
+                sizeof(header));
+    if (_input.gcount() == 0 && _input.eof())
+    {
+        return false;
+    }
+    if (!_input)
+    {
+        _failed = true;
+        return false;
+    }
+    _block.resize(header._payload_bytes);
+    _input.read(reinterpret_cast<char *>(_block.data()), // NOLINT
+                static_cast<std::streamsize>(_block.size()));
+    columns._step = header._step;
+    columns._delta_time = header._delta_time;
+    columns.resize(header._bodies);
+    if (!_input || !decode(_block, _previous, columns))
+    {
+        _failed = true;
+        return false;
+    }
+    _previous = columns;
+    return true;
+}
+
+bool BodyTraceReader::failed() const
+{
+    return _failed;
+}
@@ -0,0 +1,142 @@
+#ifndef SRC_BODY_TRACE_H
+#define SRC_BODY_TRACE_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A body trace is a file header followed by one compressed block per physics
+// step. Each block holds the dynamic bodies as columns: entity IDs as varint
+// deltas, positions and velocities one axis per column as varints of the
+// float bits XOR the same body's value on the previous step, sleeping flags
+// as a bit set and contact counts as varints. Resting bodies cost about a
+// byte per column, and a reader only ever needs the previous step in memory.
+
+inline constexpr std::uint32_t kBodyTraceMagic{0x43525442}; // "BTRC"
+inline constexpr std::uint32_t kBodyTraceVersion{1};
+
+// State of every dynamic body after one step, one vector per column
+struct BodyTraceColumns
+{
+    std::uint64_t _step{0};
+    float _delta_time{0.F};
+    std::vector<std::uint64_t> _entities{};
+    std::array<std::vector<float>, 3> _position{};
+    std::array<std::vector<float>, 3> _velocity{};
+    std::vector<std::uint8_t> _sleeping{};
+    std::vector<std::uint16_t> _contacts{};
+
+    void resize(std::size_t bodies);
+    [[nodiscard]] std::size_t size() const;
+};
+
+// Contacts per body index over one step. Jolt reports contacts from its job
+// threads, so the counts are atomic. Sleeping bodies report no contacts.
+class BodyContactCounter
+{
+public:
+    explicit BodyContactCounter(std::size_t max_bodies);
+
+    // mutator methods
+    void add(std::uint32_t body_index);
+    // Read a body's count and reset it for the next step
+    std::uint16_t take(std::uint32_t body_index);
+
+private:
+    std::unique_ptr<std::atomic<std::uint16_t>[]> _counts;
+    std::size_t _size;
+};
+
+// Appends steps to a trace file as they happen. write only copies the step
+// into a queue; a writer thread encodes and writes it, so the thread stepping
+// the simulation never waits on the disk. The counts cover the steps written
+// so far and are final once close returns.
+class BodyTraceWriter
+{
+public:
+    BodyTraceWriter() = default;
+    ~BodyTraceWriter();
+    BodyTraceWriter(const BodyTraceWriter &) = delete;
+    BodyTraceWriter &operator=(const BodyTraceWriter &) = delete;
+    BodyTraceWriter(BodyTraceWriter &&) = delete;
+    BodyTraceWriter &operator=(BodyTraceWriter &&) = delete;
+
+    // mutator methods
+    // Returns false if the file or its header could not be written
+    bool open(const std::string &path);
+    // Queue a step. Steps are dropped, and counted, while the writer thread
+    // is kMaxQueuedSteps behind or after a write has failed.
+    void write(const BodyTraceColumns &columns);
+    // Write every queued step and close the file. Returns false if any
+    // write failed.
+    bool close();
+
+    // accessor methods
+    [[nodiscard]] bool is_open() const;
+    // A write failed; the trace stops there
+    [[nodiscard]] bool failed() const;
+    [[nodiscard]] std::uint64_t steps() const;
+    [[nodiscard]] std::uint64_t dropped_steps() const;
+    [[nodiscard]] std::uint64_t raw_bytes() const;
+    [[nodiscard]] std::uint64_t written_bytes() const;
+
+    static constexpr std::size_t kMaxQueuedSteps{60};
+
+private:
+    void run();
+    void write_step(const BodyTraceColumns &columns);
+
+    std::ofstream _output{};
+    std::thread _thread{};
+
+    // shared with the writer thread, under _mutex. Written out buffers go
+    // back to _spare, so queueing stops allocating once the body count
+    // settles.
+    std::mutex _mutex{};
+    std::condition_variable _queued_changed{};
+    std::vector<BodyTraceColumns> _queued{};
+    std::vector<BodyTraceColumns> _spare{};
+    bool _closing{false};
+
+    // writer thread only
+    std::vector<BodyTraceColumns> _writing{};
+    std::vector<std::uint8_t> _block{};
+    BodyTraceColumns _previous{};
+
+    std::atomic<bool> _failed{false};
+    std::atomic<std::uint64_t> _steps{0};
+    std::atomic<std::uint64_t> _dropped_steps{0};
+    std::atomic<std::uint64_t> _raw_bytes{0};
+    std::atomic<std::uint64_t> _written_bytes{0};
+};
+
+// Reads a trace file one step at a time
+class BodyTraceReader
+{
+public:
+    BodyTraceReader() = default;
+
+    // mutator methods
+    bool open(const std::string &path);
+    // Returns false at the end of the file, or if a block is corrupt
+    bool read(BodyTraceColumns &columns);
+
+    // accessor methods
+    [[nodiscard]] bool failed() const;
+
+private:
+    std::ifstream _input{};
+    std::vector<std::uint8_t> _block{};
+    BodyTraceColumns _previous{};
+    bool _failed{false};
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SRC_COMMAND_LINE_H
+#define SRC_COMMAND_LINE_H
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// Read a whole command line argument as a number from minimum to maximum.
+// Returns false, leaving value as it was, for anything else: trailing junk,
+// a sign on an unsigned number, or a value out of range. atoi and strtof
+// would quietly read those as 0 or wrap them around.
+template <typename Number>
+[[nodiscard]] bool parse_number(const std::string_view argument,
+                                const Number minimum,
+                                const Number maximum,
+                                Number &value)
+{
+    Number parsed{};
+    if constexpr (std::is_floating_point_v<Number>)
+    {
+        // floating point from_chars is missing from some standard libraries
+        const std::string terminated{argument};
+        char *end{nullptr};
+        errno = 0;
+        parsed = static_cast<Number>(std::strtod(terminated.c_str(), &end));
+        if (terminated.empty() ||
+            end != terminated.c_str() + terminated.size() || errno == ERANGE ||
+            !std::isfinite(parsed))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        const char *const end{argument.data() + argument.size()};
+        const auto [last, error]{std::from_chars(argument.data(), end, parsed)};
+        if (error != std::errc{} || last != end)
+        {
+            return false;
+        }
+    }
+    if (parsed < minimum || parsed > maximum)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+#endif
@@ -2,9 +2,17 @@
 #define SRC_COMPONENTS_H
 
 #include "constants.h"
+#include "debug_draw.h"
+#include "history.h"
+#include "particles.h"
+#include "shape_type.h"
+#include "world_partition.h"
 
 #include <raylib.h>
 
+#include <array>
+#include <cstdint>
+
 struct GridComponent
 {
     GridComponent() = default;
@@ -28,6 +36,14 @@ struct SphereMesh
     float _radius;
 };
 
+// Detail level picked for a sphere from its size on screen, see sphere_lod.h
+struct SphereLod
+{
+    SphereLod() = default;
+
+    std::uint8_t _level{0};
+};
+
 struct Position
 {
     Position() = default;
@@ -66,6 +82,22 @@ struct Velocity
     Vector3 _value;
 };
 
+// Optional full rigid body state, laid out as four 16-byte lanes so the
+// physics sync copies each field with one SIMD load and store instead of
+// converting it a float at a time. The w lanes of the vectors are padding.
+// See rigid_body_transform.h for conversions back to raylib types.
+struct alignas(16) RigidBodyTransform
+{
+    RigidBodyTransform() = default;
+
+    Vector4 _position{0.F, 0.F, 0.F, 0.F};
+    Quaternion _rotation{0.F, 0.F, 0.F, 1.F};
+    Vector4 _linear_velocity{0.F, 0.F, 0.F, 0.F};
+    Vector4 _angular_velocity{0.F, 0.F, 0.F, 0.F};
+};
+static_assert(sizeof(RigidBodyTransform) == 64,
+              "RigidBodyTransform should be exactly four 16-byte lanes");
+
 struct BoxCollider
 {
     BoxCollider() = default;
@@ -87,6 +119,87 @@ struct SphereCollider
     float _radius;
 };
 
+// Jolt body backing an entity, as BodyID::GetIndexAndSequenceNumber(), and
+// the kind of shape it was made with
+struct PhysicsBody
+{
+    PhysicsBody() = default;
+    PhysicsBody(const std::uint32_t body_id, const ShapeType shape)
+        : _body_id(body_id), _shape(shape)
+    {
+    }
+
+    std::uint32_t _body_id;
+    ShapeType _shape{ShapeType::kSphere};
+};
+
+enum class SpatialQueryType : std::uint8_t
+{
+    kRadius,  // entities whose centre is within _range
+    kOverlap, // entities whose shape overlaps a sphere of radius _range
+    kRaycast, // closest entity along _direction, up to _range away
+};
+
+// Spatial question an entity asks from its Position every frame. Requests are
+// answered in one batch, see spatial_query.h, and the answer is written to
+// the entity's SpatialQueryHits.
+struct SpatialQuery
+{
+    SpatialQuery() = default;
+    SpatialQuery(const SpatialQueryType type, const float range)
+        : _type{type}, _range{range}
+    {
+    }
+
+    SpatialQueryType _type{SpatialQueryType::kRadius};
+    float _range{1.F};
+    Vector3 _direction{0.F, -1.F, 0.F}; // unit length, raycasts only
+};
+
+struct SpatialQueryHits
+{
+    SpatialQueryHits() = default;
+
+    std::array<std::uint64_t, constants::kMaxSpatialQueryHits> _entities{};
+    std::uint32_t _count{0};
+    bool _truncated{false}; // more hits than _entities holds
+    Vector3 _point{0.F, 0.F, 0.F}; // raycast hit point
+    float _distance{0.F};          // raycast hit distance
+};
+
+// Recent values of the chosen fields, one sample per physics snapshot
+// applied. Only the entity inspected in the Dev Panel gets one, see
+// track_history_system, so no other entity pays for recording.
+struct History
+{
+    History() = default;
+
+    std::array<HistoryRing, kHistoryFieldCount> _rings{};
+    std::uint32_t _fields{history_field_bit(HistoryField::kPositionY) |
+                          history_field_bit(HistoryField::kSpeed)};
+    int _window{10 * constants::kHistoryMinWindow}; // samples plotted
+};
+
+// Sprays particles upwards from the entity's Position while
+// ParticleSettings::_emitting is on. Particles are not entities, see
+// particles.h.
+struct ParticleEmitter
+{
+    ParticleEmitter() = default;
+    ParticleEmitter(const float rate, const Color &colour)
+        : _rate{rate}, _colour{colour}
+    {
+    }
+
+    float _rate{1'000.F};  // particles per second
+    float _speed{8.F};     // launch speed, metres per second
+    float _spread{0.5F};   // sideways speed as a fraction of _speed
+    float _lifetime{4.F};  // seconds, each particle lives half to all of it
+    Color _colour{ORANGE};
+    float _owed{0.F}; // fraction of a particle carried to the next frame
+    std::uint32_t _seed{1};
+};
+
 struct DevPanelState
 {
     DevPanelState() = default;
@@ -95,6 +208,13 @@ struct DevPanelState
     bool _paused{false};
     bool _step{
         false}; // signal that frame should only advance one frame, then pause
+    bool _render_direct{false}; // render debug view at its own resolution
+    std::uint64_t _selected_entity{0}; // entity picked in the viewport
+    std::uint64_t _inspected_entity{0}; // shown in the Dev Panel this frame
+    bool _record_history{false};        // keep a History of the inspected one
+    DebugDrawSettings _physics_debug{};
+    WorldPartitionSettings _partition{};
+    ParticleSettings _particles{};
 };
 
 #endif
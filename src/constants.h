@@ -4,6 +4,7 @@
 #include <raylib.h>
 
 #include <array>
+#include <cstddef>
 #include <string>
 
 namespace constants
@@ -13,6 +14,9 @@ inline constexpr int kWindowWidth{1366};
 inline constexpr int kWindowHeight{768};
 inline constexpr float kUIScaleFactor{1.5F};
 inline constexpr int kTickrate{60};
+inline constexpr int kGameplayTickrate{60};
+inline constexpr int kTelemetryTickrate{2};
+inline constexpr float kTickLoadWindowSeconds{1.F};
 inline constexpr int kTargetFramerate{60};
 inline constexpr float kCameraPositionX{0.F};
 inline constexpr float kCameraPositionY{10.F};
@@ -21,6 +25,8 @@ inline constexpr float kCameraFovY{45.F};
 inline constexpr float kBallRadius{0.5F};
 inline constexpr int kGridSlices{10};
 inline constexpr float kGridSpacing{1.F};
+inline constexpr float kGridLineWidth{0.02F};
+inline constexpr Color kStaticGeometryColour{225, 225, 225, 255};
 inline constexpr float kCubeSpeed{1.2F};
 inline constexpr float kCubePositionMinZ{-5.F};
 inline constexpr float kCubePositionMaxZ{5.F};
@@ -48,6 +54,23 @@ inline constexpr int kTextPositionY{40};
 inline constexpr int kTextFontSize{24};
 inline constexpr int kFPSPositionX{10};
 inline constexpr int kFPSPositionY{10};
+inline const std::string kCheckpointPath{"checkpoint.bin"};
+inline constexpr std::size_t kMaxSpatialQueryHits{16};
+inline constexpr float kGroundProbeRange{20.F};
+inline constexpr std::size_t kHistoryCapacity{4'096};
+inline constexpr std::size_t kHistoryPlotColumns{256};
+inline constexpr int kHistoryMinWindow{60};
+inline constexpr float kPartitionCellSize{16.F};
+inline constexpr int kPartitionLoadRadius{2};
+inline constexpr int kPartitionUnloadRadius{3};
+inline constexpr int kPartitionMaxRadius{16};
+inline constexpr float kPartitionLoadBudgetMilliseconds{1.F};
+inline constexpr int kPartitionSweepFrames{30};
+inline constexpr std::size_t kMaxParticles{1'048'576};
+inline constexpr std::size_t kMaxDrawnParticles{131'072};
+inline constexpr float kParticleBudgetMilliseconds{4.F};
+inline constexpr std::size_t kFlightRecorderCapacity{4'096};
+inline constexpr const char *kFlightRecordingPath{"flight_recording.bin"};
 } // namespace constants
 
 #endif
@@ -0,0 +1,161 @@
+#include "debug_draw.h"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+Vector3 transform_point(const Matrix &transform, const Vector3 &point)
+{
+    return Vector3{transform.m0 * point.x + transform.m4 * point.y +
+                       transform.m8 * point.z + transform.m12,
+                   transform.m1 * point.x + transform.m5 * point.y +
+                       transform.m9 * point.z + transform.m13,
+                   transform.m2 * point.x + transform.m6 * point.y +
+                       transform.m10 * point.z + transform.m14};
+}
+
+// Ignores translation. Only the sign of the dot product with the light is
+// used, so a uniform scale does not matter either.
+Vector3 transform_direction(const Matrix &transform, const Vector3 &direction)
+{
+    return Vector3{transform.m0 * direction.x + transform.m4 * direction.y +
+                       transform.m8 * direction.z,
+                   transform.m1 * direction.x + transform.m5 * direction.y +
+                       transform.m9 * direction.z,
+                   transform.m2 * direction.x + transform.m6 * direction.y +
+                       transform.m10 * direction.z};
+}
+
+Color tint_colour(const Color &colour, const Color &tint, const float brightness)
+{
+    constexpr float kChannelMax{255.F};
+    const auto channel{[brightness](const unsigned char value,
+                                    const unsigned char tint_value) {
+        return static_cast<unsigned char>(static_cast<float>(value) *
+                                          static_cast<float>(tint_value) /
+                                          kChannelMax * brightness);
+    }};
+    return Color{channel(colour.r, tint.r),
+                 channel(colour.g, tint.g),
+                 channel(colour.b, tint.b),
+                 static_cast<unsigned char>(static_cast<float>(colour.a) *
+                                            static_cast<float>(tint.a) /
+                                            kChannelMax)};
+}
+
+// Light from above and to one side, with enough ambient that faces turned
+// away still read
+float facing_brightness(const Vector3 &normal)
+{
+    constexpr Vector3 kLight{0.36F, 0.8F, 0.48F};
+    constexpr float kAmbient{0.45F};
+    const float length{std::sqrt(normal.x * normal.x + normal.y * normal.y +
+                                 normal.z * normal.z)};
+    if (length <= 0.F)
+    {
+        return 1.F;
+    }
+    const float facing{
+        (normal.x * kLight.x + normal.y * kLight.y + normal.z * kLight.z) /
+        length};
+    return kAmbient + (1.F - kAmbient) * std::max(facing, 0.F);
+}
+} // namespace
+
+void DebugVertexCollector::clear()
+{
+    _lines.clear();
+    _triangles.clear();
+    _meshes = 0;
+}
+
+void DebugVertexCollector::add_line(const Vector3 &from,
+                                    const Vector3 &to,
+                                    const Color &colour)
+{
+    _lines.push_back(DebugVertex{from, colour});
+    _lines.push_back(DebugVertex{to, colour});
+}
+
+void DebugVertexCollector::add_triangle(const Vector3 &first,
+                                        const Vector3 &second,
+                                        const Vector3 &third,
+                                        const Color &colour)
+{
+    _triangles.push_back(DebugVertex{first, colour});
+    _triangles.push_back(DebugVertex{second, colour});
+    _triangles.push_back(DebugVertex{third, colour});
+}
+
+void DebugVertexCollector::add_mesh(const DebugMesh &mesh,
+                                    const Matrix &transform,
+                                    const Color &tint,
+                                    const bool wireframe)
+{
+    ++_meshes;
+    const std::size_t indices{mesh._indices.size() - mesh._indices.size() % 3};
+    if (wireframe)
+    {
+        _lines.reserve(_lines.size() + 2 * indices);
+        for (std::size_t first{0}; first < indices; first += 3)
+        {
+            for (std::size_t edge{0}; edge < 3; ++edge)
+            {
+                const std::uint32_t from{mesh._indices[first + edge]};
+                const std::uint32_t to{mesh._indices[first + (edge + 1) % 3]};
+                add_line(transform_point(transform, mesh._positions[from]),
+                         transform_point(transform, mesh._positions[to]),
+                         tint_colour(mesh._colours[from], tint, 1.F));
+            }
+        }
+        return;
+    }
+
+    _triangles.reserve(_triangles.size() + indices);
+    for (std::size_t corner{0}; corner < indices; ++corner)
+    {
+        const std::uint32_t index{mesh._indices[corner]};
+        const Vector3 normal{
+            transform_direction(transform, mesh._normals[index])};
+        _triangles.push_back(DebugVertex{
+            transform_point(transform, mesh._positions[index]),
+            tint_colour(
+                mesh._colours[index], tint, facing_brightness(normal))});
+    }
+}
+
+void DebugVertexCollector::append_lines(const std::vector<DebugVertex> &lines)
+{
+    _lines.insert(_lines.end(), lines.begin(), lines.end());
+}
+
+const std::vector<DebugVertex> &DebugVertexCollector::lines() const
+{
+    return _lines;
+}
+
+const std::vector<DebugVertex> &DebugVertexCollector::triangles() const
+{
+    return _triangles;
+}
+
+std::size_t DebugVertexCollector::line_count() const
+{
+    return _lines.size() / 2;
+}
+
+std::size_t DebugVertexCollector::triangle_count() const
+{
+    return _triangles.size() / 3;
+}
+
+std::size_t DebugVertexCollector::mesh_count() const
+{
+    return _meshes;
+}
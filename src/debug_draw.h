@@ -0,0 +1,75 @@
+#ifndef SRC_DEBUG_DRAW_H
+#define SRC_DEBUG_DRAW_H
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Categories of the physics debug view, toggled from the Dev Panel
+struct DebugDrawSettings
+{
+    bool _enabled{false};
+    bool _shapes{true};
+    bool _wireframe{false};
+    bool _sleep_colours{true}; // sleeping bodies red, awake ones by motion type
+    bool _bounding_boxes{false}; // the bounds each body has in the broad phase
+    bool _velocities{false};
+    bool _centres_of_mass{false};
+    bool _contacts{false};
+};
+
+struct DebugVertex
+{
+    Vector3 _position;
+    Color _colour;
+};
+
+// Shape geometry in model space, built once and kept between frames
+struct DebugMesh
+{
+    std::vector<Vector3> _positions{};
+    std::vector<Vector3> _normals{};
+    std::vector<Color> _colours{};
+    std::vector<std::uint32_t> _indices{}; // three per triangle
+};
+
+// Collects a frame of debug geometry into one line list and one triangle list,
+// so it can be submitted in a few large draw calls. Nothing here touches the
+// GPU. Vectors keep their capacity across clear, so a steady scene stops
+// allocating after the first few frames.
+class DebugVertexCollector
+{
+public:
+    DebugVertexCollector() = default;
+
+    // mutator methods
+    void clear();
+    void add_line(const Vector3 &from, const Vector3 &to, const Color &colour);
+    void add_triangle(const Vector3 &first,
+                      const Vector3 &second,
+                      const Vector3 &third,
+                      const Color &colour);
+    // Place a cached mesh in the frame. Solid triangles are tinted and shaded
+    // by which way they face, wireframes become one line per edge.
+    void add_mesh(const DebugMesh &mesh,
+                  const Matrix &transform,
+                  const Color &tint,
+                  bool wireframe);
+    void append_lines(const std::vector<DebugVertex> &lines);
+
+    // accessor methods
+    [[nodiscard]] const std::vector<DebugVertex> &lines() const;
+    [[nodiscard]] const std::vector<DebugVertex> &triangles() const;
+    [[nodiscard]] std::size_t line_count() const;
+    [[nodiscard]] std::size_t triangle_count() const;
+    [[nodiscard]] std::size_t mesh_count() const;
+
+private:
+    std::vector<DebugVertex> _lines{};     // two vertices per line
+    std::vector<DebugVertex> _triangles{}; // three vertices per triangle
+    std::size_t _meshes{0};
+};
+
+#endif
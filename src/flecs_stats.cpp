@@ -0,0 +1,87 @@
+#include "flecs_stats.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/world.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+void FlecsStatsHistory::collect(const flecs::world &world,
+                                const std::vector<NamedQuery> &queries)
+{
+    const auto index{static_cast<std::size_t>(_offset)};
+    _offset = (_offset + 1) % kSampleCount;
+
+    // flecs keeps its own rolling window in the stats struct, so keep it
+    // around between calls rather than starting from zero each time
+    ecs_world_stats_get(world.c_ptr(), &_world_stats);
+    const std::int32_t sample{_world_stats.t};
+    _entities = static_cast<std::int32_t>(
+        _world_stats.entities.count.gauge.avg[sample]);
+    _tables =
+        static_cast<std::int32_t>(_world_stats.tables.count.gauge.avg[sample]);
+    _empty_tables = static_cast<std::int32_t>(
+        _world_stats.tables.empty_count.gauge.avg[sample]);
+
+    // few entities per non-empty table means archetypes are fragmented
+    const std::int32_t non_empty_tables{_tables - _empty_tables};
+    _entity_samples[index] = static_cast<float>(_entities);
+    _table_samples[index] = static_cast<float>(_tables);
+    _entities_per_table_samples[index] =
+        non_empty_tables > 0 ? static_cast<float>(_entities) /
+                                   static_cast<float>(non_empty_tables)
+                             : 0.F;
+
+    _queries.resize(queries.size());
+    auto history{_queries.begin()};
+    for (const NamedQuery &query : queries)
+    {
+        history->_name = query._name;
+        history->_tables = ecs_query_table_count(query._query);
+        history->_entities = ecs_query_entity_count(query._query);
+        history->_entity_samples[index] =
+            static_cast<float>(history->_entities);
+        ++history;
+    }
+}
+
+int FlecsStatsHistory::offset() const
+{
+    return _offset;
+}
+
+std::int32_t FlecsStatsHistory::entities() const
+{
+    return _entities;
+}
+
+std::int32_t FlecsStatsHistory::tables() const
+{
+    return _tables;
+}
+
+std::int32_t FlecsStatsHistory::empty_tables() const
+{
+    return _empty_tables;
+}
+
+const float *FlecsStatsHistory::entity_samples() const
+{
+    return _entity_samples.data();
+}
+
+const float *FlecsStatsHistory::table_samples() const
+{
+    return _table_samples.data();
+}
+
+const float *FlecsStatsHistory::entities_per_table_samples() const
+{
+    return _entities_per_table_samples.data();
+}
+
+const std::vector<QueryMatchHistory> &FlecsStatsHistory::queries() const
+{
+    return _queries;
+}
@@ -0,0 +1,65 @@
+#ifndef SRC_FLECS_STATS_H
+#define SRC_FLECS_STATS_H
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/world.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct NamedQuery
+{
+    const char *_name;
+    const ecs_query_t *_query;
+};
+
+struct QueryMatchHistory
+{
+    static constexpr int kSampleCount{60};
+
+    const char *_name{nullptr};
+    std::int32_t _tables{0};
+    std::int32_t _entities{0};
+    std::array<float, kSampleCount> _entity_samples{};
+};
+
+// Samples flecs world statistics (entities, tables and how fragmented the
+// archetypes are) and the match counts of the queries the frame runs. Meant
+// to be collected every few frames, not every frame.
+class FlecsStatsHistory
+{
+public:
+    static constexpr int kSampleCount{QueryMatchHistory::kSampleCount};
+
+    FlecsStatsHistory() = default;
+
+    // mutator methods
+    void collect(const flecs::world &world,
+                 const std::vector<NamedQuery> &queries);
+
+    // accessor methods
+    // Index of the oldest sample, for ImGui::PlotLines' values_offset
+    [[nodiscard]] int offset() const;
+    [[nodiscard]] std::int32_t entities() const;
+    [[nodiscard]] std::int32_t tables() const;
+    [[nodiscard]] std::int32_t empty_tables() const;
+    [[nodiscard]] const float *entity_samples() const;
+    [[nodiscard]] const float *table_samples() const;
+    [[nodiscard]] const float *entities_per_table_samples() const;
+    [[nodiscard]] const std::vector<QueryMatchHistory> &queries() const;
+
+private:
+    ecs_world_stats_t _world_stats{};
+    int _offset{0}; // where the next sample goes, over the oldest
+    std::int32_t _entities{0};
+    std::int32_t _tables{0};
+    std::int32_t _empty_tables{0};
+    std::array<float, kSampleCount> _entity_samples{};
+    std::array<float, kSampleCount> _table_samples{};
+    std::array<float, kSampleCount> _entities_per_table_samples{};
+    std::vector<QueryMatchHistory> _queries{};
+};
+
+#endif
@@ -0,0 +1,336 @@
+#include "flight_recorder.h"
+
+#include "constants.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+FlightRecorder process_flight_recorder{};
+
+void copy_text(const std::string_view text, std::array<char, 80> &destination)
+{
+    const std::size_t length{std::min(text.size(), destination.size() - 1)};
+    std::memcpy(destination.data(), text.data(), length);
+    destination[length] = '\0';
+}
+
+// open, write and close are async-signal-safe where fopen and streams are not
+bool write_file(const char *path,
+                const void *header,
+                const std::size_t header_bytes,
+                const void *records,
+                const std::size_t record_bytes)
+{
+#ifdef _WIN32
+    const int file{_open(path,
+                         _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                         _S_IREAD | _S_IWRITE)};
+#else
+    constexpr mode_t kPermissions{0644};
+    const int file{open(path, O_WRONLY | O_CREAT | O_TRUNC, kPermissions)};
+#endif
+    if (file < 0)
+    {
+        return false;
+    }
+    const auto write_all{[file](const void *data, std::size_t bytes) {
+        const auto *bytes_left{static_cast<const char *>(data)};
+        while (bytes > 0)
+        {
+#ifdef _WIN32
+            const int written{
+                _write(file, bytes_left, static_cast<unsigned int>(bytes))};
+#else
+            const ssize_t written{write(file, bytes_left, bytes)};
+#endif
+            if (written <= 0)
+            {
+                return false;
+            }
+            bytes_left += written;
+            bytes -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }};
+    const bool written{write_all(header, header_bytes) &&
+                       write_all(records, record_bytes)};
+#ifdef _WIN32
+    _close(file);
+#else
+    close(file);
+#endif
+    return written;
+}
+
+void dump_on_signal(const int signal_number)
+{
+    flight_recorder().dump(FlightDumpReason::kSignal, signal_number);
+    // carry on as if the handler had never been installed
+    std::signal(signal_number, SIG_DFL);
+    std::raise(signal_number);
+}
+} // namespace
+
+FlightRecorder::FlightRecorder() : _start(std::chrono::steady_clock::now())
+{
+    set_dump_path(constants::kFlightRecordingPath);
+}
+
+void FlightRecorder::record(FlightRecord record)
+{
+    const std::uint64_t sequence{_next.fetch_add(1, std::memory_order_relaxed)};
+    record._sequence = sequence;
+    record._nanoseconds = nanoseconds();
+
+    std::array<std::uint64_t, kWords> words{};
+    std::memcpy(words.data(), &record, sizeof(record));
+    Slot &slot{_slots[sequence % _slots.size()]};
+    slot._state.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t word{0}; word < kWords; ++word)
+    {
+        slot._words[word].store(words[word], std::memory_order_relaxed);
+    }
+    slot._state.store(2 * sequence + 2, std::memory_order_release);
+}
+
+void FlightRecorder::record_frame(const std::uint64_t frame,
+                                  const float milliseconds)
+{
+    FlightRecord record{};
+    record._type = FlightRecordType::kFrame;
+    record._index = frame;
+    record._values[0] = milliseconds;
+    this->record(record);
+}
+
+void FlightRecorder::record_physics_step(const std::uint64_t step,
+                                         const float milliseconds,
+                                         const std::size_t bodies)
+{
+    FlightRecord record{};
+    record._type = FlightRecordType::kPhysicsStep;
+    record._index = step;
+    record._count = static_cast<std::uint32_t>(bodies);
+    record._values[0] = milliseconds;
+    this->record(record);
+}
+
+void FlightRecorder::record_key(const int key)
+{
+    FlightRecord record{};
+    record._type = FlightRecordType::kKey;
+    record._count = static_cast<std::uint32_t>(key);
+    this->record(record);
+}
+
+void FlightRecorder::record_mouse(const int button, const float x, const float y)
+{
+    FlightRecord record{};
+    record._type = FlightRecordType::kMouse;
+    record._count = static_cast<std::uint32_t>(button);
+    record._values[0] = x;
+    record._values[1] = y;
+    this->record(record);
+}
+
+void FlightRecorder::record_log(const std::uint8_t level,
+                                const std::string_view message)
+{
+    FlightRecord record{};
+    record._type = FlightRecordType::kLog;
+    record._level = level;
+    copy_text(message, record._text);
+    this->record(record);
+}
+
+void FlightRecorder::record_assert(const char *expression,
+                                   const char *message,
+                                   const char *file,
+                                   const std::uint32_t line)
+{
+    // the file name is the end of the path, and worth the most room
+    const std::string_view path{file != nullptr ? file : ""};
+    const std::size_t separator{path.find_last_of("/\\")};
+    const std::string_view file_name{
+        separator == std::string_view::npos ? path
+                                            : path.substr(separator + 1)};
+
+    FlightRecord record{};
+    record._type = FlightRecordType::kAssert;
+    record._count = line;
+    std::array<char, 80> &text{record._text};
+    std::size_t length{0};
+    for (const std::string_view part :
+         {file_name,
+          std::string_view{": "},
+          std::string_view{expression != nullptr ? expression : ""},
+          std::string_view{message != nullptr ? " " : ""},
+          std::string_view{message != nullptr ? message : ""}})
+    {
+        const std::size_t copied{
+            std::min(part.size(), text.size() - 1 - length)};
+        std::memcpy(text.data() + length, part.data(), copied);
+        length += copied;
+    }
+    text[length] = '\0';
+    this->record(record);
+}
+
+void FlightRecorder::set_dump_path(const std::string_view path)
+{
+    const std::size_t length{std::min(path.size(), _dump_path.size() - 1)};
+    std::memcpy(_dump_path.data(), path.data(), length);
+    _dump_path[length] = '\0';
+}
+
+bool FlightRecorder::dump(const FlightDumpReason reason, const int detail)
+{
+    if (_dumping.exchange(true, std::memory_order_acquire))
+    {
+        return false;
+    }
+    FlightRecordingHeader header{};
+    header._records = collect_for_dump();
+    header._reason = reason;
+    header._detail = detail;
+    header._nanoseconds = nanoseconds();
+    const bool written{write_file(_dump_path.data(),
+                                  &header,
+                                  sizeof(header),
+                                  _dump_records.data(),
+                                  header._records * sizeof(FlightRecord))};
+    _dumping.store(false, std::memory_order_release);
+    return written;
+}
+
+void FlightRecorder::snapshot(std::vector<FlightRecord> &records) const
+{
+    records.clear();
+    const std::uint64_t next{_next.load(std::memory_order_acquire)};
+    const std::uint64_t first{next > _slots.size() ? next - _slots.size() : 0};
+    records.reserve(static_cast<std::size_t>(next - first));
+    FlightRecord record{};
+    for (std::uint64_t sequence{first}; sequence < next; ++sequence)
+    {
+        if (read(sequence, record))
+        {
+            records.push_back(record);
+        }
+    }
+}
+
+std::uint64_t FlightRecorder::recorded() const
+{
+    return _next.load(std::memory_order_relaxed);
+}
+
+const char *FlightRecorder::dump_path() const
+{
+    return _dump_path.data();
+}
+
+bool FlightRecorder::read(const std::uint64_t sequence,
+                          FlightRecord &record) const
+{
+    const Slot &slot{_slots[sequence % _slots.size()]};
+    const std::uint64_t whole{2 * sequence + 2};
+    if (slot._state.load(std::memory_order_acquire) != whole)
+    {
+        return false;
+    }
+    std::array<std::uint64_t, kWords> words{};
+    for (std::size_t word{0}; word < kWords; ++word)
+    {
+        words[word] = slot._words[word].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot._state.load(std::memory_order_relaxed) != whole)
+    {
+        return false;
+    }
+    std::memcpy(static_cast<void *>(&record), words.data(), sizeof(record));
+    return true;
+}
+
+std::uint32_t FlightRecorder::collect_for_dump() const
+{
+    const std::uint64_t next{_next.load(std::memory_order_acquire)};
+    const std::uint64_t first{next > _slots.size() ? next - _slots.size() : 0};
+    std::uint32_t records{0};
+    for (std::uint64_t sequence{first}; sequence < next; ++sequence)
+    {
+        if (read(sequence, _dump_records[records]))
+        {
+            ++records;
+        }
+    }
+    return records;
+}
+
+std::int64_t FlightRecorder::nanoseconds() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - _start)
+        .count();
+}
+
+FlightRecorder &flight_recorder()
+{
+    return process_flight_recorder;
+}
+
+void install_flight_recorder_signal_handlers()
+{
+    for (const int signal_number : {SIGSEGV, SIGABRT, SIGFPE, SIGILL})
+    {
+        std::signal(signal_number, dump_on_signal);
+    }
+#ifdef SIGBUS
+    std::signal(SIGBUS, dump_on_signal);
+#endif
+}
+
+bool read_flight_recording(const std::string &path,
+                           FlightRecordingHeader &header,
+                           std::vector<FlightRecord> &records)
+{
+    std::ifstream input{path, std::ios::binary};
+    if (!input.read(reinterpret_cast<char *>(&header), // NOLINT
+                    sizeof(header)))
+    {
+        return false;
+    }
+    const FlightRecordingHeader expected{};
+    if (header._magic != expected._magic ||
+        header._record_size != sizeof(FlightRecord))
+    {
+        return false;
+    }
+    records.resize(header._records);
+    return static_cast<bool>(
+        input.read(reinterpret_cast<char *>(records.data()), // NOLINT
+                   static_cast<std::streamsize>(records.size() *
+                                                sizeof(FlightRecord))));
+}
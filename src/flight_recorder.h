@@ -0,0 +1,142 @@
+#ifndef SRC_FLIGHT_RECORDER_H
+#define SRC_FLIGHT_RECORDER_H
+
+#include "constants.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+enum class FlightRecordType : std::uint8_t
+{
+    kFrame,       // _index frame, _values[0] frame milliseconds
+    kPhysicsStep, // _index step, _values[0] milliseconds, _count bodies
+    kKey,         // _count raylib key code
+    kMouse,       // _count raylib button, _values[0..1] position
+    kLog,         // _level spdlog level, _text message
+    kAssert,      // _count line, _text file and expression
+};
+
+// One fixed-size entry. Text longer than _text is truncated.
+struct FlightRecord
+{
+    std::uint64_t _sequence{0};   // order recorded in, across threads
+    std::int64_t _nanoseconds{0}; // since the recorder was made
+    FlightRecordType _type{FlightRecordType::kFrame};
+    std::uint8_t _level{0};
+    std::uint16_t _padding{0};
+    std::uint32_t _count{0};
+    std::uint64_t _index{0};
+    std::array<float, 4> _values{};
+    std::array<char, 80> _text{}; // always null terminated
+};
+static_assert(sizeof(FlightRecord) == 128 &&
+                  std::is_trivially_copyable_v<FlightRecord>,
+              "FlightRecord is written to disk as is");
+
+enum class FlightDumpReason : std::uint32_t
+{
+    kRequested,
+    kAssert,
+    kSignal, // FlightRecordingHeader::_detail is the signal number
+};
+
+// Start of a dump, followed by _records FlightRecords, oldest first
+struct FlightRecordingHeader
+{
+    std::array<char, 8> _magic{'F', 'L', 'I', 'G', 'H', 'T', '0', '1'};
+    std::uint32_t _record_size{sizeof(FlightRecord)};
+    std::uint32_t _records{0};
+    FlightDumpReason _reason{FlightDumpReason::kRequested};
+    std::int32_t _detail{0};
+    std::int64_t _nanoseconds{0}; // when the dump was taken
+};
+static_assert(sizeof(FlightRecordingHeader) == 32 &&
+                  std::is_trivially_copyable_v<FlightRecordingHeader>,
+              "FlightRecordingHeader is written to disk as is");
+
+// Always-on ring of the last constants::kFlightRecorderCapacity records.
+// Any thread can record without taking a lock: a record claims a slot with
+// one atomic increment and is copied in as relaxed atomic words, bracketed
+// by a per slot sequence number, so a reader can tell a whole record from
+// one being overwritten and skips the latter. Recording costs under a tenth
+// of a microsecond and never allocates, so it stays on in Distribution builds.
+// dump is async-signal-safe, so crash handlers can call it.
+class FlightRecorder
+{
+public:
+    FlightRecorder();
+
+    // mutator methods
+    // Fills in _sequence and _nanoseconds
+    void record(FlightRecord record);
+    void record_frame(std::uint64_t frame, float milliseconds);
+    void record_physics_step(std::uint64_t step,
+                             float milliseconds,
+                             std::size_t bodies);
+    void record_key(int key);
+    void record_mouse(int button, float x, float y);
+    void record_log(std::uint8_t level, std::string_view message);
+    void record_assert(const char *expression,
+                       const char *message,
+                       const char *file,
+                       std::uint32_t line);
+    // Truncated to fit; dump writes here
+    void set_dump_path(std::string_view path);
+    // Write the whole records to the dump path, oldest first. Safe to call
+    // from a signal handler. Returns false if the file could not be written,
+    // or another dump is in progress.
+    bool dump(FlightDumpReason reason, int detail = 0);
+
+    // accessor methods
+    // Whole records, oldest first. Not async-signal-safe.
+    void snapshot(std::vector<FlightRecord> &records) const;
+    [[nodiscard]] std::uint64_t recorded() const;
+    [[nodiscard]] const char *dump_path() const;
+
+private:
+    static constexpr std::size_t kWords{sizeof(FlightRecord) /
+                                        sizeof(std::uint64_t)};
+
+    struct Slot
+    {
+        // 2n + 1 while record n is being written, 2n + 2 once it is whole
+        std::atomic<std::uint64_t> _state{0};
+        std::array<std::atomic<std::uint64_t>, kWords> _words{};
+    };
+
+    // Copy out record sequence, false if it is not whole or was overwritten
+    bool read(std::uint64_t sequence, FlightRecord &record) const;
+    // Whole records, oldest first, into _dump_records
+    std::uint32_t collect_for_dump() const;
+    [[nodiscard]] std::int64_t nanoseconds() const;
+
+    std::chrono::steady_clock::time_point _start;
+    std::atomic<std::uint64_t> _next{0};
+    std::array<Slot, constants::kFlightRecorderCapacity> _slots{};
+    std::array<char, 256> _dump_path{};
+
+    // dumps cannot allocate, so they are staged here
+    std::atomic<bool> _dumping{false};
+    mutable std::array<FlightRecord, constants::kFlightRecorderCapacity>
+        _dump_records{};
+};
+
+// The process-wide recorder, created before main
+FlightRecorder &flight_recorder();
+
+// Dump the process-wide recorder on SIGSEGV, SIGABRT, SIGFPE, SIGILL and,
+// where there is one, SIGBUS, then let the signal carry on as it would have
+void install_flight_recorder_signal_handlers();
+
+bool read_flight_recording(const std::string &path,
+                           FlightRecordingHeader &header,
+                           std::vector<FlightRecord> &records);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef SRC_FLIGHT_RECORDER_SINK_H
+#define SRC_FLIGHT_RECORDER_SINK_H
+
+#include "flight_recorder.h"
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <cstdint>
+#include <string_view>
+
+// Copies warnings and errors into the process-wide flight recorder. The
+// recorder takes no lock, so the sink does not either.
+class FlightRecorderSink final
+    : public spdlog::sinks::base_sink<spdlog::details::null_mutex>
+{
+public:
+    FlightRecorderSink()
+    {
+        set_level(spdlog::level::warn);
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &message) override
+    {
+        flight_recorder().record_log(
+            static_cast<std::uint8_t>(message.level),
+            std::string_view{message.payload.data(), message.payload.size()});
+    }
+
+    void flush_() override
+    {
+    }
+};
+
+#endif
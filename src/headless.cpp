@@ -0,0 +1,520 @@
+#include "headless.h"
+
+#include "body_pool.h"
+#include "components.h"
+#include "constants.h"
+#include "memory_stats.h"
+#include "particles.h"
+#include "physics.h"
+#include "physics_commands.h"
+#include "systems.h"
+#include "transform_snapshot.h"
+#include "world_checkpoint.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/flecs.hpp>
+#include <flecs/addons/cpp/mixins/query/impl.hpp>
+#include <flecs/addons/cpp/world.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <ratio>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace
+{
+struct PhaseTimings
+{
+    double _total_milliseconds{0.0};
+    double _max_milliseconds{0.0};
+
+    void record(const double milliseconds)
+    {
+        _total_milliseconds += milliseconds;
+        _max_milliseconds = std::max(_max_milliseconds, milliseconds);
+    }
+};
+
+enum class ChurnMode : std::uint8_t
+{
+    kDestroyBodies, // despawn destroys bodies, spawn creates new ones
+    kRecycleBodies, // bodies go back to the pool and are reused
+    kCommandBuffer, // as recycling, but batched by the collider observers
+};
+
+struct ChurnResult
+{
+    PhaseTimings _spawn{};
+    PhaseTimings _despawn{};
+    PhaseTimings _flush{}; // applying the command buffer, batched mode only
+    PhaseTimings _step{};
+    BodyPoolStats _pool_stats{};
+    bool _batched{false};
+};
+
+template <typename Function>
+double time_milliseconds(Function &&function)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    function();
+    return std::chrono::duration<double, std::milli>{
+        std::chrono::steady_clock::now() - start}
+        .count();
+}
+
+ChurnResult run_churn(const ChurnMode mode,
+                      const int ticks,
+                      const int spawns_per_tick,
+                      const int lifetime_ticks)
+{
+    const bool recycle_bodies{mode != ChurnMode::kDestroyBodies};
+    const bool batched{mode == ChurnMode::kCommandBuffer};
+
+    // declared before the world, as its observers record into it until the
+    // world is gone
+    PhysicsCommandBuffer physics_commands{};
+    const flecs::world world;
+    spawn_floor_system(world);
+    world.entity<DevPanelState>().set<DevPanelState>({0});
+
+    const auto live_limit{
+        static_cast<std::size_t>(spawns_per_tick * lifetime_ticks)};
+    PhysicsCapacity capacity{};
+    capacity._max_bodies = static_cast<JPH::uint>(2 * live_limit);
+    capacity._max_body_pairs = capacity._max_bodies;
+    capacity._max_contact_constraints = capacity._max_bodies;
+
+    PhysicsEngine physics_engine{};
+    physics_engine.initialise(capacity);
+    create_entity_colliders_system(world, physics_engine);
+    if (recycle_bodies)
+    {
+        physics_engine.prewarm_ball_pool(constants::kBallRadius, live_limit);
+    }
+    physics_engine.start_simulation();
+    if (batched)
+    {
+        observe_colliders_system(world, physics_commands);
+    }
+
+    ChurnResult result{};
+    result._batched = batched;
+    std::deque<flecs::entity> live_balls;
+    const float frame_time{1.F / static_cast<float>(constants::kTickrate)};
+    int spawned{0};
+    for (int tick{0}; tick < ticks; ++tick)
+    {
+        result._despawn.record(time_milliseconds([&]() {
+            while (live_balls.size() + static_cast<std::size_t>(spawns_per_tick) >
+                   live_limit)
+            {
+                if (batched)
+                {
+                    live_balls.front().destruct();
+                }
+                else
+                {
+                    despawn_ball_system(
+                        live_balls.front(), physics_engine, recycle_bodies);
+                }
+                live_balls.pop_front();
+            }
+        }));
+
+        result._spawn.record(time_milliseconds([&]() {
+            // spread the spawns over the floor, a few layers up
+            constexpr int kColumns{9};
+            constexpr int kLayers{5};
+            constexpr float kSpawnHeight{5.F};
+            for (int spawn{0}; spawn < spawns_per_tick; ++spawn, ++spawned)
+            {
+                const Vector3 position{
+                    static_cast<float>(spawned % kColumns) - 4.F,
+                    kSpawnHeight + static_cast<float>(spawned % kLayers),
+                    static_cast<float>((spawned / kColumns) % kColumns) - 4.F};
+                const Vector3 velocity{0.F, -1.F, 0.F};
+                live_balls.push_back(
+                    batched
+                        ? spawn_ball_entity_system(world, position, velocity)
+                        : spawn_ball_system(
+                              world, physics_engine, position, velocity));
+            }
+        }));
+
+        if (batched)
+        {
+            result._flush.record(time_milliseconds([&]() {
+                resolve_physics_commands_system(world, physics_commands);
+                physics_engine.apply_body_commands(physics_commands.commands());
+                write_physics_bodies_system(world, physics_commands);
+            }));
+        }
+
+        result._step.record(
+            time_milliseconds([&]() { physics_engine.step(frame_time); }));
+    }
+    result._pool_stats = physics_engine.body_pool_stats();
+
+    physics_engine.cleanup();
+    return result;
+}
+
+void log_churn_result(const char *label,
+                      const ChurnResult &result,
+                      const int ticks)
+{
+    const auto log_phase{[ticks](const char *phase,
+                                 const PhaseTimings &timings) {
+        spdlog::info("  {}: mean {:.3f} ms, max {:.3f} ms per tick",
+                     phase,
+                     timings._total_milliseconds / static_cast<double>(ticks),
+                     timings._max_milliseconds);
+    }};
+    spdlog::info("{}:", label);
+    log_phase("despawn", result._despawn);
+    log_phase("spawn", result._spawn);
+    if (result._batched)
+    {
+        log_phase("flush", result._flush);
+    }
+    log_phase("step", result._step);
+    spdlog::info("  bodies created {}, reused {}, released to pool {}",
+                 result._pool_stats._created,
+                 result._pool_stats._reused,
+                 result._pool_stats._released);
+}
+
+// A fountain of particles that all stay alive for the run, so every tick
+// integrates the same number
+void fill_particles(ParticleSystem &particles,
+                    const int count,
+                    const float lifetime)
+{
+    particles.clear();
+    particles.reserve(static_cast<std::size_t>(count));
+    std::uint32_t seed{1};
+    constexpr float kSpeed{10.F};
+    constexpr float kHeight{5.F};
+    for (int particle{0}; particle < count; ++particle)
+    {
+        particles.emit(
+            Vector3{0.F, kHeight * next_particle_random(seed), 0.F},
+            Vector3{kSpeed * (next_particle_random(seed) - 0.5F),
+                    kSpeed * next_particle_random(seed),
+                    kSpeed * (next_particle_random(seed) - 0.5F)},
+            lifetime,
+            WHITE);
+    }
+}
+
+// A large floor with a block of spheres falling onto it
+void spawn_falling_spheres(const flecs::world &world, const int spheres)
+{
+    constexpr float kFloorHalfExtent{20.F};
+    world.entity()
+        .set<Position>(Position{Vector3{0.F, -1.F, 0.F}})
+        .add<GridComponent>()
+        .set<BoxCollider>(
+            BoxCollider{Vector3{kFloorHalfExtent, 1.F, kFloorHalfExtent}});
+    world.entity<DevPanelState>().set<DevPanelState>({0});
+
+    constexpr int kColumns{25};
+    constexpr float kSpacing{2.2F * constants::kBallRadius};
+    constexpr float kDropHeight{5.F};
+    const float offset{0.5F * kSpacing * static_cast<float>(kColumns - 1)};
+    for (int sphere{0}; sphere < spheres; ++sphere)
+    {
+        const int column{sphere % kColumns};
+        const int row{(sphere / kColumns) % kColumns};
+        const int layer{sphere / (kColumns * kColumns)};
+        world.entity()
+            .set<Position>(Position{
+                Vector3{kSpacing * static_cast<float>(column) - offset,
+                        kDropHeight + kSpacing * static_cast<float>(layer),
+                        kSpacing * static_cast<float>(row) - offset}})
+            .set<SphereMesh>(
+                {constants::kSphereColours[0], constants::kBallRadius})
+            .add<SphereLod>()
+            .set<SphereCollider>(SphereCollider{constants::kBallRadius})
+            .set<Velocity>(Velocity{Vector3{0.F, 0.F, 0.F}})
+            .add<RigidBodyTransform>();
+    }
+}
+
+void step_and_apply(PhysicsEngine &physics_engine,
+                    const flecs::world &world,
+                    TransformSnapshot &snapshot,
+                    SnapshotSyncStats &sync_stats)
+{
+    physics_engine.step(1.F / static_cast<float>(constants::kTickrate));
+    physics_engine.read_transforms(snapshot);
+    apply_transform_snapshot_system(world, snapshot, sync_stats);
+}
+
+bool same_transforms(const TransformSnapshot &lhs, const TransformSnapshot &rhs)
+{
+    if (lhs._transforms.size() != rhs._transforms.size())
+    {
+        return false;
+    }
+    for (std::size_t index{0}; index < lhs._transforms.size(); ++index)
+    {
+        const BodyTransform &left{lhs._transforms[index]};
+        const BodyTransform &right{rhs._transforms[index]};
+        if (left._entity != right._entity ||
+            std::memcmp(&left._transform,
+                        &right._transform,
+                        sizeof(RigidBodyTransform)) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int run_headless(const int ticks, const std::string &trace_path)
+{
+    const flecs::world world;
+    spawn_floor_system(world);
+    spawn_sphere_system(world);
+    world.entity<DevPanelState>().set<DevPanelState>({0});
+
+    spdlog::info("Initialising Physics Engine");
+    PhysicsEngine physics_engine{};
+    physics_engine.initialise();
+    create_entity_colliders_system(world, physics_engine);
+    physics_engine.start_simulation();
+    if (!trace_path.empty() && !physics_engine.start_trace(trace_path))
+    {
+        physics_engine.cleanup();
+        return 1;
+    }
+
+    const flecs::query<const SphereCollider, Position, Velocity, DevPanelState>
+        update_sphere_query{world
+                                .query_builder<const SphereCollider,
+                                               Position,
+                                               Velocity,
+                                               DevPanelState>()
+                                .term_at(4)
+                                .singleton()
+                                .build()};
+
+    spdlog::info("Running {} headless ticks", ticks);
+    const float frame_time{1.F / static_cast<float>(constants::kTickrate)};
+    for (int tick{0}; tick < ticks; ++tick)
+    {
+        update_sphere_system(update_sphere_query, frame_time, physics_engine);
+    }
+
+    MemoryStats memory_stats{};
+    memory_stats._flecs = collect_flecs_memory_stats(world);
+    memory_stats._jolt = physics_engine.memory_stats();
+    log_memory_stats(memory_stats);
+
+    spdlog::info("Preparing Physics Engine for Shutdown");
+    physics_engine.cleanup();
+
+    return 0;
+}
+
+int run_churn_stress(const int ticks)
+{
+    // 50 per tick at 60 Hz is 3000 spawns and despawns a second
+    constexpr int kSpawnsPerTick{50};
+    constexpr int kLifetimeTicks{60};
+
+    spdlog::info("Running churn stress for {} ticks, {} spawns per tick",
+                 ticks,
+                 kSpawnsPerTick);
+    const ChurnResult destroyed{run_churn(
+        ChurnMode::kDestroyBodies, ticks, kSpawnsPerTick, kLifetimeTicks)};
+    const ChurnResult recycled{run_churn(
+        ChurnMode::kRecycleBodies, ticks, kSpawnsPerTick, kLifetimeTicks)};
+    const ChurnResult batched{run_churn(
+        ChurnMode::kCommandBuffer, ticks, kSpawnsPerTick, kLifetimeTicks)};
+
+    log_churn_result("Create and destroy bodies", destroyed, ticks);
+    log_churn_result("Recycle bodies through the pool", recycled, ticks);
+    log_churn_result(
+        "Batch through the physics command buffer", batched, ticks);
+    return 0;
+}
+
+int run_checkpoint_round_trip(const int spheres)
+{
+    constexpr int kWarmUpTicks{120};
+    constexpr int kCompareTicks{120};
+    const std::string path{(std::filesystem::temp_directory_path() /
+                            "round_trip.checkpoint")
+                               .string()};
+
+    PhysicsCapacity capacity{};
+    capacity._max_bodies = static_cast<JPH::uint>(spheres + 1);
+    capacity._max_body_pairs = 4 * capacity._max_bodies;
+    capacity._max_contact_constraints = 4 * capacity._max_bodies;
+    capacity._temp_allocator_bytes = 64 * 1'024 * 1'024;
+
+    // contact and activation logging would dominate the step times
+    spdlog::set_level(spdlog::level::warn);
+    const flecs::world world;
+    spawn_falling_spheres(world, spheres);
+    PhysicsEngine physics_engine{};
+    physics_engine.initialise(capacity);
+    create_entity_colliders_system(world, physics_engine);
+    physics_engine.start_simulation();
+
+    TransformSnapshot snapshot{};
+    SnapshotSyncStats sync_stats{};
+    for (int tick{0}; tick < kWarmUpTicks; ++tick)
+    {
+        step_and_apply(physics_engine, world, snapshot, sync_stats);
+    }
+
+    // only the copy stalls the simulation, the file is written alongside it
+    WorldCheckpoint checkpoint{};
+    const double capture_milliseconds{time_milliseconds([&]() {
+        capture_world_checkpoint(world, physics_engine, checkpoint);
+    })};
+    CheckpointWriter writer{};
+    writer.save(std::move(checkpoint), path);
+    PhaseTimings ticks_while_saving{};
+    for (int tick{0}; tick < kCompareTicks; ++tick)
+    {
+        ticks_while_saving.record(time_milliseconds([&]() {
+            step_and_apply(physics_engine, world, snapshot, sync_stats);
+        }));
+    }
+    const CheckpointIoStats save_stats{writer.wait()};
+
+    WorldCheckpoint loaded{};
+    const CheckpointIoStats load_stats{read_world_checkpoint(path, loaded)};
+    const flecs::world restored_world;
+    PhysicsEngine restored_engine{};
+    bool restored{load_stats._succeeded};
+    const double restore_milliseconds{time_milliseconds([&]() {
+        restored = restored && restore_world_checkpoint(
+                                   loaded, restored_world, restored_engine);
+    })};
+
+    bool identical{false};
+    if (restored)
+    {
+        TransformSnapshot restored_snapshot{};
+        SnapshotSyncStats restored_sync_stats{};
+        for (int tick{0}; tick < kCompareTicks; ++tick)
+        {
+            step_and_apply(restored_engine,
+                           restored_world,
+                           restored_snapshot,
+                           restored_sync_stats);
+        }
+        identical = same_transforms(snapshot, restored_snapshot);
+        restored_engine.cleanup();
+    }
+    physics_engine.cleanup();
+    std::error_code error{};
+    std::filesystem::remove(path, error);
+    spdlog::set_level(spdlog::level::info);
+
+    if (!save_stats._succeeded || !restored)
+    {
+        spdlog::error("Checkpoint round trip failed");
+        return 1;
+    }
+    spdlog::info("Checkpoint of {} spheres: {:.2f} MB",
+                 spheres,
+                 static_cast<double>(save_stats._bytes) / (1'024.0 * 1'024.0));
+    spdlog::info("  capture {:.3f} ms on the simulation thread, ticks while "
+                 "saving mean {:.3f} ms, max {:.3f} ms",
+                 capture_milliseconds,
+                 ticks_while_saving._total_milliseconds / kCompareTicks,
+                 ticks_while_saving._max_milliseconds);
+    spdlog::info("  save {:.3f} ms in the background, {:.1f} MB/s",
+                 save_stats._milliseconds,
+                 save_stats.megabytes_per_second());
+    CheckpointIoStats total_load_stats{load_stats};
+    total_load_stats._milliseconds += restore_milliseconds;
+    spdlog::info("  load {:.3f} ms, {:.1f} MB/s; with restoring the world and "
+                 "bodies {:.3f} ms, {:.1f} MB/s",
+                 load_stats._milliseconds,
+                 load_stats.megabytes_per_second(),
+                 total_load_stats._milliseconds,
+                 total_load_stats.megabytes_per_second());
+    if (!identical)
+    {
+        spdlog::error("  the restored simulation diverged within {} ticks",
+                      kCompareTicks);
+        return 1;
+    }
+    spdlog::info("  restored simulation identical after {} ticks",
+                 kCompareTicks);
+    return 0;
+}
+
+int run_particle_benchmark(const int particles, const int ticks)
+{
+    constexpr float kDeltaTime{1.F / 60.F};
+    const float lifetime{kDeltaTime * static_cast<float>(ticks + 1)};
+    const ParticleSettings settings{};
+
+    ParticleSystem particle_system{};
+    const auto run{[&](const bool vectorised) {
+        fill_particles(particle_system, particles, lifetime);
+        PhaseTimings timings{};
+        for (int tick{0}; tick < ticks; ++tick)
+        {
+            timings.record(time_milliseconds([&]() {
+                if (vectorised)
+                {
+                    particle_system.integrate(kDeltaTime, settings);
+                }
+                else
+                {
+                    particle_system.integrate_scalar(kDeltaTime, settings);
+                }
+            }));
+        }
+        return timings;
+    }};
+
+    spdlog::info("Integrating {} particles for {} ticks", particles, ticks);
+    const PhaseTimings scalar{run(false)};
+    const PhaseTimings vectorised{run(true)};
+
+    const auto log_kernel{[particles, ticks](const char *label,
+                                             const PhaseTimings &timings) {
+        const double mean{timings._total_milliseconds /
+                          static_cast<double>(ticks)};
+        spdlog::info("  {}: mean {:.3f} ms, max {:.3f} ms per tick, "
+                     "{:.0f} M particles/s",
+                     label,
+                     mean,
+                     timings._max_milliseconds,
+                     static_cast<double>(particles) / (mean * 1'000.0));
+        return mean;
+    }};
+    const double scalar_mean{log_kernel("Scalar", scalar)};
+    const double vectorised_mean{
+        log_kernel(ParticleSystem::kernel_name(), vectorised)};
+    spdlog::info("  speed up {:.2f}x", scalar_mean / vectorised_mean);
+
+    if (vectorised_mean > constants::kParticleBudgetMilliseconds)
+    {
+        spdlog::error("Particle integration took {:.3f} ms per tick, over "
+                      "the {:.1f} ms budget",
+                      vectorised_mean,
+                      constants::kParticleBudgetMilliseconds);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef SRC_HEADLESS_H
+#define SRC_HEADLESS_H
+
+#include <string>
+
+// Step the default scene for a number of ticks without opening a window, on
+// the calling thread, then report what it used. A non-empty trace_path
+// records a body trace of the run.
+int run_headless(int ticks, const std::string &trace_path);
+
+// Spawn and despawn thousands of spheres per second, once destroying bodies,
+// once recycling them through the body pool and once through the physics
+// command buffer, and compare the timings
+int run_churn_stress(int ticks);
+
+// Save a scene of falling spheres mid-simulation, load it into a fresh world
+// and engine, and check both carry on identically. Reports save and load
+// throughput.
+int run_checkpoint_round_trip(int spheres);
+
+// Integrate a full ParticleSystem, once a particle at a time and once with
+// the vector kernel, and compare the timings. Fails if the vector kernel's
+// mean tick is over constants::kParticleBudgetMilliseconds.
+int run_particle_benchmark(int particles, int ticks);
+
+#endif
@@ -0,0 +1,74 @@
+#include "history.h"
+
+#include "constants.h"
+
+#include <algorithm>
+#include <cstddef>
+
+void HistoryRing::push(const float value)
+{
+    _values[_next] = value;
+    _next = (_next + 1) % constants::kHistoryCapacity;
+    _size = std::min(_size + 1, constants::kHistoryCapacity);
+}
+
+void HistoryRing::clear()
+{
+    _next = 0;
+    _size = 0;
+}
+
+std::size_t HistoryRing::size() const
+{
+    return _size;
+}
+
+float HistoryRing::at(const std::size_t index) const
+{
+    const std::size_t capacity{constants::kHistoryCapacity};
+    return _values[(_next + capacity - _size + index) % capacity];
+}
+
+std::size_t decimate_min_max(const HistoryRing &ring,
+                             const std::size_t window,
+                             HistoryPlot &plot)
+{
+    const std::size_t samples{std::min(window, ring.size())};
+    const std::size_t first{ring.size() - samples};
+    if (samples <= plot.size())
+    {
+        for (std::size_t index{0}; index < samples; ++index)
+        {
+            plot[index] = ring.at(first + index);
+        }
+        return samples;
+    }
+
+    const std::size_t columns{constants::kHistoryPlotColumns};
+    for (std::size_t column{0}; column < columns; ++column)
+    {
+        const std::size_t begin{first + column * samples / columns};
+        const std::size_t end{first + (column + 1) * samples / columns};
+        std::size_t min_index{begin};
+        std::size_t max_index{begin};
+        float min_value{ring.at(begin)};
+        float max_value{min_value};
+        for (std::size_t index{begin + 1}; index < end; ++index)
+        {
+            const float value{ring.at(index)};
+            if (value < min_value)
+            {
+                min_index = index;
+                min_value = value;
+            }
+            if (value > max_value)
+            {
+                max_index = index;
+                max_value = value;
+            }
+        }
+        plot[2 * column] = min_index <= max_index ? min_value : max_value;
+        plot[2 * column + 1] = min_index <= max_index ? max_value : min_value;
+    }
+    return plot.size();
+}
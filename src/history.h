@@ -0,0 +1,70 @@
+#ifndef SRC_HISTORY_H
+#define SRC_HISTORY_H
+
+#include "constants.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Fields an entity's History can record, one ring buffer each
+enum class HistoryField : std::uint8_t
+{
+    kPositionX,
+    kPositionY,
+    kPositionZ,
+    kVelocityX,
+    kVelocityY,
+    kVelocityZ,
+    kSpeed,
+    kCount,
+};
+
+inline constexpr std::size_t kHistoryFieldCount{
+    static_cast<std::size_t>(HistoryField::kCount)};
+inline constexpr std::array<const char *, kHistoryFieldCount>
+    kHistoryFieldLabels{"Position x",
+                        "Position y",
+                        "Position z",
+                        "Velocity x",
+                        "Velocity y",
+                        "Velocity z",
+                        "Speed"};
+
+constexpr std::uint32_t history_field_bit(const HistoryField field)
+{
+    return 1U << static_cast<std::uint32_t>(field);
+}
+
+// The last kHistoryCapacity samples of one value, overwriting the oldest
+class HistoryRing
+{
+public:
+    HistoryRing() = default;
+
+    // mutator methods
+    void push(float value);
+    void clear();
+
+    // accessor methods
+    [[nodiscard]] std::size_t size() const;
+    // index 0 is the oldest sample held
+    [[nodiscard]] float at(std::size_t index) const;
+
+private:
+    std::array<float, constants::kHistoryCapacity> _values{};
+    std::size_t _next{0};
+    std::size_t _size{0};
+};
+
+// Plot points for the newest `window` samples of a ring. Up to two points per
+// column are copied as they are. Longer windows are split into one bucket
+// per column, each drawn as its minimum and maximum in the order they
+// happened, so a plot costs the same however many samples it covers and
+// still shows every spike. Returns the number of points written.
+using HistoryPlot = std::array<float, 2 * constants::kHistoryPlotColumns>;
+std::size_t decimate_min_max(const HistoryRing &ring,
+                             std::size_t window,
+                             HistoryPlot &plot);
+
+#endif
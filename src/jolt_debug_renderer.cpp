@@ -0,0 +1,266 @@
+#include "jolt_debug_renderer.h"
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+#ifdef JPH_DEBUG_RENDERER
+
+#include "debug_draw.h"
+
+#include <Jolt/Core/Color.h>
+#include <Jolt/Core/Core.h>
+#include <Jolt/Core/Reference.h>
+#include <Jolt/Geometry/AABox.h>
+#include <Jolt/Math/Float3.h>
+#include <Jolt/Math/Mat44.h>
+#include <Jolt/Math/Real.h>
+#include <Jolt/Math/Vec3.h>
+#include <Jolt/Math/Vec4.h>
+#include <Jolt/Renderer/DebugRenderer.h>
+#include <raylib.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// A DebugMesh that Jolt holds references to, freed with the last one
+class DebugMeshBatch final : public JPH::RefTargetVirtual
+{
+public:
+    JPH_OVERRIDE_NEW_DELETE
+
+    explicit DebugMeshBatch(DebugMesh mesh) : _mesh{std::move(mesh)}
+    {
+    }
+
+    void AddRef() override
+    {
+        _references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Release() override
+    {
+        if (_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this; // NOLINT [cppcoreguidelines-owning-memory]
+        }
+    }
+
+    [[nodiscard]] const DebugMesh &mesh() const
+    {
+        return _mesh;
+    }
+
+private:
+    DebugMesh _mesh;
+    std::atomic<std::uint32_t> _references{0};
+};
+
+Vector3 to_vector(const JPH::Vec3 &value)
+{
+    return Vector3{value.GetX(), value.GetY(), value.GetZ()};
+}
+
+Vector3 to_vector(const JPH::Float3 &value)
+{
+    return Vector3{value.x, value.y, value.z};
+}
+
+Color to_colour(const JPH::Color &colour)
+{
+    return Color{colour.r, colour.g, colour.b, colour.a};
+}
+
+Matrix to_matrix(const JPH::Mat44 &matrix)
+{
+    const JPH::Vec4 x{matrix.GetColumn4(0)};
+    const JPH::Vec4 y{matrix.GetColumn4(1)};
+    const JPH::Vec4 z{matrix.GetColumn4(2)};
+    const JPH::Vec4 w{matrix.GetColumn4(3)};
+    Matrix result{};
+    result.m0 = x.GetX();
+    result.m1 = x.GetY();
+    result.m2 = x.GetZ();
+    result.m3 = x.GetW();
+    result.m4 = y.GetX();
+    result.m5 = y.GetY();
+    result.m6 = y.GetZ();
+    result.m7 = y.GetW();
+    result.m8 = z.GetX();
+    result.m9 = z.GetY();
+    result.m10 = z.GetZ();
+    result.m11 = z.GetW();
+    result.m12 = w.GetX();
+    result.m13 = w.GetY();
+    result.m14 = w.GetZ();
+    result.m15 = w.GetW();
+    return result;
+}
+
+void append_vertex(DebugMesh &mesh, const JPH::DebugRenderer::Vertex &vertex)
+{
+    mesh._positions.push_back(to_vector(vertex.mPosition));
+    mesh._normals.push_back(to_vector(vertex.mNormal));
+    mesh._colours.push_back(to_colour(vertex.mColor));
+}
+} // namespace
+
+JoltDebugRenderer::JoltDebugRenderer()
+{
+    // builds the shared unit shapes through CreateTriangleBatch, so it has to
+    // run once the overrides exist
+    Initialize();
+}
+
+void JoltDebugRenderer::begin(DebugVertexCollector &collector,
+                              const Vector3 &camera_position)
+{
+    _collector = &collector;
+    _camera_position =
+        JPH::Vec3{camera_position.x, camera_position.y, camera_position.z};
+}
+
+void JoltDebugRenderer::end()
+{
+    {
+        const std::lock_guard<std::mutex> lock{_step_lines_mutex};
+        _collector->append_lines(_step_lines);
+        _step_lines.clear();
+    }
+    _collector = nullptr;
+}
+
+void JoltDebugRenderer::DrawLine(const JPH::RVec3Arg inFrom,
+                                 const JPH::RVec3Arg inTo,
+                                 const JPH::ColorArg inColor)
+{
+    if (_collector != nullptr)
+    {
+        _collector->add_line(
+            to_vector(inFrom), to_vector(inTo), to_colour(inColor));
+        return;
+    }
+    // drawn from a job thread while the simulation steps
+    const std::lock_guard<std::mutex> lock{_step_lines_mutex};
+    _step_lines.push_back(DebugVertex{to_vector(inFrom), to_colour(inColor)});
+    _step_lines.push_back(DebugVertex{to_vector(inTo), to_colour(inColor)});
+}
+
+void JoltDebugRenderer::DrawTriangle(const JPH::RVec3Arg inV1,
+                                     const JPH::RVec3Arg inV2,
+                                     const JPH::RVec3Arg inV3,
+                                     const JPH::ColorArg inColor,
+                                     const ECastShadow /* inCastShadow */)
+{
+    if (_collector != nullptr)
+    {
+        _collector->add_triangle(
+            to_vector(inV1), to_vector(inV2), to_vector(inV3),
+            to_colour(inColor));
+        return;
+    }
+    // outlined, as only lines are held between steps
+    DrawLine(inV1, inV2, inColor);
+    DrawLine(inV2, inV3, inColor);
+    DrawLine(inV3, inV1, inColor);
+}
+
+JPH::DebugRenderer::Batch
+JoltDebugRenderer::CreateTriangleBatch(const Triangle *inTriangles,
+                                       const int inTriangleCount)
+{
+    DebugMesh mesh{};
+    const auto triangles{static_cast<std::size_t>(inTriangleCount)};
+    mesh._positions.reserve(3 * triangles);
+    mesh._normals.reserve(3 * triangles);
+    mesh._colours.reserve(3 * triangles);
+    mesh._indices.reserve(3 * triangles);
+    for (std::size_t triangle{0}; triangle < triangles; ++triangle)
+    {
+        for (const Vertex &vertex : inTriangles[triangle].mV)
+        {
+            mesh._indices.push_back(
+                static_cast<std::uint32_t>(mesh._positions.size()));
+            append_vertex(mesh, vertex);
+        }
+    }
+    return new DebugMeshBatch{std::move(mesh)}; // NOLINT
+}
+
+JPH::DebugRenderer::Batch
+JoltDebugRenderer::CreateTriangleBatch(const Vertex *inVertices,
+                                       const int inVertexCount,
+                                       const JPH::uint32 *inIndices,
+                                       const int inIndexCount)
+{
+    DebugMesh mesh{};
+    const auto vertices{static_cast<std::size_t>(inVertexCount)};
+    mesh._positions.reserve(vertices);
+    mesh._normals.reserve(vertices);
+    mesh._colours.reserve(vertices);
+    for (std::size_t vertex{0}; vertex < vertices; ++vertex)
+    {
+        append_vertex(mesh, inVertices[vertex]);
+    }
+    mesh._indices.assign(inIndices,
+                         inIndices + static_cast<std::size_t>(inIndexCount));
+    return new DebugMeshBatch{std::move(mesh)}; // NOLINT
+}
+
+void JoltDebugRenderer::DrawGeometry(const JPH::RMat44Arg inModelMatrix,
+                                     const JPH::AABox &inWorldSpaceBounds,
+                                     const float inLODScaleSq,
+                                     const JPH::ColorArg inModelColor,
+                                     const GeometryRef &inGeometry,
+                                     const ECullMode /* inCullMode */,
+                                     const ECastShadow /* inCastShadow */,
+                                     const EDrawMode inDrawMode)
+{
+    if (_collector == nullptr || inGeometry->mLODs.empty())
+    {
+        return;
+    }
+
+    // the first level whose range covers the camera, as Jolt's own
+    // renderers pick it
+    const float distance_squared{
+        inWorldSpaceBounds.GetSqDistanceTo(_camera_position)};
+    const LOD *lod{&inGeometry->mLODs.back()};
+    for (const LOD &candidate : inGeometry->mLODs)
+    {
+        if (distance_squared <=
+            inLODScaleSq * candidate.mDistance * candidate.mDistance)
+        {
+            lod = &candidate;
+            break;
+        }
+    }
+
+    const auto *batch{
+        static_cast<const DebugMeshBatch *>(lod->mTriangleBatch.GetPtr())};
+    if (batch != nullptr)
+    {
+        _collector->add_mesh(batch->mesh(),
+                             to_matrix(inModelMatrix),
+                             to_colour(inModelColor),
+                             inDrawMode == EDrawMode::Wireframe);
+    }
+}
+
+void JoltDebugRenderer::DrawText3D(const JPH::RVec3Arg /* inPosition */,
+                                   const std::string_view & /* inString */,
+                                   const JPH::ColorArg /* inColor */,
+                                   const float /* inHeight */)
+{
+    // Only the mass and sleep statistics draw text, and the Dev Panel does
+    // not turn those on
+}
+
+#endif
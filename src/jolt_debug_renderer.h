@@ -0,0 +1,83 @@
+#ifndef SRC_JOLT_DEBUG_RENDERER_H
+#define SRC_JOLT_DEBUG_RENDERER_H
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+// Jolt only has a debug renderer in builds with JPH_DEBUG_RENDERER, which its
+// CMake defines for Debug and Release but not Distribution
+#ifdef JPH_DEBUG_RENDERER
+
+#include "debug_draw.h"
+
+#include <Jolt/Core/Color.h>
+#include <Jolt/Geometry/AABox.h>
+#include <Jolt/Math/Real.h>
+#include <Jolt/Math/Vec3.h>
+#include <Jolt/Renderer/DebugRenderer.h>
+#include <raylib.h>
+
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Collects Jolt's debug drawing into a DebugVertexCollector instead of
+// drawing it. The geometry Jolt builds for its shapes is kept as DebugMesh
+// batches for as long as Jolt holds on to it, so each shape is tessellated
+// once and only transformed per frame. Contact manifolds are drawn by Jolt's
+// job threads while it steps; those lines are held until the next pass.
+class JoltDebugRenderer final : public JPH::DebugRenderer
+{
+public:
+    JoltDebugRenderer();
+    ~JoltDebugRenderer() override = default;
+    JoltDebugRenderer(const JoltDebugRenderer &) = delete;
+    JoltDebugRenderer &operator=(const JoltDebugRenderer &) = delete;
+    JoltDebugRenderer(JoltDebugRenderer &&) = delete;
+    JoltDebugRenderer &operator=(JoltDebugRenderer &&) = delete;
+
+    // mutator methods
+    // Drawing between begin and end goes to collector. The camera position
+    // picks each shape's level of detail.
+    void begin(DebugVertexCollector &collector, const Vector3 &camera_position);
+    void end();
+
+    // See: DebugRenderer
+    void DrawLine(JPH::RVec3Arg inFrom,
+                  JPH::RVec3Arg inTo,
+                  JPH::ColorArg inColor) override;
+    void DrawTriangle(JPH::RVec3Arg inV1,
+                      JPH::RVec3Arg inV2,
+                      JPH::RVec3Arg inV3,
+                      JPH::ColorArg inColor,
+                      ECastShadow inCastShadow) override;
+    Batch CreateTriangleBatch(const Triangle *inTriangles,
+                              int inTriangleCount) override;
+    Batch CreateTriangleBatch(const Vertex *inVertices,
+                              int inVertexCount,
+                              const JPH::uint32 *inIndices,
+                              int inIndexCount) override;
+    void DrawGeometry(JPH::RMat44Arg inModelMatrix,
+                      const JPH::AABox &inWorldSpaceBounds,
+                      float inLODScaleSq,
+                      JPH::ColorArg inModelColor,
+                      const GeometryRef &inGeometry,
+                      ECullMode inCullMode,
+                      ECastShadow inCastShadow,
+                      EDrawMode inDrawMode) override;
+    void DrawText3D(JPH::RVec3Arg inPosition,
+                    const std::string_view &inString,
+                    JPH::ColorArg inColor,
+                    float inHeight) override;
+
+private:
+    DebugVertexCollector *_collector{nullptr};
+    JPH::Vec3 _camera_position{JPH::Vec3::sZero()};
+    std::mutex _step_lines_mutex{};
+    std::vector<DebugVertex> _step_lines{};
+};
+
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+#include "jolt_runtime.h"
+
+#include "flight_recorder.h"
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+#include <Jolt/Core/Core.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/IssueReporting.h>
+#include <Jolt/Core/Memory.h>
+#include <Jolt/RegisterTypes.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+namespace
+{
+std::mutex runtime_mutex;
+int runtime_references{0};
+
+// Callback for traces, connect this to your own trace function if you have one
+void TraceImpl(const char *inFMT, ...)
+{
+    // Format the message
+    va_list list;
+    va_start(list, inFMT);
+    char buffer[1'024];
+    vsnprintf(buffer, sizeof(buffer), inFMT, list);
+    va_end(list);
+
+    // as a warning, so the flight recorder keeps it too
+    spdlog::warn("Jolt: {}", buffer);
+}
+
+#ifdef JPH_ENABLE_ASSERTS
+
+// Callback for asserts, connect this to your own assert handler if you have one
+bool AssertFailedImpl(const char *inExpression,
+                      const char *inMessage,
+                      const char *inFile,
+                      JPH::uint inLine)
+{
+    spdlog::error("{}:{}: ({}) {}",
+                  inFile,
+                  inLine,
+                  inExpression,
+                  inMessage != nullptr ? inMessage : "");
+
+    // keep what led up to it, before the debugger or a crash takes over
+    FlightRecorder &recorder{flight_recorder()};
+    recorder.record_assert(
+        inExpression, inMessage, inFile, static_cast<std::uint32_t>(inLine));
+    if (recorder.dump(FlightDumpReason::kAssert))
+    {
+        spdlog::error("Saved flight recording {}", recorder.dump_path());
+    }
+
+    // Breakpoint
+    return true;
+}
+
+#endif // JPH_ENABLE_ASSERTS
+} // namespace
+
+JoltRuntime::JoltRuntime()
+{
+    const std::lock_guard<std::mutex> lock{runtime_mutex};
+    if (runtime_references++ > 0)
+    {
+        return;
+    }
+
+    // Register allocation hook. In this example we'll just let Jolt use malloc /
+    // free but you can override these if you want (see Memory.h). This needs to
+    // be done before any other Jolt function is called.
+    JPH::RegisterDefaultAllocator();
+
+    // Install trace and assert callbacks
+    JPH::Trace = TraceImpl;
+    JPH_IF_ENABLE_ASSERTS(JPH::AssertFailed = AssertFailedImpl;)
+
+    // Create a factory, this class is responsible for creating instances of
+    // classes based on their name or hash and is mainly used for deserialization
+    // of saved data. It is not directly used in this example but still required.
+    JPH::Factory::sInstance = new JPH::Factory();
+
+    // Register all physics types with the factory and install their collision
+    // handlers with the CollisionDispatch class. If you have your own custom
+    // shape types you probably need to register their handlers with the
+    // CollisionDispatch before calling this function. If you implement your own
+    // default material (PhysicsMaterial::sDefault) make sure to initialize it
+    // before this function or else this function will create one for you.
+    JPH::RegisterTypes();
+}
+
+JoltRuntime::~JoltRuntime()
+{
+    const std::lock_guard<std::mutex> lock{runtime_mutex};
+    if (--runtime_references > 0)
+    {
+        return;
+    }
+
+    // Unregisters all types with the factory and cleans up the default material
+    JPH::UnregisterTypes();
+
+    // Destroy the factory
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+}
+
+int JoltRuntime::reference_count()
+{
+    const std::lock_guard<std::mutex> lock{runtime_mutex};
+    return runtime_references;
+}
@@ -0,0 +1,22 @@
+#ifndef SRC_JOLT_RUNTIME_H
+#define SRC_JOLT_RUNTIME_H
+
+// Process-wide Jolt state: the allocator, the trace and assert callbacks, the
+// factory and the registered types. The first JoltRuntime sets it up and the
+// last one to be destroyed tears it down, so any number of PhysicsEngines can
+// exist at once, on any thread.
+class JoltRuntime
+{
+public:
+    JoltRuntime();
+    ~JoltRuntime();
+    JoltRuntime(const JoltRuntime &) = delete;
+    JoltRuntime &operator=(const JoltRuntime &) = delete;
+    JoltRuntime(JoltRuntime &&) = delete;
+    JoltRuntime &operator=(JoltRuntime &&) = delete;
+
+    // accessor methods
+    [[nodiscard]] static int reference_count();
+};
+
+#endif
@@ -1,8 +1,32 @@
+#include "baked_font.h"
+#include "batch_runner.h"
+#include "command_line.h"
 #include "components.h"
 #include "constants.h"
+#include "debug_draw.h"
+#include "flecs_stats.h"
+#include "flight_recorder.h"
+#include "flight_recorder_sink.h"
 #include "game/game.h"
+#include "headless.h"
+#include "memory_stats.h"
+#include "particles.h"
 #include "physics.h"
+#include "physics_commands.h"
+#include "physics_thread.h"
+#include "profiler.h"
+#include "regression.h"
+#include "spatial_query.h"
+#include "sphere_lod.h"
+#include "sphere_lod_renderer.h"
+#include "startup_timer.h"
+#include "static_geometry_renderer.h"
 #include "systems.h"
+#include "tick_scheduler.h"
+#include "transform_snapshot.h"
+#include "viewport.h"
+#include "world_checkpoint.h"
+#include "world_partition.h"
 
 #include <flecs/addons/cpp/entity.hpp>
 #include <flecs/addons/cpp/flecs.hpp>
@@ -13,9 +37,17 @@
 #include <rlImGui.h>
 #include <spdlog/spdlog.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <memory>
 #include <queue>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 void setup_camera_system(Camera3D &camera)
 {
@@ -29,35 +61,279 @@ void setup_camera_system(Camera3D &camera)
     camera.projection = CAMERA_PERSPECTIVE;
 }
 
-int main(int /* argc */, char ** /* argv */)
+struct SceneQueries
 {
+    flecs::query<const Position, const GridComponent> _static_grid;
+    flecs::query<const Position, const BoxCollider> _static_colliders;
+    flecs::query<const Position, const SphereMesh, SphereLod> _select_sphere_lod;
+    flecs::query<const Position,
+                 const SphereMesh,
+                 const SphereLod,
+                 const RigidBodyTransform *,
+                 const DevPanelState>
+        _draw_sphere;
+};
+
+void draw_scene(const Camera3D &camera,
+                const float viewport_height,
+                const SceneQueries &scene_queries,
+                SphereLodView &sphere_lod_view,
+                SphereLodRenderer &sphere_lod_renderer,
+                StaticGeometryRenderer &static_geometry_renderer,
+                const DebugVertexCollector &physics_debug,
+                const ParticleSystem &particles,
+                const ParticleSettings &particle_settings)
+{
+    bake_static_geometry_system(scene_queries._static_grid,
+                                scene_queries._static_colliders,
+                                static_geometry_renderer);
+    select_sphere_lod_system(scene_queries._select_sphere_lod,
+                             camera,
+                             viewport_height,
+                             sphere_lod_view);
+
+    BeginMode3D(camera);
+    draw_static_geometry_system(static_geometry_renderer);
+    draw_sphere_system(scene_queries._draw_sphere, sphere_lod_renderer, camera);
+    draw_physics_debug_system(physics_debug);
+    draw_particles_system(particles, particle_settings);
+    EndMode3D();
+}
+
+// A missing count argument keeps its default. One that is not a whole number
+// from 1 to maximum is reported, and false returned.
+bool read_count_argument(const std::vector<std::string_view> &arguments,
+                         const std::size_t index,
+                         const char *name,
+                         const int maximum,
+                         int &count)
+{
+    if (index >= arguments.size() ||
+        parse_number(arguments[index], 1, maximum, count))
+    {
+        return true;
+    }
+    spdlog::error("{} must be a whole number from 1 to {}, not \"{}\"",
+                  name,
+                  maximum,
+                  arguments[index]);
+    return false;
+}
+
+RenderMemoryStats collect_render_memory_stats(
+    const RenderTexture &game_texture,
+    const RenderTexture &debug_texture,
+    const Font &font,
+    const SphereLodRenderer &sphere_lod_renderer,
+    const StaticGeometryRenderer &static_geometry_renderer)
+{
+    RenderMemoryStats stats{};
+    stats._game_texture_bytes = render_texture_bytes(game_texture);
+    stats._debug_texture_bytes = render_texture_bytes(debug_texture);
+    stats._font_atlas_bytes = texture_bytes(font.texture);
+    stats._mesh_bytes = sphere_lod_renderer.gpu_bytes() +
+                        static_geometry_renderer.gpu_bytes();
+    return stats;
+}
+
+int main(int argc, char **argv)
+{
+    // --headless [ticks] runs the simulation without a window and dumps stats,
+    // --churn [ticks] runs the body pool spawn/despawn stress scenario,
+    // --regression <scene> <baseline> <output> runs one frame-time regression
+    // scene for CTest, --record-baseline <scene> <baseline> <output> <machine>
+    // records it into the baseline instead,
+    // --batch [worlds] [ticks] runs independent worlds across every core,
+    // --checkpoint [spheres] saves and reloads a scene and checks it resumes
+    // identically, --load <checkpoint> starts from a saved checkpoint,
+    // --trace <path> records a body trace with --headless or the window,
+    // --particles [count] [ticks] benchmarks the particle kernel
+    const std::vector<std::string_view> arguments(argv, argv + argc);
+
+    // The flight recorder is always on. It is dumped on a Jolt assert, on a
+    // crash, and with F6.
+    install_flight_recorder_signal_handlers();
+    spdlog::default_logger()->sinks().push_back(
+        std::make_shared<FlightRecorderSink>());
+    std::string trace_path{};
+    for (std::size_t index{1}; index + 1 < arguments.size(); ++index)
+    {
+        if (arguments[index] == "--trace")
+        {
+            trace_path = arguments[index + 1];
+        }
+    }
+    // counts are checked up front, so a typo fails instead of running 0 ticks
+    constexpr int kMaxTicks{1'000'000};
+    if (arguments.size() > 1 && arguments[1] == "--headless")
+    {
+        constexpr int kDefaultHeadlessTicks{600};
+        int ticks{kDefaultHeadlessTicks};
+        if (arguments.size() > 2 && arguments[2] != "--trace" &&
+            !read_count_argument(arguments, 2, "Ticks", kMaxTicks, ticks))
+        {
+            return EXIT_FAILURE;
+        }
+        return run_headless(ticks, trace_path);
+    }
+    if (arguments.size() > 1 && arguments[1] == "--churn")
+    {
+        constexpr int kDefaultChurnTicks{600};
+        int ticks{kDefaultChurnTicks};
+        if (!read_count_argument(arguments, 2, "Ticks", kMaxTicks, ticks))
+        {
+            return EXIT_FAILURE;
+        }
+        return run_churn_stress(ticks);
+    }
+    if (arguments.size() > 1 && arguments[1] == "--particles")
+    {
+        constexpr auto kMaxParticles{
+            static_cast<int>(constants::kMaxParticles)};
+        constexpr int kDefaultParticleTicks{300};
+        int particles{kMaxParticles};
+        int ticks{kDefaultParticleTicks};
+        if (!read_count_argument(
+                arguments, 2, "Particles", kMaxParticles, particles) ||
+            !read_count_argument(arguments, 3, "Ticks", kMaxTicks, ticks))
+        {
+            return EXIT_FAILURE;
+        }
+        return run_particle_benchmark(particles, ticks);
+    }
+    if (arguments.size() > 4 && arguments[1] == "--regression")
+    {
+        return run_regression(argv[2], argv[3], argv[4]);
+    }
+    if (arguments.size() > 5 && arguments[1] == "--record-baseline")
+    {
+        return record_regression_baseline(argv[2], argv[3], argv[4], argv[5]);
+    }
+    if (arguments.size() > 1 && arguments[1] == "--batch")
+    {
+        constexpr int kMaxBatchWorlds{4'096};
+        constexpr int kDefaultBatchWorlds{64};
+        constexpr int kDefaultBatchTicks{300};
+        int worlds{kDefaultBatchWorlds};
+        int ticks{kDefaultBatchTicks};
+        if (!read_count_argument(
+                arguments, 2, "Worlds", kMaxBatchWorlds, worlds) ||
+            !read_count_argument(arguments, 3, "Ticks", kMaxTicks, ticks))
+        {
+            return EXIT_FAILURE;
+        }
+        return run_batch(worlds, ticks);
+    }
+    if (arguments.size() > 1 && arguments[1] == "--checkpoint")
+    {
+        // the scene's body pair and contact capacities are four per sphere
+        constexpr int kMaxCheckpointSpheres{1'000'000};
+        constexpr int kDefaultCheckpointSpheres{10'000};
+        int spheres{kDefaultCheckpointSpheres};
+        if (!read_count_argument(
+                arguments, 2, "Spheres", kMaxCheckpointSpheres, spheres))
+        {
+            return EXIT_FAILURE;
+        }
+        return run_checkpoint_round_trip(spheres);
+    }
+    const std::string checkpoint_path{
+        arguments.size() > 2 && arguments[1] == "--load" ? argv[2] : ""};
+
+    StartupTimer startup_timer{};
+    // declared before the world, as the collider observers record into it
+    // until the world is gone
+    PhysicsCommandBuffer physics_commands{};
     const flecs::world world;
-    spawn_floor_system(world);
-    spawn_sphere_system(world);
-    flecs::entity dev_panel_state_entity = world.entity<DevPanelState>();
-    dev_panel_state_entity.set<DevPanelState>({0});
+    PhysicsEngine physics_engine{};
+
+    // World and physics setup never touch the GL context, so they run on a
+    // worker while the window comes up. Neither the world nor the engine is
+    // used on this thread until the worker has been joined.
+    std::future<void> world_setup{std::async(
+        std::launch::async,
+        [&world, &physics_engine, &startup_timer, &checkpoint_path]() {
+            // an unreadable checkpoint falls back to the default scene, but
+            // one that fails half way through restoring cannot
+            WorldCheckpoint checkpoint{};
+            bool checkpoint_read{false};
+            if (!checkpoint_path.empty())
+            {
+                const ScopedStartupPhase phase{
+                    startup_timer, "Read checkpoint", "worker"};
+                checkpoint_read =
+                    read_world_checkpoint(checkpoint_path, checkpoint)
+                        ._succeeded;
+            }
+            if (checkpoint_read)
+            {
+                const ScopedStartupPhase phase{
+                    startup_timer, "Restore checkpoint", "worker"};
+                if (!restore_world_checkpoint(
+                        checkpoint, world, physics_engine))
+                {
+                    throw std::runtime_error{"Could not restore checkpoint " +
+                                             checkpoint_path};
+                }
+                return;
+            }
+            {
+                const ScopedStartupPhase phase{
+                    startup_timer, "Spawn entities", "worker"};
+                spawn_floor_system(world);
+                spawn_sphere_system(world);
+                spawn_particle_emitter_system(world);
+                world.entity<DevPanelState>().set<DevPanelState>({0});
+            }
+            {
+                const ScopedStartupPhase phase{
+                    startup_timer, "Initialise physics", "worker"};
+                physics_engine.initialise();
+            }
+            {
+                const ScopedStartupPhase phase{
+                    startup_timer, "Create colliders", "worker"};
+                create_entity_colliders_system(world, physics_engine);
+            }
+            {
+                const ScopedStartupPhase phase{
+                    startup_timer, "Optimise broad phase", "worker"};
+                physics_engine.start_simulation();
+            }
+        })};
 
-    double tickTimer{0.0};
     std::queue<int> keyQueue{std::queue<int>()};
     bool debugMenu = false;
     const Vector2 windowSize{
         Vector2{constants::kWindowWidth, constants::kWindowHeight}};
     RenderTexture gameTexture;
+    // the debug view, scaled down from gameTexture or, with _render_direct,
+    // rendered into at its own resolution
     RenderTexture debugTexture;
 
-    SetWindowState(FLAG_MSAA_4X_HINT);
-    InitWindow(static_cast<int>(windowSize.x),
-               static_cast<int>(windowSize.y),
-               constants::kTitle.c_str());
-    rlImGuiSetup(true);
-    ImGui::GetStyle().ScaleAllSizes(constants::kUIScaleFactor);
-    ImGui::GetIO().FontGlobalScale = constants::kUIScaleFactor;
+    {
+        const ScopedStartupPhase phase{startup_timer, "Create window", "main"};
+        SetWindowState(FLAG_MSAA_4X_HINT);
+        InitWindow(static_cast<int>(windowSize.x),
+                   static_cast<int>(windowSize.y),
+                   constants::kTitle.c_str());
+    }
+    {
+        const ScopedStartupPhase phase{startup_timer, "Set up ImGui", "main"};
+        rlImGuiSetup(true);
+        ImGui::GetStyle().ScaleAllSizes(constants::kUIScaleFactor);
+        ImGui::GetIO().FontGlobalScale = constants::kUIScaleFactor;
+    }
 
-    gameTexture = LoadRenderTexture((int)windowSize.x, (int)windowSize.y);
     constexpr float kDebugScaleUp{1.5F};
-    debugTexture =
-        LoadRenderTexture(static_cast<int>(windowSize.x / kDebugScaleUp),
-                          static_cast<int>(windowSize.y / kDebugScaleUp));
+    {
+        const ScopedStartupPhase phase{
+            startup_timer, "Create render textures", "main"};
+        gameTexture = LoadRenderTexture((int)windowSize.x, (int)windowSize.y);
+        debugTexture =
+            LoadRenderTexture(static_cast<int>(windowSize.x / kDebugScaleUp),
+                              static_cast<int>(windowSize.y / kDebugScaleUp));
+    }
 
     const Rectangle source_rectangle{0,
                                      -windowSize.y,
@@ -70,20 +346,38 @@ int main(int /* argc */, char ** /* argv */)
     Camera3D camera{};
     setup_camera_system(camera);
 
-    constexpr int kMillisecondsPerSecond{1000};
-    const Font font{LoadFont(ASSETS_PATH "ibm-plex-mono-v19-latin-500.ttf")};
-
-    spdlog::info("Creating Physics Engine");
-    PhysicsEngine physics_engine{};
-
-    spdlog::info("Initialising Physics Engine");
-    physics_engine.initialise();
+    Font font{};
+    {
+        // the atlas is rasterised at build time, the TTF is only a fallback
+        const ScopedStartupPhase phase{startup_timer, "Load font", "main"};
+        if (!load_baked_font(font))
+        {
+            spdlog::warn("Baked font does not match this build, loading TTF");
+            font = LoadFont(ASSETS_PATH "ibm-plex-mono-v19-latin-500.ttf");
+        }
+    }
+    SphereLodRenderer sphere_lod_renderer{};
+    StaticGeometryRenderer static_geometry_renderer{};
+    {
+        const ScopedStartupPhase phase{startup_timer, "Load meshes", "main"};
+        sphere_lod_renderer.load();
+        static_geometry_renderer.load();
+    }
 
-    spdlog::info("Creating colliders");
-    create_entity_colliders_system(world, physics_engine);
+    // rethrows anything the worker threw
+    world_setup.get();
+    // colliders that exist now have their bodies, later ones go through the
+    // command buffer
+    observe_colliders_system(world, physics_commands);
+    if (!trace_path.empty())
+    {
+        physics_engine.start_trace(trace_path);
+    }
 
-    spdlog::info("Initiating Pre-simulation Optimisation");
-    physics_engine.start_simulation();
+    // From here on only the physics thread touches the engine directly
+    spdlog::info("Starting Physics Thread");
+    PhysicsThread physics_thread{physics_engine, constants::kTickrate};
+    physics_thread.start();
 
     const flecs::
         query<const Position, const Velocity, const SphereMesh, DevPanelState>
@@ -95,46 +389,246 @@ int main(int /* argc */, char ** /* argv */)
                                      .term_at(4)
                                      .singleton()
                                      .build()};
-    const flecs::query<const Position, const GridComponent> draw_grid_query{
-        world.query_builder<const Position, const GridComponent>().build()};
-    const flecs::query<const Position, const SphereMesh, const DevPanelState>
-        draw_sphere_query{world
-                              .query_builder<const Position,
-                                             const SphereMesh,
-                                             const DevPanelState>()
-                              .term_at(3)
-                              .singleton()
-                              .build()};
-
-    const flecs::query<const SphereCollider, Position, Velocity, DevPanelState>
-        update_sphere_query{world
-                                .query_builder<const SphereCollider,
-                                               Position,
-                                               Velocity,
-                                               DevPanelState>()
-                                .term_at(4)
-                                .singleton()
+    const SceneQueries scene_queries{
+        world.query_builder<const Position, const GridComponent>().build(),
+        world.query_builder<const Position, const BoxCollider>().build(),
+        world.query_builder<const Position, const SphereMesh, SphereLod>()
+            .build(),
+        world
+            .query_builder<const Position,
+                           const SphereMesh,
+                           const SphereLod,
+                           const RigidBodyTransform *,
+                           const DevPanelState>()
+            .term_at(5)
+            .singleton()
+            .build()};
+
+    const flecs::query<const Position,
+                       const SpatialQuery,
+                       const PhysicsBody *,
+                       SpatialQueryHits>
+        spatial_query_query{world
+                                .query_builder<const Position,
+                                               const SpatialQuery,
+                                               const PhysicsBody *,
+                                               SpatialQueryHits>()
                                 .build()};
 
+    const flecs::query<const Position,
+                       const PhysicsBody,
+                       const SphereCollider *,
+                       const BoxCollider *>
+        partition_query{world
+                            .query_builder<const Position,
+                                           const PhysicsBody,
+                                           const SphereCollider *,
+                                           const BoxCollider *>()
+                            .build()};
+    WorldPartition world_partition{};
+
+    const flecs::query<const Position, ParticleEmitter> emitter_query{
+        world.query_builder<const Position, ParticleEmitter>().build()};
+    ParticleSystem particles{};
+
+    const flecs::query<History> history_query{
+        world.query_builder<History>().build()};
+    const flecs::query<const Position, const Velocity, History>
+        record_history_query{
+            world.query_builder<const Position, const Velocity, History>()
+                .build()};
+
+    ViewportDirtyTracker viewport_tracker{};
+    SphereLodView sphere_lod_view{};
+    SnapshotSyncStats snapshot_sync_stats{};
+    DebugVertexCollector physics_debug{};
+    bool physics_debug_available{true};
+    bool physics_debug_drawn{false};
+
+    FrameProfiler frame_profiler{};
+    CheckpointWriter checkpoint_writer{};
+
+    // gameplay and telemetry run at their own rates, not every frame
+    TickScheduler tick_scheduler{world};
+    MemoryStats memory_stats{};
+    MemoryHistory memory_history{};
+    FlecsStatsHistory flecs_stats{};
+    const std::vector<NamedQuery> profiled_queries{
+        {"Dev Panel", draw_dev_panel_query.c_ptr()},
+        {"Static grid", scene_queries._static_grid.c_ptr()},
+        {"Static colliders", scene_queries._static_colliders.c_ptr()},
+        {"Sphere LOD", scene_queries._select_sphere_lod.c_ptr()},
+        {"Draw spheres", scene_queries._draw_sphere.c_ptr()},
+        {"Spatial queries", spatial_query_query.c_ptr()},
+        {"World partition", partition_query.c_ptr()},
+        {"Particle emitters", emitter_query.c_ptr()}};
+
     // We simulate the physics world in discrete time steps. 60 Hz is a good rate
     // to update the physics system.
     SetTargetFPS(constants::kTargetFramerate);
 
+    startup_timer.log();
     spdlog::info("Starting Simulation");
 
+    constexpr float kMillisecondsPerSecond{1'000.F};
+    std::uint64_t frame{0};
     while (!WindowShouldClose())
     {
-        const float frame_time{GetFrameTime()};
-        if (GetTime() - tickTimer >
-            static_cast<float>(kMillisecondsPerSecond) /
-                static_cast<float>(constants::kTickrate) /
-                static_cast<float>(kMillisecondsPerSecond))
+        frame_profiler.begin_frame();
+        flight_recorder().record_frame(frame++,
+                                       GetFrameTime() * kMillisecondsPerSecond);
+        tick_scheduler.advance(world, GetFrameTime());
+        if (tick_scheduler.ticked(TickSource::kGameplay))
         {
-            tickTimer = GetTime();
+            const ScopedTickWork work{tick_scheduler, TickSource::kGameplay};
             Game_Update(&keyQueue, &debugMenu);
         }
 
-        keyQueue.push(GetKeyPressed());
+        const int key_pressed{GetKeyPressed()};
+        keyQueue.push(key_pressed);
+        if (key_pressed != 0)
+        {
+            flight_recorder().record_key(key_pressed);
+        }
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        {
+            const Vector2 mouse_position{GetMousePosition()};
+            flight_recorder().record_mouse(
+                MOUSE_BUTTON_LEFT, mouse_position.x, mouse_position.y);
+        }
+
+        // Forward Dev Panel simulation controls to the physics thread
+        DevPanelState *dev_panel_state{world.get_mut<DevPanelState>()};
+        physics_thread.set_paused(dev_panel_state->_paused);
+        dev_panel_state->_inspected_entity = 0; // set again by the Dev Panel
+        if (dev_panel_state->_paused && dev_panel_state->_step)
+        {
+            physics_thread.request_step();
+            dev_panel_state->_step = false;
+        }
+
+        // F5 saves a checkpoint. The state is copied between physics steps
+        // and written out in the background.
+        if (IsKeyPressed(KEY_F5) && !checkpoint_writer.busy())
+        {
+            const ScopedProfile profile{frame_profiler, "Capture checkpoint"};
+            // parked entities are disabled, which the capture would skip, so
+            // bring the whole world back first; streaming parks the far cells
+            // again over the next frames
+            unpark_world_partition_system(
+                world, world_partition, physics_thread);
+            WorldCheckpoint checkpoint{};
+            physics_thread.with_engine(
+                [&world, &checkpoint](const PhysicsEngine &engine) {
+                    capture_world_checkpoint(world, engine, checkpoint);
+                });
+            checkpoint_writer.save(std::move(checkpoint),
+                                   constants::kCheckpointPath);
+        }
+        // F6 saves what the flight recorder holds, written on this thread
+        // as it is small
+        if (IsKeyPressed(KEY_F6))
+        {
+            FlightRecorder &recorder{flight_recorder()};
+            if (recorder.dump(FlightDumpReason::kRequested))
+            {
+                spdlog::info("Saved flight recording {}", recorder.dump_path());
+            }
+            else
+            {
+                spdlog::error("Could not save flight recording {}",
+                              recorder.dump_path());
+            }
+        }
+        CheckpointIoStats checkpoint_stats{};
+        if (checkpoint_writer.poll(checkpoint_stats) &&
+            checkpoint_stats._succeeded)
+        {
+            spdlog::info("Saved checkpoint {}, {} bytes in {:.2f} ms, "
+                         "{:.1f} MB/s",
+                         constants::kCheckpointPath,
+                         checkpoint_stats._bytes,
+                         checkpoint_stats._milliseconds,
+                         checkpoint_stats.megabytes_per_second());
+        }
+
+        // give colliders set or removed since the last frame their bodies,
+        // added and removed together between two steps
+        if (!physics_commands.empty())
+        {
+            const ScopedProfile profile{frame_profiler, "Physics commands"};
+            resolve_physics_commands_system(world, physics_commands);
+            physics_thread.with_engine(
+                [&physics_commands](PhysicsEngine &engine) {
+                    engine.apply_body_commands(physics_commands.commands());
+                });
+            write_physics_bodies_system(world, physics_commands);
+        }
+
+        {
+            const ScopedProfile profile{frame_profiler, "World partition"};
+            stream_world_partition_system(world,
+                                          partition_query,
+                                          camera.position,
+                                          dev_panel_state->_partition,
+                                          world_partition,
+                                          physics_thread);
+        }
+
+        // pick up the latest finished physics step, if there is a new one
+        if (physics_thread.acquire_snapshot())
+        {
+            const ScopedProfile profile{frame_profiler, "Apply snapshot"};
+            apply_transform_snapshot_system(
+                world, physics_thread.snapshot(), snapshot_sync_stats);
+            write_spatial_query_results_system(
+                world, physics_thread.snapshot()._spatial_query_results);
+            record_history_system(record_history_query);
+        }
+
+        // hand this frame's spatial queries to the physics thread, which
+        // answers them after each step without the render thread waiting
+        {
+            const ScopedProfile profile{frame_profiler, "Spatial queries"};
+            collect_spatial_queries_system(spatial_query_query,
+                                           physics_thread.spatial_query_batch());
+            physics_thread.submit_spatial_queries();
+        }
+
+        // collect the physics debug view between two steps, and once more
+        // after it is switched off so contact drawing stops
+        const DebugDrawSettings &debug_draw{dev_panel_state->_physics_debug};
+        const bool physics_debug_changed{
+            physics_debug_available &&
+            (debug_draw._enabled || physics_debug_drawn)};
+        if (physics_debug_changed)
+        {
+            const ScopedProfile profile{frame_profiler, "Physics debug view"};
+            physics_thread.with_engine([&debug_draw,
+                                        &camera,
+                                        &physics_debug,
+                                        &physics_debug_available](
+                                           PhysicsEngine &engine) {
+                physics_debug_available = engine.draw_debug(
+                    debug_draw, camera.position, physics_debug);
+            });
+            physics_debug_drawn = debug_draw._enabled;
+        }
+
+        // visual only, so particles move with the frame rather than the
+        // physics step
+        const ParticleSettings &particle_settings{dev_panel_state->_particles};
+        if (!dev_panel_state->_paused &&
+            (particle_settings._emitting || !particles.empty()))
+        {
+            const ScopedProfile profile{frame_profiler, "Particles"};
+            const float frame_time{GetFrameTime()};
+            if (particle_settings._emitting)
+            {
+                emit_particles_system(emitter_query, frame_time, particles);
+            }
+            particles.integrate(frame_time, particle_settings);
+        }
 
         BeginDrawing();
         rlImGuiBegin();
@@ -142,25 +636,101 @@ int main(int /* argc */, char ** /* argv */)
 
         if (debugMenu)
         {
-            BeginTextureMode(gameTexture);
-            ClearBackground(RAYWHITE);
-            BeginMode3D(camera);
-            draw_grid_system(draw_grid_query);
-            draw_sphere_system(draw_sphere_query);
-            EndMode3D();
-            draw_scene_text_system(font);
-            EndTextureMode();
+            // Query change detection has to be checked before the draw
+            // systems iterate the queries, as iterating resets it
+            const bool scene_changed{
+                scene_queries._draw_sphere.changed() ||
+                scene_queries._static_grid.changed() ||
+                scene_queries._static_colliders.changed() ||
+                physics_debug_changed || !particles.empty()};
+            if (viewport_tracker.needs_redraw(camera,
+                                              scene_changed,
+                                              *dev_panel_state))
+            {
+                {
+                    const ScopedProfile profile{frame_profiler,
+                                                "Render scene"};
+                    RenderTexture &scene_texture{
+                        dev_panel_state->_render_direct ? debugTexture
+                                                        : gameTexture};
+                    const auto scene_height{
+                        static_cast<float>(scene_texture.texture.height)};
+                    BeginTextureMode(scene_texture);
+                    ClearBackground(RAYWHITE);
+                    draw_scene(camera,
+                               scene_height,
+                               scene_queries,
+                               sphere_lod_view,
+                               sphere_lod_renderer,
+                               static_geometry_renderer,
+                               physics_debug,
+                               particles,
+                               particle_settings);
+                    EndTextureMode();
+                }
+                if (!dev_panel_state->_render_direct)
+                {
+                    const ScopedProfile profile{frame_profiler,
+                                                "Present viewport"};
+                    BeginTextureMode(debugTexture);
+                    DrawTexturePro(gameTexture.texture,
+                                   source_rectangle,
+                                   destination_rectangle,
+                                   {0, 0},
+                                   0.F,
+                                   RAYWHITE);
+                    EndTextureMode();
+                }
+            }
 
-            BeginTextureMode(debugTexture);
-            DrawTexturePro(gameTexture.texture,
-                           source_rectangle,
-                           destination_rectangle,
-                           {0, 0},
-                           0.F,
-                           RAYWHITE);
-            EndTextureMode();
+            // memory and flecs statistics are sampled, not collected every
+            // frame
+            if (tick_scheduler.ticked(TickSource::kTelemetry))
+            {
+                const ScopedTickWork work{tick_scheduler,
+                                          TickSource::kTelemetry};
+                {
+                    const ScopedProfile profile{frame_profiler,
+                                                "Memory stats"};
+                    memory_stats._flecs = collect_flecs_memory_stats(world);
+                    physics_thread.with_engine(
+                        [&memory_stats](const PhysicsEngine &engine) {
+                            memory_stats._jolt = engine.memory_stats();
+                        });
+                    memory_stats._render = collect_render_memory_stats(
+                        gameTexture,
+                        debugTexture,
+                        font,
+                        sphere_lod_renderer,
+                        static_geometry_renderer);
+                    memory_history.record(memory_stats);
+                }
+                {
+                    const ScopedProfile profile{frame_profiler, "flecs stats"};
+                    flecs_stats.collect(world, profiled_queries);
+                }
+            }
 
-            draw_dev_panel_system(draw_dev_panel_query);
+            {
+                const ScopedProfile profile{frame_profiler, "Dev Panel"};
+                draw_dev_panel_system(draw_dev_panel_query,
+                                      physics_thread.snapshot(),
+                                      snapshot_sync_stats);
+                draw_physics_debug_panel_system(physics_debug,
+                                                physics_debug_available,
+                                                dev_panel_state->_physics_debug);
+                draw_world_partition_panel_system(
+                    world_partition, dev_panel_state->_partition);
+                draw_particles_panel_system(particles,
+                                            dev_panel_state->_particles);
+                draw_viewport_panel_system(viewport_tracker,
+                                           sphere_lod_renderer.stats(),
+                                           *dev_panel_state);
+                draw_memory_panel_system(memory_stats, memory_history);
+                draw_flecs_stats_panel_system(flecs_stats);
+                draw_tick_scheduler_panel_system(tick_scheduler);
+                draw_profiler_panel_system(frame_profiler);
+            }
 
             ImGui::Begin(
                 "Jolt raylib Hello World!",
@@ -170,24 +740,77 @@ int main(int /* argc */, char ** /* argv */)
                     static_cast<uint8_t>(ImGuiWindowFlags_NoResize) |
                     static_cast<uint8_t>(ImGuiWindowFlags_NoBackground));
             rlImGuiImageRenderTexture(&debugTexture);
+            // The scene text changes every frame, so ImGui draws it over the
+            // image and the kept scene texture is left as it is
+            const ImVec2 image_origin{ImGui::GetItemRectMin()};
+            draw_scene_text_overlay_system(
+                Vector2{image_origin.x, image_origin.y});
+            if (ImGui::IsItemHovered() &&
+                ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+            {
+                // map the click from the ImGui image back onto the viewport
+                const ImVec2 image_min{ImGui::GetItemRectMin()};
+                const ImVec2 image_size{ImGui::GetItemRectSize()};
+                const ImVec2 mouse_position{ImGui::GetMousePos()};
+                pick_entity_system(
+                    physics_thread,
+                    camera,
+                    Vector2{(mouse_position.x - image_min.x) / image_size.x,
+                            (mouse_position.y - image_min.y) / image_size.y},
+                    image_size.x / image_size.y,
+                    *dev_panel_state);
+            }
             ImGui::End();
         }
         else
         {
+            if (!ImGui::GetIO().WantCaptureMouse &&
+                IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+            {
+                const Vector2 mouse_position{GetMousePosition()};
+                const auto screen_width{static_cast<float>(GetScreenWidth())};
+                const auto screen_height{static_cast<float>(GetScreenHeight())};
+                pick_entity_system(physics_thread,
+                                   camera,
+                                   Vector2{mouse_position.x / screen_width,
+                                           mouse_position.y / screen_height},
+                                   screen_width / screen_height,
+                                   *dev_panel_state);
+            }
+
+            // the offscreen textures go stale while the debug view is closed
+            viewport_tracker.invalidate();
+            const ScopedProfile profile{frame_profiler, "Render scene"};
             ClearBackground(RAYWHITE);
-            BeginMode3D(camera);
-            draw_grid_system(draw_grid_query);
-            draw_sphere_system(draw_sphere_query);
-            EndMode3D();
+            draw_scene(camera,
+                       static_cast<float>(GetScreenHeight()),
+                       scene_queries,
+                       sphere_lod_view,
+                       sphere_lod_renderer,
+                       static_geometry_renderer,
+                       physics_debug,
+                       particles,
+                       particle_settings);
             draw_scene_text_system(font);
         }
         rlImGuiEnd();
         EndDrawing();
 
-        // advance the physics engine one step and get the updated sphere_position
-        update_sphere_system(update_sphere_query, frame_time, physics_engine);
+        // the History follows the entity the Dev Panel inspected this frame
+        track_history_system(world, history_query, *dev_panel_state);
     }
 
+    spdlog::info("Debug viewport rendered {} frames, skipped {}",
+                 viewport_tracker.rendered_frames(),
+                 viewport_tracker.skipped_frames());
+
+    sphere_lod_renderer.unload();
+    static_geometry_renderer.unload();
+    UnloadFont(font);
+
+    spdlog::info("Stopping Physics Thread");
+    physics_thread.stop();
+
     spdlog::info("Preparing Physics Engine for Shutdown");
     physics_engine.cleanup();
 
@@ -0,0 +1,167 @@
+#include "memory_stats.h"
+
+#include "components.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/world.hpp>
+#include <raylib.h>
+#include <spdlog/spdlog.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+// Bookkeeping flecs keeps for each table besides the component columns
+// (type, column and record arrays, graph edges). An estimate, not measured.
+constexpr std::size_t kFlecsTableOverheadBytes{512};
+
+// Depth attachment raylib creates with every render texture
+constexpr std::size_t kDepthBytesPerPixel{4};
+
+template <typename Component>
+std::size_t component_bytes(const flecs::world &world)
+{
+    return static_cast<std::size_t>(world.count<Component>()) *
+           sizeof(Component);
+}
+} // namespace
+
+std::size_t FlecsMemoryStats::total_bytes() const
+{
+    return _component_bytes + _entity_index_bytes + _table_bytes;
+}
+
+std::size_t JoltMemoryStats::total_bytes() const
+{
+    return _body_bytes + _body_manager_bytes + _broad_phase_bytes +
+           _contact_cache_bytes + _temp_allocator_bytes + _shape_bytes;
+}
+
+std::size_t RenderMemoryStats::total_bytes() const
+{
+    return _game_texture_bytes + _debug_texture_bytes + _font_atlas_bytes +
+           _mesh_bytes;
+}
+
+std::size_t MemoryStats::total_bytes() const
+{
+    return _flecs.total_bytes() + _jolt.total_bytes() + _render.total_bytes();
+}
+
+void MemoryHistory::record(const MemoryStats &stats)
+{
+    const auto index{static_cast<std::size_t>(_offset)};
+    _flecs_megabytes[index] = to_megabytes(stats._flecs.total_bytes());
+    _jolt_megabytes[index] = to_megabytes(stats._jolt.total_bytes());
+    _render_megabytes[index] = to_megabytes(stats._render.total_bytes());
+    _offset = (_offset + 1) % kSampleCount;
+}
+
+const float *MemoryHistory::flecs_megabytes() const
+{
+    return _flecs_megabytes.data();
+}
+
+const float *MemoryHistory::jolt_megabytes() const
+{
+    return _jolt_megabytes.data();
+}
+
+const float *MemoryHistory::render_megabytes() const
+{
+    return _render_megabytes.data();
+}
+
+int MemoryHistory::offset() const
+{
+    return _offset;
+}
+
+FlecsMemoryStats collect_flecs_memory_stats(const flecs::world &world)
+{
+    ecs_world_stats_t world_stats{};
+    ecs_world_stats_get(world.c_ptr(), &world_stats);
+    const std::int32_t sample{world_stats.t};
+
+    FlecsMemoryStats stats{};
+    stats._entities = static_cast<std::int32_t>(
+        world_stats.entities.count.gauge.avg[sample]);
+    stats._tables =
+        static_cast<std::int32_t>(world_stats.tables.count.gauge.avg[sample]);
+    stats._empty_tables = static_cast<std::int32_t>(
+        world_stats.tables.empty_count.gauge.avg[sample]);
+    stats._component_bytes =
+        component_bytes<Position>(world) + component_bytes<Velocity>(world) +
+        component_bytes<SphereMesh>(world) + component_bytes<SphereLod>(world) +
+        component_bytes<SphereCollider>(world) +
+        component_bytes<BoxCollider>(world) +
+        component_bytes<GridComponent>(world) +
+        component_bytes<DevPanelState>(world);
+    stats._entity_index_bytes =
+        static_cast<std::size_t>(stats._entities) * sizeof(ecs_record_t);
+    stats._table_bytes =
+        static_cast<std::size_t>(stats._tables) * kFlecsTableOverheadBytes;
+    return stats;
+}
+
+std::size_t render_texture_bytes(const RenderTexture &render_texture)
+{
+    return texture_bytes(render_texture.texture) +
+           static_cast<std::size_t>(render_texture.depth.width) *
+               static_cast<std::size_t>(render_texture.depth.height) *
+               kDepthBytesPerPixel;
+}
+
+std::size_t texture_bytes(const Texture2D &texture)
+{
+    return static_cast<std::size_t>(
+        GetPixelDataSize(texture.width, texture.height, texture.format));
+}
+
+float to_megabytes(const std::size_t bytes)
+{
+    constexpr float kBytesPerMegabyte{1'024.F * 1'024.F};
+    return static_cast<float>(bytes) / kBytesPerMegabyte;
+}
+
+void log_memory_stats(const MemoryStats &stats)
+{
+    const FlecsMemoryStats &flecs_stats{stats._flecs};
+    const JoltMemoryStats &jolt_stats{stats._jolt};
+    const RenderMemoryStats &render_stats{stats._render};
+    spdlog::info(
+        "Memory total: {:.{}f} MB", to_megabytes(stats.total_bytes()), 3);
+    spdlog::info("  flecs: {:.{}f} MB ({} entities, {} tables, {} empty; "
+                 "components {} B, entity index {} B, tables {} B)",
+                 to_megabytes(flecs_stats.total_bytes()),
+                 3,
+                 flecs_stats._entities,
+                 flecs_stats._tables,
+                 flecs_stats._empty_tables,
+                 flecs_stats._component_bytes,
+                 flecs_stats._entity_index_bytes,
+                 flecs_stats._table_bytes);
+    spdlog::info("  Jolt: {:.{}f} MB ({} / {} bodies, {} active; bodies {} B, "
+                 "body manager {} B, broadphase {} B, contact cache {} B, temp "
+                 "allocator {} B, shapes {} B)",
+                 to_megabytes(jolt_stats.total_bytes()),
+                 3,
+                 jolt_stats._bodies,
+                 jolt_stats._max_bodies,
+                 jolt_stats._active_bodies,
+                 jolt_stats._body_bytes,
+                 jolt_stats._body_manager_bytes,
+                 jolt_stats._broad_phase_bytes,
+                 jolt_stats._contact_cache_bytes,
+                 jolt_stats._temp_allocator_bytes,
+                 jolt_stats._shape_bytes);
+    spdlog::info("  render: {:.{}f} MB (game texture {} B, debug textures {} B, "
+                 "font atlas {} B, meshes {} B)",
+                 to_megabytes(render_stats.total_bytes()),
+                 3,
+                 render_stats._game_texture_bytes,
+                 render_stats._debug_texture_bytes,
+                 render_stats._font_atlas_bytes,
+                 render_stats._mesh_bytes);
+}
@@ -0,0 +1,94 @@
+#ifndef SRC_MEMORY_STATS_H
+#define SRC_MEMORY_STATS_H
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/world.hpp>
+#include <raylib.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Byte counts marked as estimates are derived from entity, body and capacity
+// counts, because neither flecs nor Jolt report heap usage per subsystem.
+struct FlecsMemoryStats
+{
+    std::int32_t _entities{0};
+    std::int32_t _tables{0};
+    std::int32_t _empty_tables{0};
+    std::size_t _component_bytes{0};    // live project component data
+    std::size_t _entity_index_bytes{0}; // estimate
+    std::size_t _table_bytes{0};        // estimate
+
+    [[nodiscard]] std::size_t total_bytes() const;
+};
+
+struct JoltMemoryStats
+{
+    std::uint32_t _bodies{0};
+    std::uint32_t _active_bodies{0};
+    std::uint32_t _max_bodies{0};
+    std::uint32_t _max_body_pairs{0};
+    std::uint32_t _max_contact_constraints{0};
+    std::size_t _body_bytes{0};
+    std::size_t _body_manager_bytes{0};     // estimate
+    std::size_t _broad_phase_bytes{0};      // estimate
+    std::size_t _contact_cache_bytes{0};    // estimate
+    std::size_t _temp_allocator_bytes{0};
+    std::size_t _shape_bytes{0};
+
+    [[nodiscard]] std::size_t total_bytes() const;
+};
+
+// GPU resources, sized from their dimensions and pixel formats
+struct RenderMemoryStats
+{
+    std::size_t _game_texture_bytes{0};
+    std::size_t _debug_texture_bytes{0}; // debug view and its direct pass
+    std::size_t _font_atlas_bytes{0};
+    std::size_t _mesh_bytes{0};
+
+    [[nodiscard]] std::size_t total_bytes() const;
+};
+
+struct MemoryStats
+{
+    FlecsMemoryStats _flecs{};
+    JoltMemoryStats _jolt{};
+    RenderMemoryStats _render{};
+
+    [[nodiscard]] std::size_t total_bytes() const;
+};
+
+// Rolling per-subsystem totals in megabytes, laid out for ImGui::PlotLines
+class MemoryHistory
+{
+public:
+    static constexpr int kSampleCount{120};
+
+    MemoryHistory() = default;
+
+    // mutator methods
+    void record(const MemoryStats &stats);
+
+    // accessor methods
+    [[nodiscard]] const float *flecs_megabytes() const;
+    [[nodiscard]] const float *jolt_megabytes() const;
+    [[nodiscard]] const float *render_megabytes() const;
+    // Index of the oldest sample, for ImGui::PlotLines' values_offset
+    [[nodiscard]] int offset() const;
+
+private:
+    std::array<float, kSampleCount> _flecs_megabytes{};
+    std::array<float, kSampleCount> _jolt_megabytes{};
+    std::array<float, kSampleCount> _render_megabytes{};
+    int _offset{0};
+};
+
+FlecsMemoryStats collect_flecs_memory_stats(const flecs::world &world);
+std::size_t render_texture_bytes(const RenderTexture &render_texture);
+std::size_t texture_bytes(const Texture2D &texture);
+float to_megabytes(std::size_t bytes);
+void log_memory_stats(const MemoryStats &stats);
+
+#endif
@@ -0,0 +1,397 @@
+#include "particles.h"
+
+#include "constants.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+// Arrays the kernels read and write, so they can be handed one pointer each
+struct ParticleArrays
+{
+    float *_position_x;
+    float *_position_y;
+    float *_position_z;
+    float *_velocity_x;
+    float *_velocity_y;
+    float *_velocity_z;
+    float *_lifetime;
+};
+
+// Per-step values shared by every lane
+struct ParticleStep
+{
+    float _delta_time;
+    float _gravity_impulse; // gravity * delta_time
+    float _damping;         // velocity multiplier from drag
+    float _ground_height;
+    float _bounce; // -restitution
+};
+
+ParticleStep make_step(const float delta_time, const ParticleSettings &settings)
+{
+    // implicit, so large drag or long frames slow particles without
+    // reversing them
+    return ParticleStep{delta_time,
+                        settings._gravity * delta_time,
+                        1.F / (1.F + settings._drag * delta_time),
+                        settings._ground_height,
+                        -settings._restitution};
+}
+
+// Returns the particles that expired in [begin, end)
+std::size_t integrate_scalar_range(const ParticleArrays &arrays,
+                                   const ParticleStep &step,
+                                   const std::size_t begin,
+                                   const std::size_t end)
+{
+    std::size_t expired{0};
+    for (std::size_t particle{begin}; particle < end; ++particle)
+    {
+        const float velocity_x{arrays._velocity_x[particle] * step._damping};
+        float velocity_y{(arrays._velocity_y[particle] + step._gravity_impulse) *
+                         step._damping};
+        const float velocity_z{arrays._velocity_z[particle] * step._damping};
+        arrays._position_x[particle] += velocity_x * step._delta_time;
+        arrays._position_z[particle] += velocity_z * step._delta_time;
+
+        float position_y{arrays._position_y[particle] +
+                         velocity_y * step._delta_time};
+        if (position_y < step._ground_height)
+        {
+            position_y = step._ground_height;
+            if (velocity_y < 0.F)
+            {
+                velocity_y *= step._bounce;
+            }
+        }
+        arrays._position_y[particle] = position_y;
+        arrays._velocity_x[particle] = velocity_x;
+        arrays._velocity_y[particle] = velocity_y;
+        arrays._velocity_z[particle] = velocity_z;
+
+        arrays._lifetime[particle] -= step._delta_time;
+        expired += arrays._lifetime[particle] <= 0.F ? 1U : 0U;
+    }
+    return expired;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+// Lanes set in a movemask
+std::size_t count_lanes(std::uint32_t mask)
+{
+    std::size_t lanes{0};
+    for (; mask != 0; mask &= mask - 1U)
+    {
+        ++lanes;
+    }
+    return lanes;
+}
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+constexpr std::size_t kParticleLanes{8};
+constexpr const char *kParticleKernelName{"AVX2 + FMA, 8 lanes"};
+
+std::size_t integrate_vector_range(const ParticleArrays &arrays,
+                                   const ParticleStep &step,
+                                   const std::size_t end)
+{
+    const __m256 delta_time{_mm256_set1_ps(step._delta_time)};
+    const __m256 gravity_impulse{_mm256_set1_ps(step._gravity_impulse)};
+    const __m256 damping{_mm256_set1_ps(step._damping)};
+    const __m256 ground_height{_mm256_set1_ps(step._ground_height)};
+    const __m256 bounce{_mm256_set1_ps(step._bounce)};
+    const __m256 zero{_mm256_setzero_ps()};
+
+    std::size_t expired{0};
+    for (std::size_t particle{0}; particle < end; particle += kParticleLanes)
+    {
+        const __m256 velocity_x{_mm256_mul_ps(
+            _mm256_loadu_ps(arrays._velocity_x + particle), damping)};
+        __m256 velocity_y{_mm256_mul_ps(
+            _mm256_add_ps(_mm256_loadu_ps(arrays._velocity_y + particle),
+                          gravity_impulse),
+            damping)};
+        const __m256 velocity_z{_mm256_mul_ps(
+            _mm256_loadu_ps(arrays._velocity_z + particle), damping)};
+        _mm256_storeu_ps(
+            arrays._position_x + particle,
+            _mm256_fmadd_ps(velocity_x,
+                            delta_time,
+                            _mm256_loadu_ps(arrays._position_x + particle)));
+        _mm256_storeu_ps(
+            arrays._position_z + particle,
+            _mm256_fmadd_ps(velocity_z,
+                            delta_time,
+                            _mm256_loadu_ps(arrays._position_z + particle)));
+
+        __m256 position_y{
+            _mm256_fmadd_ps(velocity_y,
+                            delta_time,
+                            _mm256_loadu_ps(arrays._position_y + particle))};
+        const __m256 below{
+            _mm256_cmp_ps(position_y, ground_height, _CMP_LT_OQ)};
+        const __m256 falling{_mm256_cmp_ps(velocity_y, zero, _CMP_LT_OQ)};
+        position_y = _mm256_blendv_ps(position_y, ground_height, below);
+        velocity_y = _mm256_blendv_ps(velocity_y,
+                                      _mm256_mul_ps(velocity_y, bounce),
+                                      _mm256_and_ps(below, falling));
+        _mm256_storeu_ps(arrays._position_y + particle, position_y);
+        _mm256_storeu_ps(arrays._velocity_x + particle, velocity_x);
+        _mm256_storeu_ps(arrays._velocity_y + particle, velocity_y);
+        _mm256_storeu_ps(arrays._velocity_z + particle, velocity_z);
+
+        const __m256 lifetime{_mm256_sub_ps(
+            _mm256_loadu_ps(arrays._lifetime + particle), delta_time)};
+        _mm256_storeu_ps(arrays._lifetime + particle, lifetime);
+        expired += count_lanes(static_cast<std::uint32_t>(
+            _mm256_movemask_ps(_mm256_cmp_ps(lifetime, zero, _CMP_LE_OQ))));
+    }
+    return expired;
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr std::size_t kParticleLanes{4};
+constexpr const char *kParticleKernelName{"SSE2, 4 lanes"};
+
+// SSE2 has no blend, so select through the mask by hand
+__m128 select(const __m128 mask, const __m128 if_set, const __m128 if_clear)
+{
+    return _mm_or_ps(_mm_and_ps(mask, if_set), _mm_andnot_ps(mask, if_clear));
+}
+
+std::size_t integrate_vector_range(const ParticleArrays &arrays,
+                                   const ParticleStep &step,
+                                   const std::size_t end)
+{
+    const __m128 delta_time{_mm_set1_ps(step._delta_time)};
+    const __m128 gravity_impulse{_mm_set1_ps(step._gravity_impulse)};
+    const __m128 damping{_mm_set1_ps(step._damping)};
+    const __m128 ground_height{_mm_set1_ps(step._ground_height)};
+    const __m128 bounce{_mm_set1_ps(step._bounce)};
+    const __m128 zero{_mm_setzero_ps()};
+
+    std::size_t expired{0};
+    for (std::size_t particle{0}; particle < end; particle += kParticleLanes)
+    {
+        const __m128 velocity_x{
+            _mm_mul_ps(_mm_loadu_ps(arrays._velocity_x + particle), damping)};
+        __m128 velocity_y{_mm_mul_ps(
+            _mm_add_ps(_mm_loadu_ps(arrays._velocity_y + particle),
+                       gravity_impulse),
+            damping)};
+        const __m128 velocity_z{
+            _mm_mul_ps(_mm_loadu_ps(arrays._velocity_z + particle), damping)};
+        _mm_storeu_ps(arrays._position_x + particle,
+                      _mm_add_ps(_mm_loadu_ps(arrays._position_x + particle),
+                                 _mm_mul_ps(velocity_x, delta_time)));
+        _mm_storeu_ps(arrays._position_z + particle,
+                      _mm_add_ps(_mm_loadu_ps(arrays._position_z + particle),
+                                 _mm_mul_ps(velocity_z, delta_time)));
+
+        __m128 position_y{
+            _mm_add_ps(_mm_loadu_ps(arrays._position_y + particle),
+                       _mm_mul_ps(velocity_y, delta_time))};
+        const __m128 below{_mm_cmplt_ps(position_y, ground_height)};
+        const __m128 falling{_mm_cmplt_ps(velocity_y, zero)};
+        position_y = select(below, ground_height, position_y);
+        velocity_y = select(_mm_and_ps(below, falling),
+                            _mm_mul_ps(velocity_y, bounce),
+                            velocity_y);
+        _mm_storeu_ps(arrays._position_y + particle, position_y);
+        _mm_storeu_ps(arrays._velocity_x + particle, velocity_x);
+        _mm_storeu_ps(arrays._velocity_y + particle, velocity_y);
+        _mm_storeu_ps(arrays._velocity_z + particle, velocity_z);
+
+        const __m128 lifetime{_mm_sub_ps(
+            _mm_loadu_ps(arrays._lifetime + particle), delta_time)};
+        _mm_storeu_ps(arrays._lifetime + particle, lifetime);
+        expired += count_lanes(static_cast<std::uint32_t>(
+            _mm_movemask_ps(_mm_cmple_ps(lifetime, zero))));
+    }
+    return expired;
+}
+#else
+constexpr std::size_t kParticleLanes{1};
+constexpr const char *kParticleKernelName{"Scalar"};
+
+std::size_t integrate_vector_range(const ParticleArrays &arrays,
+                                   const ParticleStep &step,
+                                   const std::size_t end)
+{
+    return integrate_scalar_range(arrays, step, 0, end);
+}
+#endif
+} // namespace
+
+void ParticleSystem::reserve(const std::size_t particles)
+{
+    _position_x.reserve(particles);
+    _position_y.reserve(particles);
+    _position_z.reserve(particles);
+    _velocity_x.reserve(particles);
+    _velocity_y.reserve(particles);
+    _velocity_z.reserve(particles);
+    _lifetime.reserve(particles);
+    _colour.reserve(particles);
+}
+
+void ParticleSystem::clear()
+{
+    _position_x.clear();
+    _position_y.clear();
+    _position_z.clear();
+    _velocity_x.clear();
+    _velocity_y.clear();
+    _velocity_z.clear();
+    _lifetime.clear();
+    _colour.clear();
+}
+
+bool ParticleSystem::emit(const Vector3 &position,
+                          const Vector3 &velocity,
+                          const float lifetime,
+                          const Color &colour)
+{
+    if (size() >= constants::kMaxParticles || lifetime <= 0.F)
+    {
+        return false;
+    }
+    _position_x.push_back(position.x);
+    _position_y.push_back(position.y);
+    _position_z.push_back(position.z);
+    _velocity_x.push_back(velocity.x);
+    _velocity_y.push_back(velocity.y);
+    _velocity_z.push_back(velocity.z);
+    _lifetime.push_back(lifetime);
+    _colour.push_back(colour);
+    return true;
+}
+
+std::size_t ParticleSystem::integrate(const float delta_time,
+                                      const ParticleSettings &settings)
+{
+    const ParticleArrays arrays{_position_x.data(),
+                                _position_y.data(),
+                                _position_z.data(),
+                                _velocity_x.data(),
+                                _velocity_y.data(),
+                                _velocity_z.data(),
+                                _lifetime.data()};
+    const ParticleStep step{make_step(delta_time, settings)};
+    const std::size_t vector_end{size() - size() % kParticleLanes};
+    const std::size_t expired{
+        integrate_vector_range(arrays, step, vector_end) +
+        integrate_scalar_range(arrays, step, vector_end, size())};
+    // most frames nothing dies, and then the arrays are not touched again
+    return expired == 0 ? 0 : remove_expired();
+}
+
+std::size_t ParticleSystem::integrate_scalar(const float delta_time,
+                                             const ParticleSettings &settings)
+{
+    const ParticleArrays arrays{_position_x.data(),
+                                _position_y.data(),
+                                _position_z.data(),
+                                _velocity_x.data(),
+                                _velocity_y.data(),
+                                _velocity_z.data(),
+                                _lifetime.data()};
+    const std::size_t expired{integrate_scalar_range(
+        arrays, make_step(delta_time, settings), 0, size())};
+    return expired == 0 ? 0 : remove_expired();
+}
+
+std::size_t ParticleSystem::size() const
+{
+    return _lifetime.size();
+}
+
+bool ParticleSystem::empty() const
+{
+    return _lifetime.empty();
+}
+
+Vector3 ParticleSystem::position(const std::size_t particle) const
+{
+    return Vector3{
+        _position_x[particle], _position_y[particle], _position_z[particle]};
+}
+
+Vector3 ParticleSystem::velocity(const std::size_t particle) const
+{
+    return Vector3{
+        _velocity_x[particle], _velocity_y[particle], _velocity_z[particle]};
+}
+
+float ParticleSystem::lifetime(const std::size_t particle) const
+{
+    return _lifetime[particle];
+}
+
+Color ParticleSystem::colour(const std::size_t particle) const
+{
+    return _colour[particle];
+}
+
+const char *ParticleSystem::kernel_name()
+{
+    return kParticleKernelName;
+}
+
+std::size_t ParticleSystem::remove_expired()
+{
+    std::size_t removed{0};
+    std::size_t particle{0};
+    while (particle < size())
+    {
+        if (_lifetime[particle] > 0.F)
+        {
+            ++particle;
+            continue;
+        }
+        const std::size_t last{size() - 1};
+        _position_x[particle] = _position_x[last];
+        _position_y[particle] = _position_y[last];
+        _position_z[particle] = _position_z[last];
+        _velocity_x[particle] = _velocity_x[last];
+        _velocity_y[particle] = _velocity_y[last];
+        _velocity_z[particle] = _velocity_z[last];
+        _lifetime[particle] = _lifetime[last];
+        _colour[particle] = _colour[last];
+        _position_x.pop_back();
+        _position_y.pop_back();
+        _position_z.pop_back();
+        _velocity_x.pop_back();
+        _velocity_y.pop_back();
+        _velocity_z.pop_back();
+        _lifetime.pop_back();
+        _colour.pop_back();
+        ++removed;
+    }
+    return removed;
+}
+
+float next_particle_random(std::uint32_t &state)
+{
+    // xorshift32, which never leaves zero, so nudge a zero seed off it
+    if (state == 0)
+    {
+        state = 0x9e3779b9U;
+    }
+    state ^= state << 13U;
+    state ^= state >> 17U;
+    state ^= state << 5U;
+    // the top 24 bits fill a float's mantissa exactly
+    constexpr float kScale{1.F / 16'777'216.F};
+    return static_cast<float>(state >> 8U) * kScale;
+}
@@ -3,6 +3,17 @@
 // SPDX-License-Identifier: MIT
 
 #include "physics.h"
+#include "body_pool.h"
+#include "body_trace.h"
+#include "components.h"
+#include "debug_draw.h"
+#include "jolt_debug_renderer.h"
+#include "jolt_runtime.h"
+#include "memory_stats.h"
+#include "physics_commands.h"
+#include "shape_cache.h"
+#include "spatial_query.h"
+#include "transform_snapshot.h"
 
 // The Jolt headers don't include Jolt.h. Always include Jolt.h before including
 // any other Jolt header. You can use Jolt.h in your precompiled header to speed
@@ -10,36 +21,57 @@
 #include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
 
 // Jolt includes
+#include <Jolt/Core/Color.h>
 #include <Jolt/Core/Core.h>
-#include <Jolt/Core/Factory.h>
 #include <Jolt/Core/IssueReporting.h>
+#include <Jolt/Core/JobSystem.h>
 #include <Jolt/Core/JobSystemThreadPool.h>
-#include <Jolt/Core/Memory.h>
 #include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Math/Mat44.h>
 #include <Jolt/Math/Quat.h>
 #include <Jolt/Math/Real.h>
 #include <Jolt/Math/Vec3.h>
 #include <Jolt/Physics/Body/Body.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyFilter.h>
 #include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Body/BodyLockInterface.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/MotionProperties.h>
 #include <Jolt/Physics/Body/MotionType.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuery.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
 #include <Jolt/Physics/Collision/ContactListener.h>
+#include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
+#include <Jolt/Physics/Collision/RayCast.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/Shape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/EActivation.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
-#include <Jolt/RegisterTypes.h>
+#include <Jolt/Physics/StateRecorderImpl.h>
 #include <raylib.h>
 #include <spdlog/spdlog.h>
 
+#ifdef JPH_DEBUG_RENDERER
+#include <Jolt/Physics/Constraints/ContactConstraintManager.h>
+#endif
+
 // STL includes
-#include <cstdarg>
-#include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <string>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
 // Disable common warnings triggered by Jolt, you can use
 // JPH_SUPPRESS_WARNING_PUSH / JPH_SUPPRESS_WARNING_POP to store and restore the
@@ -51,37 +83,38 @@
 // JPH_DOUBLE_PRECISION is set or not.
 using namespace JPH::literals;
 
-// Callback for traces, connect this to your own trace function if you have one
-static void TraceImpl(const char *inFMT, ...)
+namespace
 {
-    // Format the message
-    va_list list;
-    va_start(list, inFMT);
-    char buffer[1'024];
-    vsnprintf(buffer, sizeof(buffer), inFMT, list);
-    va_end(list);
-
-    // Print to the TTY
-    std::cout << buffer << '\n';
-}
-
-#ifdef JPH_ENABLE_ASSERTS
+// Vec3 and Quat are both a single __m128 (x, y, z, w), the same layout as a
+// raylib Vector4, so a 16-byte copy moves all four floats in one store
+static_assert(sizeof(JPH::RVec3) == sizeof(Vector4) &&
+                  sizeof(JPH::Vec3) == sizeof(Vector4) &&
+                  sizeof(JPH::Quat) == sizeof(Vector4),
+              "Jolt vectors are expected to be four floats wide. Double "
+              "precision positions are not supported by the snapshot sync.");
 
-// Callback for asserts, connect this to your own assert handler if you have one
-static bool AssertFailedImpl(const char *inExpression,
-                             const char *inMessage,
-                             const char *inFile,
-                             uint inLine)
+template <typename JoltVector>
+void store_lanes(const JoltVector &value, Vector4 &lanes)
 {
-    // Print to the TTY
-    std::cout << inFile << ":" << inLine << ": (" << inExpression << ") "
-              << (inMessage != nullptr ? inMessage : "") << endl;
-
-    // Breakpoint
-    return true;
-};
+    std::memcpy(&lanes, &value, sizeof(lanes));
+}
 
-#endif // JPH_ENABLE_ASSERTS
+// Sizes of structures Jolt keeps private, read off the Jolt v4.0.2 sources
+// pinned in Dependencies.cmake, for PhysicsEngine::memory_stats. Recheck
+// them when Jolt is updated.
+// QuadTree::Node: six Float4 bounds, four child IDs and two atomics, padded
+// to a cache line
+constexpr std::size_t kQuadTreeNodeBytes{128};
+// BroadPhaseQuadTree::Tracking: broadphase layer, object layer and node ID
+constexpr std::size_t kBroadPhaseTrackingBytes{8};
+// ManifoldCache entry for a body pair: CachedBodyPair (two Float3 and a
+// manifold index), its BodyPair key, the hash map link and bucket
+constexpr std::size_t kCachedBodyPairBytes{48};
+// ManifoldCache entry for a contact constraint: CachedManifold with room for
+// MaxContactPoints contact points, its SubShapeIDPair key, the hash map link
+// and bucket
+constexpr std::size_t kCachedManifoldBytes{192};
+} // namespace
 
 PhysicsEngine::PhysicsEngine()
     : _body_activation_listener(std::make_unique<MyBodyActivationListener>()),
@@ -89,73 +122,39 @@ PhysicsEngine::PhysicsEngine()
 {
 }
 
-void PhysicsEngine::initialise()
+void PhysicsEngine::initialise(const PhysicsCapacity &capacity)
 {
-    // Register allocation hook. In this example we'll just let Jolt use malloc /
-    // free but you can override these if you want (see Memory.h). This needs to
-    // be done before any other Jolt function is called.
-    JPH::RegisterDefaultAllocator();
+    _capacity = capacity;
 
-    // Install trace and assert callbacks
-    JPH::Trace = TraceImpl;
-    JPH_IF_ENABLE_ASSERTS(AssertFailed = AssertFailedImpl;)
-
-    // Create a factory, this class is responsible for creating instances of
-    // classes based on their name or hash and is mainly used for deserialization
-    // of saved data. It is not directly used in this example but still required.
-    JPH::Factory::sInstance = new JPH::Factory();
-
-    // Register all physics types with the factory and install their collision
-    // handlers with the CollisionDispatch class. If you have your own custom
-    // shape types you probably need to register their handlers with the
-    // CollisionDispatch before calling this function. If you implement your own
-    // default material (PhysicsMaterial::sDefault) make sure to initialize it
-    // before this function or else this function will create one for you.
-    JPH::RegisterTypes();
+    // Process-wide Jolt setup is shared with any other engine in the process
+    _jolt_runtime = std::make_unique<JoltRuntime>();
 
     // We need a temp allocator for temporary allocations during the physics
     // update. We're pre-allocating 10 MB to avoid having to do allocations during
     // the physics update. B.t.w. 10 MB is way too much for this example but it is
     // a typical value you can use. If you don't want to pre-allocate you can also
     // use TempAllocatorMalloc to fall back to malloc / free.
-    _temp_allocator =
-        std::make_unique<JPH::TempAllocatorImpl>(10 * 1'024 * 1'024);
+    _temp_allocator = std::make_unique<JPH::TempAllocatorImpl>(
+        static_cast<JPH::uint>(capacity._temp_allocator_bytes));
 
     // We need a job system that will execute physics jobs on multiple threads.
     // Typically you would implement the JobSystem interface yourself and let Jolt
     // Physics run on top of your own job scheduler. JobSystemThreadPool is an
     // example implementation.
+    const int job_threads{
+        capacity._job_threads < 0
+            ? static_cast<int>(std::thread::hardware_concurrency()) - 1
+            : capacity._job_threads};
     _job_system = std::make_unique<JPH::JobSystemThreadPool>(
-        JPH::cMaxPhysicsJobs,
-        JPH::cMaxPhysicsBarriers,
-        static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, job_threads);
 
-    // This is the max amount of rigid bodies that you can add to the physics
-    // system. If you try to add more you'll get an error. Note: This value is low
-    // because this is a simple test. For a real project use something in the
-    // order of 65536.
-    constexpr JPH::uint cMaxBodies = 1'024;
+    // The max amount of rigid bodies, queued body pairs and contact constraints
+    // come from PhysicsCapacity, see physics.h.
 
     // This determines how many mutexes to allocate to protect rigid bodies from
     // concurrent access. Set it to 0 for the default settings.
     constexpr JPH::uint cNumBodyMutexes = 0;
 
-    // This is the max amount of body pairs that can be queued at any time (the
-    // broad phase will detect overlapping body pairs based on their bounding
-    // boxes and will insert them into a queue for the narrowphase). If you make
-    // this buffer too small the queue will fill up and the broad phase jobs will
-    // start to do narrow phase work. This is slightly less efficient. Note: This
-    // value is low because this is a simple test. For a real project use
-    // something in the order of 65536.
-    constexpr JPH::uint cMaxBodyPairs = 1'024;
-
-    // This is the maximum size of the contact constraint buffer. If more contacts
-    // (collisions between bodies) are detected than this number then these
-    // contacts will be ignored and bodies will start interpenetrating / fall
-    // through the world. Note: This value is low because this is a simple test.
-    // For a real project use something in the order of 10240.
-    constexpr JPH::uint cMaxContactConstraints = 1'024;
-
     // Create mapping table from object layer to broadphase layer
     // Note: As this is an interface, PhysicsSystem will take a reference to this
     // so this instance needs to stay alive!
@@ -175,10 +174,15 @@ void PhysicsEngine::initialise()
 
     // Now we can create the actual physics system.
     _physics_system = std::make_unique<JPH::PhysicsSystem>();
-    _physics_system->Init(cMaxBodies,
+    _dynamic_body_slots.resize(capacity._max_bodies);
+    _moved_steps.resize(capacity._max_bodies);
+    _active_body_ids.reserve(capacity._max_bodies);
+    _previously_active_body_ids.reserve(capacity._max_bodies);
+
+    _physics_system->Init(capacity._max_bodies,
                           cNumBodyMutexes,
-                          cMaxBodyPairs,
-                          cMaxContactConstraints,
+                          capacity._max_body_pairs,
+                          capacity._max_contact_constraints,
                           *_broad_phase_layer_interface,
                           *_object_vs_broadphase_layer_filter,
                           *_object_vs_object_layer_filter);
@@ -200,40 +204,29 @@ void PhysicsEngine::initialise()
     //JPH::BodyInterface &body_interface = _physics_system->GetBodyInterface();
 }
 
-void PhysicsEngine::create_floor(const Vector3 &floor_dimensions,
-                                 const Vector3 &floor_position)
+JPH::BodyID PhysicsEngine::create_floor(const Vector3 &floor_dimensions,
+                                        const Vector3 &floor_position,
+                                        const std::uint64_t entity_id)
 {
-    // Next we can create a rigid body to serve as the floor, we make a large box
-    // Create the settings for the collision volume (the shape).
-    // Note that for simple shapes (like boxes) you can also directly construct a
-    // BoxShape.
-    const JPH::BoxShapeSettings floor_shape_settings{
-        //JPH::Vec3(100.F, 1.F, 100.F)};
-        JPH::Vec3{floor_dimensions.x, floor_dimensions.y, floor_dimensions.z}};
-
-    // Create the shape
-    const JPH::ShapeSettings::ShapeResult floor_shape_result =
-        floor_shape_settings.Create();
-    const JPH::ShapeRefC floor_shape =
-        floor_shape_result
-            .Get(); // We don't expect an error here, but you can check
-                    // floor_shape_result for HasError() / GetError()
-
-    if (floor_shape_result.HasError())
+    // Next we can create a rigid body to serve as the floor, we make a large box.
+    // Floors with the same dimensions share a single shape.
+    const JPH::ShapeRefC floor_shape{_shape_cache.get_box(floor_dimensions)};
+    if (floor_shape == nullptr)
     {
-        spdlog::error("Error creating floor: {}",
-                      floor_shape_result.GetError());
+        spdlog::error("Error creating floor shape");
+        return JPH::BodyID{};
     }
 
     // Create the settings for the body itself. Note that here you can also set
     // other properties like the restitution / friction.
-    const JPH::BodyCreationSettings floor_settings(
+    JPH::BodyCreationSettings floor_settings(
         floor_shape,
         //JPH::RVec3(0.0_r, -1.0_r, 0.0_r),
         JPH::RVec3(floor_position.x, floor_position.y, floor_position.z),
         JPH::Quat::sIdentity(),
         JPH::EMotionType::Static,
         Layers::NON_MOVING);
+    floor_settings.mUserData = entity_id;
 
     JPH::BodyInterface &body_interface = _physics_system->GetBodyInterface();
 
@@ -245,29 +238,37 @@ void PhysicsEngine::create_floor(const Vector3 &floor_dimensions,
     {
         spdlog::error("Error creating floor body interface. Thre might be too "
                       "many bodies.");
+        return JPH::BodyID{};
     }
 
     // Add it to the world
     body_interface.AddBody(floor->GetID(), JPH::EActivation::DontActivate);
 
-    _floor_id = floor->GetID();
-    //body_interface.SetFriction(_floor_id, 1.F);
+    const JPH::BodyID floor_id{floor->GetID()};
+    _static_body_ids.push_back(floor_id);
+    //body_interface.SetFriction(floor_id, 1.F);
+
+    return floor_id;
 }
 
-void PhysicsEngine::create_ball(const float ball_radius,
-                                const Vector3 &ball_position,
-                                const Vector3 &ball_velocity)
+JPH::BodyID PhysicsEngine::create_ball(const float ball_radius,
+                                       const Vector3 &ball_position,
+                                       const Vector3 &ball_velocity,
+                                       const std::uint64_t entity_id)
 {
     // Now create a dynamic body to bounce on the floor
     // Note that this uses the shorthand version of creating and adding a body to
     // the world
-    const JPH::BodyCreationSettings sphere_settings(
-        new JPH::SphereShape(ball_radius),
+    JPH::BodyCreationSettings sphere_settings(
+        _shape_cache.get_sphere(ball_radius),
         //JPH::RVec3(0.0_r, 2.0_r, 0.0_r),
         JPH::RVec3(ball_position.x, ball_position.y, ball_position.z),
         JPH::Quat::sIdentity(),
         JPH::EMotionType::Dynamic,
         Layers::MOVING);
+    // Keep the owning flecs entity on the body, so physics results can be
+    // routed back to it
+    sphere_settings.mUserData = entity_id;
     JPH::BodyInterface &body_interface = _physics_system->GetBodyInterface();
     _sphere_id = body_interface.CreateAndAddBody(sphere_settings,
                                                  JPH::EActivation::Activate);
@@ -282,13 +283,578 @@ void PhysicsEngine::create_ball(const float ball_radius,
         JPH::Vec3(ball_velocity.x, ball_velocity.y, ball_velocity.z));
     constexpr float kRestitution{0.8F};
     body_interface.SetRestitution(_sphere_id, kRestitution);
+
+    _body_pool.count_created();
+    add_dynamic_body(_sphere_id);
+
+    return _sphere_id;
+}
+
+JPH::BodyID PhysicsEngine::spawn_ball(const float ball_radius,
+                                      const Vector3 &ball_position,
+                                      const Vector3 &ball_velocity,
+                                      const std::uint64_t entity_id)
+{
+    const JPH::ShapeRefC shape{_shape_cache.get_sphere(ball_radius)};
+    JPH::BodyID body_id;
+    if (!_body_pool.acquire(shape.GetPtr(), body_id))
+    {
+        return create_ball(ball_radius, ball_position, ball_velocity, entity_id);
+    }
+
+    // Reset the recycled body as if it were new, before it goes back into
+    // the broadphase
+    JPH::BodyInterface &body_interface = _physics_system->GetBodyInterface();
+    body_interface.SetPositionRotationAndVelocity(
+        body_id,
+        JPH::RVec3(ball_position.x, ball_position.y, ball_position.z),
+        JPH::Quat::sIdentity(),
+        JPH::Vec3(ball_velocity.x, ball_velocity.y, ball_velocity.z),
+        JPH::Vec3::sZero());
+    body_interface.SetUserData(body_id, entity_id);
+    body_interface.AddBody(body_id, JPH::EActivation::Activate);
+    add_dynamic_body(body_id);
+
+    return body_id;
+}
+
+void PhysicsEngine::despawn_body(const JPH::BodyID &body_id, const bool recycle)
+{
+    JPH::BodyInterface &body_interface = _physics_system->GetBodyInterface();
+
+    // Removing takes the body out of the broadphase, but it keeps all of its
+    // state, so it can be re-added later
+    body_interface.RemoveBody(body_id);
+    remove_dynamic_body(body_id);
+    if (recycle)
+    {
+        _body_pool.release(body_interface.GetShape(body_id).GetPtr(), body_id);
+        return;
+    }
+    body_interface.DestroyBody(body_id);
+}
+
+void PhysicsEngine::prewarm_ball_pool(const float ball_radius,
+                                      const std::size_t count)
+{
+    JPH::BodyInterface &body_interface = _physics_system->GetBodyInterface();
+    const JPH::ShapeRefC shape{_shape_cache.get_sphere(ball_radius)};
+    JPH::BodyCreationSettings sphere_settings(shape,
+                                              JPH::RVec3::sZero(),
+                                              JPH::Quat::sIdentity(),
+                                              JPH::EMotionType::Dynamic,
+                                              Layers::MOVING);
+    constexpr float kRestitution{0.8F};
+    sphere_settings.mRestitution = kRestitution;
+    for (std::size_t index{0}; index < count; ++index)
+    {
+        const JPH::Body *body{body_interface.CreateBody(sphere_settings)};
+        if (body == nullptr)
+        {
+            spdlog::error("Body pool prewarm stopped after {} bodies. There "
+                          "might be too many bodies.",
+                          index);
+            return;
+        }
+        _body_pool.count_created();
+        _body_pool.release(shape.GetPtr(), body->GetID());
+    }
+}
+
+void PhysicsEngine::add_dynamic_body(const JPH::BodyID &body_id)
+{
+    _dynamic_body_slots[body_id.GetIndex()] =
+        static_cast<std::uint32_t>(_dynamic_body_ids.size());
+    // new and recycled bodies go into the next snapshot, moving or not
+    _moved_steps[body_id.GetIndex()] = _step + 1;
+    _dynamic_body_ids.push_back(body_id);
+}
+
+void PhysicsEngine::remove_dynamic_body(const JPH::BodyID &body_id)
+{
+    // swap with the last body, so removal does not search or shift the list
+    const std::uint32_t slot{_dynamic_body_slots[body_id.GetIndex()]};
+    const JPH::BodyID last_body_id{_dynamic_body_ids.back()};
+    _dynamic_body_ids[slot] = last_body_id;
+    _dynamic_body_slots[last_body_id.GetIndex()] = slot;
+    _dynamic_body_ids.pop_back();
+}
+
+void PhysicsEngine::add_bodies(std::vector<JPH::BodyID> &body_ids,
+                               const JPH::EActivation activation)
+{
+    if (body_ids.empty())
+    {
+        return;
+    }
+    // Prepare builds a tree of the new bodies without locking the broadphase,
+    // finalize then inserts it in one go. Both may reorder body_ids.
+    JPH::BodyInterface &body_interface{_physics_system->GetBodyInterface()};
+    const int count{static_cast<int>(body_ids.size())};
+    const JPH::BodyInterface::AddState state{
+        body_interface.AddBodiesPrepare(body_ids.data(), count)};
+    body_interface.AddBodiesFinalize(body_ids.data(), count, state, activation);
+}
+
+void PhysicsEngine::apply_body_commands(std::vector<PhysicsCommand> &commands)
+{
+    JPH::BodyInterface &body_interface{_physics_system->GetBodyInterface()};
+
+    // Every removal goes through one call, so the broadphase is only locked
+    // and updated once
+    std::vector<JPH::BodyID> removed_body_ids;
+    for (const PhysicsCommand &command : commands)
+    {
+        const JPH::BodyID body_id{command._body_id};
+        if (command._type == PhysicsCommandType::kDestroy &&
+            body_interface.IsAdded(body_id))
+        {
+            removed_body_ids.push_back(body_id);
+        }
+    }
+    if (!removed_body_ids.empty())
+    {
+        body_interface.RemoveBodies(removed_body_ids.data(),
+                                    static_cast<int>(removed_body_ids.size()));
+    }
+    std::vector<JPH::BodyID> destroyed_body_ids;
+    for (const JPH::BodyID &body_id : removed_body_ids)
+    {
+        if (body_id == _sphere_id)
+        {
+            _sphere_id = JPH::BodyID{};
+        }
+        // removed dynamic bodies keep their state, so the creates below can
+        // have them back
+        if (body_interface.GetMotionType(body_id) == JPH::EMotionType::Dynamic)
+        {
+            remove_dynamic_body(body_id);
+            _body_pool.release(body_interface.GetShape(body_id).GetPtr(),
+                               body_id);
+            continue;
+        }
+        _static_body_ids.erase(std::remove(_static_body_ids.begin(),
+                                           _static_body_ids.end(),
+                                           body_id),
+                               _static_body_ids.end());
+        destroyed_body_ids.push_back(body_id);
+    }
+    // Parked bodies are already out of the broadphase and the body lists,
+    // so they only need releasing
+    for (const PhysicsCommand &command : commands)
+    {
+        if (command._type != PhysicsCommandType::kDestroy ||
+            _parked_body_ids.erase(command._body_id) == 0)
+        {
+            continue;
+        }
+        const JPH::BodyID body_id{command._body_id};
+        if (body_interface.GetMotionType(body_id) == JPH::EMotionType::Dynamic)
+        {
+            _body_pool.release(body_interface.GetShape(body_id).GetPtr(),
+                               body_id);
+            continue;
+        }
+        destroyed_body_ids.push_back(body_id);
+    }
+    if (!destroyed_body_ids.empty())
+    {
+        body_interface.DestroyBodies(
+            destroyed_body_ids.data(),
+            static_cast<int>(destroyed_body_ids.size()));
+    }
+
+    // Created bodies are added in one batch per activation, static and
+    // dynamic bodies apart as only dynamic ones start awake
+    std::vector<JPH::BodyID> added_static_body_ids;
+    std::vector<JPH::BodyID> added_dynamic_body_ids;
+    constexpr float kRestitution{0.8F};
+    for (PhysicsCommand &command : commands)
+    {
+        if (command._type == PhysicsCommandType::kDestroy)
+        {
+            continue;
+        }
+        const bool sphere{command._shape == ShapeType::kSphere};
+        const JPH::ShapeRefC shape{
+            sphere ? _shape_cache.get_sphere(command._dimensions.x)
+                   : _shape_cache.get_box(command._dimensions)};
+        if (shape == nullptr)
+        {
+            spdlog::error("Could not make a shape for entity {}",
+                          command._entity);
+            command._body_id = kNoPhysicsBody;
+            continue;
+        }
+        if (command._type == PhysicsCommandType::kUpdate)
+        {
+            body_interface.SetShape(JPH::BodyID{command._body_id},
+                                    shape.GetPtr(),
+                                    true,
+                                    sphere ? JPH::EActivation::Activate
+                                           : JPH::EActivation::DontActivate);
+            continue;
+        }
+
+        const JPH::RVec3 position{
+            command._position.x, command._position.y, command._position.z};
+        const JPH::Vec3 velocity{
+            command._velocity.x, command._velocity.y, command._velocity.z};
+        JPH::BodyID body_id;
+        if (sphere && _body_pool.acquire(shape.GetPtr(), body_id))
+        {
+            body_interface.SetPositionRotationAndVelocity(
+                body_id,
+                position,
+                JPH::Quat::sIdentity(),
+                velocity,
+                JPH::Vec3::sZero());
+            body_interface.SetUserData(body_id, command._entity);
+        }
+        else
+        {
+            JPH::BodyCreationSettings settings(
+                shape,
+                position,
+                JPH::Quat::sIdentity(),
+                sphere ? JPH::EMotionType::Dynamic : JPH::EMotionType::Static,
+                sphere ? Layers::MOVING : Layers::NON_MOVING);
+            settings.mUserData = command._entity;
+            if (sphere)
+            {
+                settings.mLinearVelocity = velocity;
+                settings.mRestitution = kRestitution;
+            }
+            const JPH::Body *body{body_interface.CreateBody(settings)};
+            if (body == nullptr)
+            {
+                spdlog::error("Could not create a body for entity {}. There "
+                              "might be too many bodies.",
+                              command._entity);
+                command._body_id = kNoPhysicsBody;
+                continue;
+            }
+            body_id = body->GetID();
+            if (sphere)
+            {
+                _body_pool.count_created();
+            }
+        }
+        command._body_id = body_id.GetIndexAndSequenceNumber();
+        if (sphere)
+        {
+            add_dynamic_body(body_id);
+            added_dynamic_body_ids.push_back(body_id);
+        }
+        else
+        {
+            _static_body_ids.push_back(body_id);
+            added_static_body_ids.push_back(body_id);
+        }
+    }
+    add_bodies(added_static_body_ids, JPH::EActivation::DontActivate);
+    add_bodies(added_dynamic_body_ids, JPH::EActivation::Activate);
+}
+
+void PhysicsEngine::park_bodies(const std::vector<std::uint32_t> &body_ids)
+{
+    JPH::BodyInterface &body_interface{_physics_system->GetBodyInterface()};
+    std::vector<JPH::BodyID> parked_body_ids;
+    parked_body_ids.reserve(body_ids.size());
+    for (const std::uint32_t body_id : body_ids)
+    {
+        if (body_interface.IsAdded(JPH::BodyID{body_id}))
+        {
+            parked_body_ids.emplace_back(body_id);
+        }
+    }
+    if (parked_body_ids.empty())
+    {
+        return;
+    }
+    body_interface.RemoveBodies(parked_body_ids.data(),
+                                static_cast<int>(parked_body_ids.size()));
+    for (const JPH::BodyID &body_id : parked_body_ids)
+    {
+        if (body_interface.GetMotionType(body_id) == JPH::EMotionType::Dynamic)
+        {
+            remove_dynamic_body(body_id);
+        }
+        else
+        {
+            _static_body_ids.erase(std::remove(_static_body_ids.begin(),
+                                               _static_body_ids.end(),
+                                               body_id),
+                                   _static_body_ids.end());
+        }
+        _parked_body_ids.insert(body_id.GetIndexAndSequenceNumber());
+    }
+}
+
+void PhysicsEngine::unpark_bodies(const std::vector<std::uint32_t> &body_ids)
+{
+    JPH::BodyInterface &body_interface{_physics_system->GetBodyInterface()};
+    std::vector<JPH::BodyID> static_body_ids;
+    std::vector<JPH::BodyID> dynamic_body_ids;
+    for (const std::uint32_t body_id : body_ids)
+    {
+        if (_parked_body_ids.erase(body_id) == 0)
+        {
+            continue;
+        }
+        const JPH::BodyID id{body_id};
+        if (body_interface.GetMotionType(id) == JPH::EMotionType::Dynamic)
+        {
+            add_dynamic_body(id);
+            dynamic_body_ids.push_back(id);
+        }
+        else
+        {
+            _static_body_ids.push_back(id);
+            static_body_ids.push_back(id);
+        }
+    }
+    add_bodies(static_body_ids, JPH::EActivation::DontActivate);
+    add_bodies(dynamic_body_ids, JPH::EActivation::Activate);
+}
+
+bool PhysicsEngine::restore_checkpoint(const PhysicsCheckpoint &checkpoint)
+{
+    JPH::BodyInterface &body_interface{_physics_system->GetBodyInterface()};
+
+    // Create the bodies in ID order, as the original engine did
+    std::vector<const CheckpointBody *> bodies;
+    bodies.reserve(checkpoint._static_bodies.size() +
+                   checkpoint._dynamic_bodies.size());
+    for (const CheckpointBody &body : checkpoint._static_bodies)
+    {
+        bodies.push_back(&body);
+    }
+    for (const CheckpointBody &body : checkpoint._dynamic_bodies)
+    {
+        bodies.push_back(&body);
+    }
+    std::sort(bodies.begin(),
+              bodies.end(),
+              [](const CheckpointBody *lhs, const CheckpointBody *rhs) {
+                  return JPH::BodyID{lhs->_body_id}.GetIndex() <
+                         JPH::BodyID{rhs->_body_id}.GetIndex();
+              });
+
+    for (const CheckpointBody *body : bodies)
+    {
+        JPH::BodyCreationSettings settings(
+            body->_shape == ShapeType::kSphere
+                ? _shape_cache.get_sphere(body->_dimensions.x)
+                : _shape_cache.get_box(body->_dimensions),
+            JPH::RVec3(body->_position.x, body->_position.y, body->_position.z),
+            JPH::Quat(body->_rotation.x,
+                      body->_rotation.y,
+                      body->_rotation.z,
+                      body->_rotation.w),
+            body->_dynamic != 0 ? JPH::EMotionType::Dynamic
+                                : JPH::EMotionType::Static,
+            body->_dynamic != 0 ? Layers::MOVING : Layers::NON_MOVING);
+        settings.mUserData = body->_entity;
+        settings.mFriction = body->_friction;
+        settings.mRestitution = body->_restitution;
+        if (body_interface.CreateBodyWithID(JPH::BodyID{body->_body_id},
+                                            settings) == nullptr)
+        {
+            spdlog::error("Could not recreate body {} from the checkpoint",
+                          body->_body_id);
+            return false;
+        }
+        body_interface.AddBody(JPH::BodyID{body->_body_id},
+                               JPH::EActivation::DontActivate);
+    }
+
+    _step = static_cast<JPH::uint>(checkpoint._step);
+    _sphere_id = JPH::BodyID{checkpoint._sphere_body_id};
+    for (const CheckpointBody &body : checkpoint._static_bodies)
+    {
+        _static_body_ids.emplace_back(body._body_id);
+    }
+    for (const CheckpointBody &body : checkpoint._dynamic_bodies)
+    {
+        _body_pool.count_created();
+        add_dynamic_body(JPH::BodyID{body._body_id});
+    }
+
+    // Motion, sleep state and the contact cache come from Jolt itself
+    JPH::StateRecorderImpl recorder{};
+    recorder.WriteBytes(checkpoint._jolt_state.data(),
+                        checkpoint._jolt_state.size());
+    recorder.Rewind();
+    if (!_physics_system->RestoreState(recorder))
+    {
+        spdlog::error("Jolt could not restore the checkpoint state");
+        return false;
+    }
+    return true;
 }
 
 void PhysicsEngine::start_simulation()
 {
+    const ShapeCacheStats &shape_cache_stats{_shape_cache.stats()};
+    spdlog::info("Shape cache: {} shapes, {} hits, {} misses, {} bytes saved",
+                 _shape_cache.size(),
+                 shape_cache_stats._hits,
+                 shape_cache_stats._misses,
+                 shape_cache_stats._bytes_saved);
+
     _physics_system->OptimizeBroadPhase();
 }
 
+void PhysicsEngine::step(const float delta_time)
+{
+    ++_step;
+
+    // If you take larger steps than 1 / 60th of a second you need to do
+    // multiple collision steps in order to keep the simulation stable. Do 1
+    // collision step per 1 / 60th of a second (round up).
+    constexpr int cCollisionSteps{1};
+
+    _physics_system->Update(delta_time,
+                            cCollisionSteps,
+                            _temp_allocator.get(),
+                            _job_system.get());
+    record_moved_bodies();
+    record_trace(delta_time);
+}
+
+void PhysicsEngine::record_moved_bodies()
+{
+    // A body moved this step if it is awake now, or was awake after the
+    // previous step and has just fallen asleep. Sleeping bodies keep their
+    // old step, so the render thread can skip them. Only the awake bodies
+    // are visited, so a settled scene costs next to nothing here.
+    for (const JPH::BodyID &body_id : _previously_active_body_ids)
+    {
+        _moved_steps[body_id.GetIndex()] = _step;
+    }
+    _physics_system->GetActiveBodies(_active_body_ids);
+    for (const JPH::BodyID &body_id : _active_body_ids)
+    {
+        _moved_steps[body_id.GetIndex()] = _step;
+    }
+    // keeps both capacities, so this does not allocate
+    _previously_active_body_ids.swap(_active_body_ids);
+}
+
+bool PhysicsEngine::start_trace(const std::string &path)
+{
+    stop_trace();
+    _trace_writer = std::make_unique<BodyTraceWriter>();
+    if (!_trace_writer->open(path))
+    {
+        spdlog::error("Could not open body trace {}", path);
+        _trace_writer.reset();
+        return false;
+    }
+    _contact_counter =
+        std::make_unique<BodyContactCounter>(_capacity._max_bodies);
+    _contact_listener->set_contact_counter(_contact_counter.get());
+    spdlog::info("Recording a body trace to {}", path);
+    return true;
+}
+
+void PhysicsEngine::stop_trace()
+{
+    if (!_trace_writer)
+    {
+        return;
+    }
+    _contact_listener->set_contact_counter(nullptr);
+    if (!_trace_writer->close())
+    {
+        spdlog::error("Body trace write failed after {} steps",
+                      _trace_writer->steps());
+    }
+    if (_trace_writer->dropped_steps() > 0)
+    {
+        spdlog::warn("Body trace dropped {} steps while the disk fell behind",
+                     _trace_writer->dropped_steps());
+    }
+    const auto raw_bytes{static_cast<double>(_trace_writer->raw_bytes())};
+    const auto written_bytes{
+        static_cast<double>(_trace_writer->written_bytes())};
+    spdlog::info("Body trace: {} steps, {:.1f} MB, {:.1f}x smaller than raw",
+                 _trace_writer->steps(),
+                 written_bytes / (1024.0 * 1024.0),
+                 written_bytes > 0.0 ? raw_bytes / written_bytes : 0.0);
+    _trace_writer.reset();
+    _contact_counter.reset();
+}
+
+void PhysicsEngine::record_trace(const float delta_time)
+{
+    if (!_trace_writer)
+    {
+        return;
+    }
+    if (_trace_writer->failed())
+    {
+        stop_trace();
+        return;
+    }
+    // Called from the thread stepping the simulation, so skip body locking
+    const JPH::BodyLockInterfaceNoLock &body_lock_interface{
+        _physics_system->GetBodyLockInterfaceNoLock()};
+
+    BodyTraceColumns &columns{_trace_columns};
+    columns._step = _step;
+    columns._delta_time = delta_time;
+    columns.resize(_dynamic_body_ids.size());
+    for (std::size_t index{0}; index < _dynamic_body_ids.size(); ++index)
+    {
+        const JPH::BodyID &body_id{_dynamic_body_ids[index]};
+        const JPH::BodyLockRead lock{body_lock_interface, body_id};
+        JPH_ASSERT(lock.Succeeded());
+        const JPH::Body &body{lock.GetBody()};
+        const JPH::RVec3 position{body.GetCenterOfMassPosition()};
+        const JPH::Vec3 velocity{body.GetLinearVelocity()};
+        columns._entities[index] = body.GetUserData();
+        columns._position[0][index] = static_cast<float>(position.GetX());
+        columns._position[1][index] = static_cast<float>(position.GetY());
+        columns._position[2][index] = static_cast<float>(position.GetZ());
+        columns._velocity[0][index] = velocity.GetX();
+        columns._velocity[1][index] = velocity.GetY();
+        columns._velocity[2][index] = velocity.GetZ();
+        columns._sleeping[index] = body.IsActive() ? 0 : 1;
+        columns._contacts[index] = _contact_counter->take(body_id.GetIndex());
+    }
+    _trace_writer->write(columns);
+}
+
+void PhysicsEngine::read_transforms(TransformSnapshot &snapshot) const
+{
+    // Only called from the thread stepping the simulation, so skip body locking
+    const JPH::BodyLockInterfaceNoLock &body_lock_interface{
+        _physics_system->GetBodyLockInterfaceNoLock()};
+
+    snapshot._step = _step;
+    snapshot._transforms.resize(_dynamic_body_ids.size());
+    auto transform{snapshot._transforms.begin()};
+    for (const JPH::BodyID &body_id : _dynamic_body_ids)
+    {
+        const JPH::BodyLockRead lock{body_lock_interface, body_id};
+        JPH_ASSERT(lock.Succeeded());
+        const JPH::Body &body{lock.GetBody()};
+        transform->_entity = body.GetUserData();
+        transform->_moved_step = _moved_steps[body_id.GetIndex()];
+
+        // Jolt keeps each of these in a 16-byte SIMD register already, so copy
+        // the whole lane. The w lanes end up as padding.
+        RigidBodyTransform &lanes{transform->_transform};
+        store_lanes(body.GetCenterOfMassPosition(), lanes._position);
+        store_lanes(body.GetRotation(), lanes._rotation);
+        store_lanes(body.GetLinearVelocity(), lanes._linear_velocity);
+        store_lanes(body.GetAngularVelocity(), lanes._angular_velocity);
+        ++transform;
+    }
+}
+
 bool PhysicsEngine::update(const float cDeltaTime,
                            Vector3 &sphere_position,
                            Vector3 &sphere_velocity,
@@ -308,7 +874,7 @@ bool PhysicsEngine::update(const float cDeltaTime,
     const JPH::RVec3 position{
         body_interface.GetCenterOfMassPosition(_sphere_id)};
     const JPH::Vec3 velocity{body_interface.GetLinearVelocity(_sphere_id)};
-    spdlog::info("Step {}: Position = ({:.{}f}, {:.{}f}, "
+    spdlog::debug("Step {}: Position = ({:.{}f}, {:.{}f}, "
                  "{:.{}f}), Velocity = ({:.{}f}, {:.{}f}, {:.{}f})\n",
                  _step,
                  position.GetX(),
@@ -336,34 +902,366 @@ bool PhysicsEngine::update(const float cDeltaTime,
         constexpr int cCollisionSteps{1};
 
         // Step the world
-        JPH::TempAllocatorImpl temp_allocator{10 * 1'024 * 1'024};
         _physics_system->Update(cDeltaTime,
                                 cCollisionSteps,
-                                &temp_allocator,
+                                _temp_allocator.get(),
                                 _job_system.get());
+        record_moved_bodies();
+        record_trace(cDeltaTime);
     }
     return true;
 }
 
+const ShapeCache &PhysicsEngine::shape_cache() const
+{
+    return _shape_cache;
+}
+
+const BodyPoolStats &PhysicsEngine::body_pool_stats() const
+{
+    return _body_pool.stats();
+}
+
+std::size_t PhysicsEngine::dynamic_body_count() const
+{
+    return _dynamic_body_ids.size();
+}
+
+std::size_t PhysicsEngine::parked_body_count() const
+{
+    return _parked_body_ids.size();
+}
+
+void PhysicsEngine::save_checkpoint(PhysicsCheckpoint &checkpoint) const
+{
+    const JPH::BodyLockInterfaceNoLock &body_lock_interface{
+        _physics_system->GetBodyLockInterfaceNoLock()};
+    const auto save_bodies{[&body_lock_interface](
+                               const std::vector<JPH::BodyID> &body_ids,
+                               std::vector<CheckpointBody> &bodies) {
+        bodies.resize(body_ids.size());
+        auto record{bodies.begin()};
+        for (const JPH::BodyID &body_id : body_ids)
+        {
+            const JPH::BodyLockRead lock{body_lock_interface, body_id};
+            JPH_ASSERT(lock.Succeeded());
+            const JPH::Body &body{lock.GetBody()};
+            record->_entity = body.GetUserData();
+            record->_body_id = body_id.GetIndexAndSequenceNumber();
+            record->_dynamic = body.IsDynamic() ? 1 : 0;
+            const JPH::Shape *shape{body.GetShape()};
+            if (shape->GetSubType() == JPH::EShapeSubType::Sphere)
+            {
+                record->_shape = ShapeType::kSphere;
+                record->_dimensions = Vector3{
+                    static_cast<const JPH::SphereShape *>(shape)->GetRadius(),
+                    0.F,
+                    0.F};
+            }
+            else
+            {
+                JPH_ASSERT(shape->GetSubType() == JPH::EShapeSubType::Box);
+                const JPH::Vec3 half_extent{
+                    static_cast<const JPH::BoxShape *>(shape)->GetHalfExtent()};
+                record->_shape = ShapeType::kBox;
+                record->_dimensions = Vector3{half_extent.GetX(),
+                                              half_extent.GetY(),
+                                              half_extent.GetZ()};
+            }
+            const JPH::RVec3 position{body.GetPosition()};
+            const JPH::Quat rotation{body.GetRotation()};
+            record->_position = Vector3{static_cast<float>(position.GetX()),
+                                        static_cast<float>(position.GetY()),
+                                        static_cast<float>(position.GetZ())};
+            record->_rotation = Quaternion{rotation.GetX(),
+                                           rotation.GetY(),
+                                           rotation.GetZ(),
+                                           rotation.GetW()};
+            record->_friction = body.GetFriction();
+            record->_restitution = body.GetRestitution();
+            ++record;
+        }
+    }};
+
+    checkpoint._capacity = _capacity;
+    checkpoint._step = _step;
+    checkpoint._sphere_body_id = _sphere_id.GetIndexAndSequenceNumber();
+    save_bodies(_static_body_ids, checkpoint._static_bodies);
+    save_bodies(_dynamic_body_ids, checkpoint._dynamic_bodies);
+
+    JPH::StateRecorderImpl recorder{};
+    _physics_system->SaveState(recorder);
+    const std::string state{recorder.GetData()};
+    checkpoint._jolt_state.resize(state.size());
+    std::memcpy(checkpoint._jolt_state.data(), state.data(), state.size());
+}
+
+JoltMemoryStats PhysicsEngine::memory_stats() const
+{
+    const JPH::BodyManager::BodyStats body_stats{
+        _physics_system->GetBodyStats()};
+    const auto max_bodies{static_cast<std::size_t>(body_stats.mMaxBodies)};
+
+    JoltMemoryStats stats{};
+    stats._bodies = body_stats.mNumBodies;
+    stats._active_bodies = body_stats.mNumActiveBodiesDynamic +
+                           body_stats.mNumActiveBodiesKinematic;
+    stats._max_bodies = body_stats.mMaxBodies;
+    stats._max_body_pairs = _capacity._max_body_pairs;
+    stats._max_contact_constraints = _capacity._max_contact_constraints;
+
+    // moving bodies are allocated together with their motion properties
+    stats._body_bytes =
+        static_cast<std::size_t>(body_stats.mNumBodies) * sizeof(JPH::Body) +
+        static_cast<std::size_t>(body_stats.mNumBodiesDynamic +
+                                 body_stats.mNumBodiesKinematic) *
+            sizeof(JPH::MotionProperties);
+
+    // body pointer array, active body list and body ID lookup
+    stats._body_manager_bytes =
+        max_bodies * (sizeof(JPH::Body *) + 2 * sizeof(JPH::BodyID));
+    // BroadPhaseQuadTree::Init sizes one node pool for every layer tree:
+    // a leaf per two bodies, a third as many again for the nodes above them,
+    // and twice that for rebuilding trees during Update
+    const std::size_t quad_tree_leaves{(max_bodies + 1) / 2};
+    const std::size_t quad_tree_nodes{
+        2 * (quad_tree_leaves + (quad_tree_leaves + 2) / 3)};
+    stats._broad_phase_bytes = quad_tree_nodes * kQuadTreeNodeBytes +
+                               max_bodies * kBroadPhaseTrackingBytes;
+    // ContactConstraintManager keeps two caches, last step's and this one's
+    stats._contact_cache_bytes =
+        2 * (static_cast<std::size_t>(_capacity._max_body_pairs) *
+                 kCachedBodyPairBytes +
+             static_cast<std::size_t>(_capacity._max_contact_constraints) *
+                 kCachedManifoldBytes);
+    stats._temp_allocator_bytes = _capacity._temp_allocator_bytes;
+    stats._shape_bytes = _shape_cache.shape_bytes();
+    return stats;
+}
+
+bool PhysicsEngine::cast_ray(const Vector3 &origin,
+                             const Vector3 &direction,
+                             const float max_distance,
+                             RayHit &hit) const
+{
+    // The narrow phase query walks the broadphase trees first, so only bodies
+    // whose bounds the ray crosses are tested against their shapes
+    const JPH::RRayCast ray{
+        JPH::RVec3{origin.x, origin.y, origin.z},
+        JPH::Vec3{direction.x, direction.y, direction.z} * max_distance};
+    JPH::RayCastResult result;
+    if (!_physics_system->GetNarrowPhaseQuery().CastRay(ray, result))
+    {
+        return false;
+    }
+
+    const JPH::RVec3 point{ray.GetPointOnRay(result.mFraction)};
+    hit._entity =
+        _physics_system->GetBodyInterface().GetUserData(result.mBodyID);
+    hit._point = Vector3{static_cast<float>(point.GetX()),
+                         static_cast<float>(point.GetY()),
+                         static_cast<float>(point.GetZ())};
+    hit._distance = result.mFraction * max_distance;
+    return true;
+}
+
+void PhysicsEngine::run_spatial_queries(
+    const SpatialQueryBatch &batch,
+    std::vector<SpatialQueryResult> &results) const
+{
+    const std::vector<SpatialQueryRequest> &requests{batch.requests()};
+    results.resize(requests.size());
+    const auto run_range{[this, &requests, &results](const std::size_t begin,
+                                                      const std::size_t end) {
+        for (std::size_t index{begin}; index < end; ++index)
+        {
+            results[index]._entity = requests[index]._entity;
+            run_spatial_query(requests[index], results[index]._hits);
+        }
+    }};
+
+    // Small batches are not worth handing out to the job threads
+    constexpr std::size_t kQueriesPerJob{32};
+    if (requests.size() <= kQueriesPerJob)
+    {
+        run_range(0, requests.size());
+        return;
+    }
+
+    JPH::JobSystem::Barrier *barrier{_job_system->CreateBarrier()};
+    for (std::size_t begin{0}; begin < requests.size(); begin += kQueriesPerJob)
+    {
+        const std::size_t end{
+            std::min(begin + kQueriesPerJob, requests.size())};
+        barrier->AddJob(_job_system->CreateJob(
+            "Spatial queries", JPH::Color::sCyan, [&run_range, begin, end]() {
+                run_range(begin, end);
+            }));
+    }
+    _job_system->WaitForJobs(barrier);
+    _job_system->DestroyBarrier(barrier);
+}
+
+void PhysicsEngine::run_spatial_query(const SpatialQueryRequest &request,
+                                      SpatialQueryHits &hits) const
+{
+    // Nothing steps while a batch runs, so none of this takes body locks
+    hits = SpatialQueryHits{};
+    const JPH::BodyID ignore_body_id{request._ignore_body_id};
+    const JPH::BodyInterface &body_interface{
+        _physics_system->GetBodyInterfaceNoLock()};
+    const JPH::Vec3 origin{
+        request._origin.x, request._origin.y, request._origin.z};
+    const float range{request._query._range};
+
+    switch (request._query._type)
+    {
+    case SpatialQueryType::kRadius:
+    {
+        // The broad phase finds bodies whose bounds touch the sphere, then
+        // their centres are checked against the radius
+        JPH::AllHitCollisionCollector<JPH::CollideShapeBodyCollector> collector;
+        _physics_system->GetBroadPhaseQuery().CollideSphere(
+            origin, range, collector);
+        for (const JPH::BodyID &body_id : collector.mHits)
+        {
+            if (body_id != ignore_body_id &&
+                (body_interface.GetCenterOfMassPosition(body_id) - origin)
+                        .LengthSq() <= range * range)
+            {
+                add_spatial_query_hit(hits,
+                                      body_interface.GetUserData(body_id));
+            }
+        }
+        break;
+    }
+    case SpatialQueryType::kOverlap:
+    {
+        JPH::SphereShape sphere{range};
+        sphere.SetEmbedded();
+        const JPH::CollideShapeSettings settings{};
+        JPH::AllHitCollisionCollector<JPH::CollideShapeCollector> collector;
+        _physics_system->GetNarrowPhaseQueryNoLock().CollideShape(
+            &sphere,
+            JPH::Vec3::sReplicate(1.F),
+            JPH::RMat44::sTranslation(JPH::RVec3{origin}),
+            settings,
+            JPH::RVec3::sZero(),
+            collector,
+            {},
+            {},
+            JPH::IgnoreSingleBodyFilter{ignore_body_id});
+        for (const JPH::CollideShapeResult &result : collector.mHits)
+        {
+            add_spatial_query_hit(hits,
+                                  body_interface.GetUserData(result.mBodyID2));
+        }
+        break;
+    }
+    case SpatialQueryType::kRaycast:
+    {
+        const Vector3 &direction{request._query._direction};
+        const JPH::RRayCast ray{
+            JPH::RVec3{origin},
+            JPH::Vec3{direction.x, direction.y, direction.z} * range};
+        JPH::RayCastResult result{};
+        if (!_physics_system->GetNarrowPhaseQueryNoLock().CastRay(
+                ray,
+                result,
+                {},
+                {},
+                JPH::IgnoreSingleBodyFilter{ignore_body_id}))
+        {
+            break;
+        }
+        const JPH::RVec3 point{ray.GetPointOnRay(result.mFraction)};
+        add_spatial_query_hit(hits, body_interface.GetUserData(result.mBodyID));
+        hits._point = Vector3{static_cast<float>(point.GetX()),
+                              static_cast<float>(point.GetY()),
+                              static_cast<float>(point.GetZ())};
+        hits._distance = result.mFraction * range;
+        break;
+    }
+    }
+}
+
+bool PhysicsEngine::draw_debug(const DebugDrawSettings &settings,
+                               const Vector3 &camera_position,
+                               DebugVertexCollector &collector)
+{
+    collector.clear();
+#ifdef JPH_DEBUG_RENDERER
+    // Jolt draws contacts while it steps, the renderer keeps them for the
+    // next pass
+    JPH::ContactConstraintManager::sDrawContactManifolds =
+        settings._enabled && settings._contacts;
+    if (!settings._enabled)
+    {
+        return true;
+    }
+    if (!_debug_renderer)
+    {
+        _debug_renderer = std::make_unique<JoltDebugRenderer>();
+    }
+
+    JPH::BodyManager::DrawSettings draw_settings{};
+    draw_settings.mDrawShape = settings._shapes;
+    draw_settings.mDrawShapeWireframe = settings._wireframe;
+    draw_settings.mDrawShapeColor =
+        settings._sleep_colours ? JPH::BodyManager::EShapeColor::SleepColor
+                                : JPH::BodyManager::EShapeColor::MotionTypeColor;
+    draw_settings.mDrawBoundingBox = settings._bounding_boxes;
+    draw_settings.mDrawVelocity = settings._velocities;
+    draw_settings.mDrawCenterOfMassTransform = settings._centres_of_mass;
+
+    _debug_renderer->begin(collector, camera_position);
+    _physics_system->DrawBodies(draw_settings, _debug_renderer.get());
+    _debug_renderer->end();
+    return true;
+#else
+    static_cast<void>(settings);
+    static_cast<void>(camera_position);
+    return false;
+#endif
+}
+
 void PhysicsEngine::cleanup()
 {
     JPH::BodyInterface &body_interface{_physics_system->GetBodyInterface()};
 
-    // Remove the sphere from the physics system. Note that the sphere itself
-    // keeps all of its state and can be re-added at any time.
-    body_interface.RemoveBody(_sphere_id);
+    // Remove the bodies from the physics system. Note that the bodies
+    // themselves keep all of their state and can be re-added at any time.
+    // Pooled bodies were already removed.
+    std::vector<JPH::BodyID> body_ids{_static_body_ids};
+    body_ids.insert(
+        body_ids.end(), _dynamic_body_ids.begin(), _dynamic_body_ids.end());
+    body_interface.RemoveBodies(body_ids.data(),
+                                static_cast<int>(body_ids.size()));
 
-    // Destroy the sphere. After this the sphere ID is no longer valid.
-    body_interface.DestroyBody(_sphere_id);
+    // Destroy the bodies. After this the body IDs are no longer valid.
+    const std::vector<JPH::BodyID> pooled_body_ids{_body_pool.drain()};
+    body_ids.insert(
+        body_ids.end(), pooled_body_ids.begin(), pooled_body_ids.end());
+    for (const std::uint32_t body_id : _parked_body_ids)
+    {
+        body_ids.emplace_back(body_id);
+    }
+    body_interface.DestroyBodies(body_ids.data(),
+                                 static_cast<int>(body_ids.size()));
+    _static_body_ids.clear();
+    _dynamic_body_ids.clear();
+    _parked_body_ids.clear();
+    stop_trace();
 
-    // Remove and destroy the floor
-    body_interface.RemoveBody(_floor_id);
-    body_interface.DestroyBody(_floor_id);
+#ifdef JPH_DEBUG_RENDERER
+    JPH::ContactConstraintManager::sDrawContactManifolds = false;
+    _debug_renderer.reset();
+#endif
 
-    // Unregisters all types with the factory and cleans up the default material
-    JPH::UnregisterTypes();
+    // Release the shared shapes while the factory still exists
+    _shape_cache.clear();
 
-    // Destroy the factory
-    delete JPH::Factory::sInstance;
-    JPH::Factory::sInstance = nullptr;
+    // The last engine to clean up unregisters the types and destroys the
+    // factory
+    _jolt_runtime.reset();
 }
@@ -12,18 +12,37 @@
 #include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Core/TempAllocator.h>
 #include <Jolt/Math/Real.h>
+#include <Jolt/Physics/Body/BodyID.h>
 #include <Jolt/Physics/Body/Body.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
+#include <Jolt/Physics/Body/BodyManager.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
 #include <Jolt/Physics/Collision/ContactListener.h>
 #include <Jolt/Physics/Collision/ObjectLayer.h>
 #include <Jolt/Physics/Collision/Shape/SubShapeIDPair.h>
+#include <Jolt/Physics/EActivation.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <raylib.h>
 #include <spdlog/spdlog.h>
 
+#include "body_pool.h"
+#include "body_trace.h"
+#include "debug_draw.h"
+#include "jolt_debug_renderer.h"
+#include "jolt_runtime.h"
+#include "memory_stats.h"
+#include "physics_commands.h"
+#include "shape_cache.h"
+#include "spatial_query.h"
+#include "transform_snapshot.h"
+
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 // Layer that objects can be in, determines which other objects it can collide
 // with Typically you at least want to have 1 layer for moving bodies and 1
@@ -158,20 +177,22 @@ public:
         return JPH::ValidateResult::AcceptAllContactsForThisBodyPair;
     }
 
-    void OnContactAdded(const JPH::Body & /* inBody1 */,
-                        const JPH::Body & /* inBody2 */,
+    void OnContactAdded(const JPH::Body &inBody1,
+                        const JPH::Body &inBody2,
                         const JPH::ContactManifold & /* inManifold */,
                         JPH::ContactSettings & /* ioSettings */) override
     {
         spdlog::info("A contact was added");
+        count_contact(inBody1, inBody2);
     }
 
-    void OnContactPersisted(const JPH::Body & /* inBody1 */,
-                            const JPH::Body & /* inBody2 */,
+    void OnContactPersisted(const JPH::Body &inBody1,
+                            const JPH::Body &inBody2,
                             const JPH::ContactManifold & /* inManifold */,
                             JPH::ContactSettings & /* ioSettings */) override
     {
         spdlog::info("A contact was persisted");
+        count_contact(inBody1, inBody2);
     }
 
     void OnContactRemoved(
@@ -179,6 +200,24 @@ public:
     {
         spdlog::info("A contact was removed");
     }
+
+    // Count contacts per body while a trace is recording, nullptr to stop
+    void set_contact_counter(BodyContactCounter *contact_counter)
+    {
+        _contact_counter = contact_counter;
+    }
+
+private:
+    void count_contact(const JPH::Body &body_1, const JPH::Body &body_2)
+    {
+        if (_contact_counter != nullptr)
+        {
+            _contact_counter->add(body_1.GetID().GetIndex());
+            _contact_counter->add(body_2.GetID().GetIndex());
+        }
+    }
+
+    BodyContactCounter *_contact_counter{nullptr};
 };
 
 // An example activation listener
@@ -198,27 +237,160 @@ public:
     }
 };
 
+struct PhysicsCapacity
+{
+    // This is the max amount of rigid bodies that you can add to the physics
+    // system. If you try to add more you'll get an error. Note: This value is
+    // low because this is a simple test. For a real project use something in
+    // the order of 65536.
+    JPH::uint _max_bodies{1'024};
+
+    // This is the max amount of body pairs that can be queued at any time (the
+    // broad phase will detect overlapping body pairs based on their bounding
+    // boxes and will insert them into a queue for the narrowphase). If you make
+    // this buffer too small the queue will fill up and the broad phase jobs
+    // will start to do narrow phase work. This is slightly less efficient.
+    JPH::uint _max_body_pairs{1'024};
+
+    // This is the maximum size of the contact constraint buffer. If more
+    // contacts (collisions between bodies) are detected than this number then
+    // these contacts will be ignored and bodies will start interpenetrating /
+    // fall through the world.
+    JPH::uint _max_contact_constraints{1'024};
+
+    // Pre-allocated so the physics update does not have to allocate. 10 MB is
+    // a typical value, the memory panel shows how much a scene really needs.
+    std::size_t _temp_allocator_bytes{10 * 1'024 * 1'024};
+
+    // Threads the job system starts besides the thread calling step, -1 for
+    // one per remaining core. Use 0 when several engines share the cores.
+    int _job_threads{-1};
+};
+
+struct RayHit
+{
+    std::uint64_t _entity{0};
+    Vector3 _point{0.F, 0.F, 0.F};
+    float _distance{0.F};
+};
+
+// A body as it was created, enough to create it again with the same ID. Its
+// state comes from Jolt's own saved state, see PhysicsCheckpoint.
+struct CheckpointBody
+{
+    std::uint64_t _entity{0};
+    std::uint32_t _body_id{0}; // BodyID::GetIndexAndSequenceNumber()
+    ShapeType _shape{ShapeType::kSphere};
+    std::uint8_t _dynamic{0};
+    Vector3 _dimensions{0.F, 0.F, 0.F}; // radius in x, or the box half extent
+    Vector3 _position{0.F, 0.F, 0.F};
+    Quaternion _rotation{0.F, 0.F, 0.F, 1.F};
+    float _friction{0.F};
+    float _restitution{0.F};
+};
+
+// Everything needed to recreate an engine mid-simulation: its capacity, the
+// bodies in the system and JPH::PhysicsSystem::SaveState output, which holds
+// body motion, sleep state and the contact cache
+struct PhysicsCheckpoint
+{
+    PhysicsCapacity _capacity{};
+    std::uint64_t _step{0};
+    std::uint32_t _sphere_body_id{JPH::BodyID::cInvalidBodyID};
+    std::vector<CheckpointBody> _static_bodies;
+    std::vector<CheckpointBody> _dynamic_bodies;
+    std::vector<std::uint8_t> _jolt_state;
+};
+
 class PhysicsEngine
 {
 public:
     PhysicsEngine();
 
     // mutator methods
-    void initialise();
-    void create_floor(const Vector3 &floor_dimensions,
-                      const Vector3 &floor_position);
-    void create_ball(float ball_radius,
-                     const Vector3 &ball_position,
-                     const Vector3 &ball_velocity);
+    void initialise(const PhysicsCapacity &capacity = PhysicsCapacity{});
+    JPH::BodyID create_floor(const Vector3 &floor_dimensions,
+                             const Vector3 &floor_position,
+                             std::uint64_t entity_id);
+    JPH::BodyID create_ball(float ball_radius,
+                            const Vector3 &ball_position,
+                            const Vector3 &ball_velocity,
+                            std::uint64_t entity_id);
+    // Runtime spawning. spawn_ball reuses a pooled body with the same shape
+    // when there is one, and despawn_body can return the body to the pool
+    // instead of destroying it.
+    JPH::BodyID spawn_ball(float ball_radius,
+                           const Vector3 &ball_position,
+                           const Vector3 &ball_velocity,
+                           std::uint64_t entity_id);
+    void despawn_body(const JPH::BodyID &body_id, bool recycle);
+    void prewarm_ball_pool(float ball_radius, std::size_t count);
+    // Apply a frame of body changes from the collider observers. Removed
+    // and added bodies each go through the broadphase in one batch, and
+    // removed spheres are pooled for later creates. Each create gets the ID
+    // of its body, kNoPhysicsBody when it could not be made.
+    void apply_body_commands(std::vector<PhysicsCommand> &commands);
+    // Take bodies out of the broadphase for as long as their part of the
+    // world is streamed out. They keep their state, and unpark_bodies adds
+    // them back in one batch. Parked bodies are not stepped, read into
+    // snapshots or saved in checkpoints.
+    void park_bodies(const std::vector<std::uint32_t> &body_ids);
+    void unpark_bodies(const std::vector<std::uint32_t> &body_ids);
+    // Record every dynamic body after each step to a body trace file. Call
+    // after initialise; cleanup stops the trace.
+    bool start_trace(const std::string &path);
+    void stop_trace();
+    // Recreate the bodies and state of a checkpoint. Call after initialise,
+    // with the checkpoint capacity, instead of creating any bodies.
+    bool restore_checkpoint(const PhysicsCheckpoint &checkpoint);
     void start_simulation();
+    void step(float delta_time);
     bool update(float cDeltaTime,
                 Vector3 &sphere_position,
                 Vector3 &sphere_velocity,
                 bool paused);
     void cleanup();
 
+    // accessor methods
+    void read_transforms(TransformSnapshot &snapshot) const;
+    void save_checkpoint(PhysicsCheckpoint &checkpoint) const;
+    [[nodiscard]] const ShapeCache &shape_cache() const;
+    [[nodiscard]] const BodyPoolStats &body_pool_stats() const;
+    [[nodiscard]] std::size_t dynamic_body_count() const;
+    [[nodiscard]] std::size_t parked_body_count() const;
+    [[nodiscard]] JoltMemoryStats memory_stats() const;
+    bool cast_ray(const Vector3 &origin,
+                  const Vector3 &direction,
+                  float max_distance,
+                  RayHit &hit) const;
+    // Answer every request in the batch, spread over the job system, into
+    // results in request order. The engine must not be stepping;
+    // PhysicsThread runs submitted batches itself, between steps.
+    void run_spatial_queries(const SpatialQueryBatch &batch,
+                             std::vector<SpatialQueryResult> &results) const;
+    // Collect Jolt's debug drawing of every body into collector, and turn
+    // contact drawing on or off for the steps that follow. Returns false when
+    // Jolt was built without its debug renderer. The engine must not be
+    // stepping, so for the physics thread call this from
+    // PhysicsThread::with_engine.
+    bool draw_debug(const DebugDrawSettings &settings,
+                    const Vector3 &camera_position,
+                    DebugVertexCollector &collector);
+
 private:
+    void add_dynamic_body(const JPH::BodyID &body_id);
+    void remove_dynamic_body(const JPH::BodyID &body_id);
+    void add_bodies(std::vector<JPH::BodyID> &body_ids,
+                    JPH::EActivation activation);
+    void record_moved_bodies();
+    void record_trace(float delta_time);
+    void run_spatial_query(const SpatialQueryRequest &request,
+                           SpatialQueryHits &hits) const;
+
+    // declared first so it outlives everything below that uses Jolt
+    std::unique_ptr<JoltRuntime> _jolt_runtime;
     JPH::uint _step{0};
+    PhysicsCapacity _capacity{};
     std::unique_ptr<JPH::PhysicsSystem> _physics_system;
     std::unique_ptr<JPH::TempAllocatorImpl> _temp_allocator;
     std::unique_ptr<JPH::JobSystemThreadPool> _job_system;
@@ -228,8 +400,32 @@ private:
     std::unique_ptr<ObjectVsBroadPhaseLayerFilterImpl>
         _object_vs_broadphase_layer_filter;
     std::unique_ptr<ObjectLayerPairFilterImpl> _object_vs_object_layer_filter;
+    ShapeCache _shape_cache{};
+    BodyPool _body_pool{};
     JPH::BodyID _sphere_id;
-    JPH::BodyID _floor_id;
+    std::vector<JPH::BodyID> _static_body_ids;
+    std::vector<JPH::BodyID> _dynamic_body_ids;
+    // streamed out, see park_bodies
+    std::unordered_set<std::uint32_t> _parked_body_ids;
+
+    // position of each dynamic body in _dynamic_body_ids, by body index
+    std::vector<std::uint32_t> _dynamic_body_slots;
+
+    // last step each body moved in, by body index, and the bodies that were
+    // awake after the previous step
+    std::vector<std::uint64_t> _moved_steps;
+    JPH::BodyIDVector _active_body_ids;
+    JPH::BodyIDVector _previously_active_body_ids;
+
+    // body trace, only while recording
+    std::unique_ptr<BodyTraceWriter> _trace_writer;
+    std::unique_ptr<BodyContactCounter> _contact_counter;
+    BodyTraceColumns _trace_columns{};
+
+#ifdef JPH_DEBUG_RENDERER
+    // created on the first draw, as Jolt has one global debug renderer
+    std::unique_ptr<JoltDebugRenderer> _debug_renderer;
+#endif
 };
 
 #endif
@@ -0,0 +1,109 @@
+#include "physics_commands.h"
+
+#include "shape_type.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+void PhysicsCommandBuffer::clear()
+{
+    _commands.clear();
+    _pending.clear();
+    _destroyed.clear();
+}
+
+void PhysicsCommandBuffer::create(const std::uint64_t entity,
+                                  const ShapeType shape)
+{
+    if (_pending.count(entity) != 0)
+    {
+        return;
+    }
+    _pending.emplace(entity, _commands.size());
+    PhysicsCommand command{};
+    command._type = PhysicsCommandType::kCreate;
+    command._entity = entity;
+    command._shape = shape;
+    _commands.push_back(command);
+}
+
+void PhysicsCommandBuffer::update(const std::uint64_t entity,
+                                  const ShapeType shape,
+                                  const std::uint32_t body_id)
+{
+    // the body is going, so the new collider needs a body of its own
+    if (_destroyed.count(entity) != 0)
+    {
+        create(entity, shape);
+        return;
+    }
+    if (_pending.count(entity) != 0)
+    {
+        return;
+    }
+    _pending.emplace(entity, _commands.size());
+    PhysicsCommand command{};
+    command._type = PhysicsCommandType::kUpdate;
+    command._entity = entity;
+    command._shape = shape;
+    command._body_id = body_id;
+    _commands.push_back(command);
+}
+
+void PhysicsCommandBuffer::destroy(const std::uint64_t entity,
+                                   const std::uint32_t body_id)
+{
+    cancel_pending(entity);
+    if (body_id == kNoPhysicsBody || !_destroyed.insert(entity).second)
+    {
+        return;
+    }
+    PhysicsCommand command{};
+    command._type = PhysicsCommandType::kDestroy;
+    command._entity = entity;
+    command._body_id = body_id;
+    _commands.push_back(command);
+}
+
+std::vector<PhysicsCommand> &PhysicsCommandBuffer::commands()
+{
+    return _commands;
+}
+
+const std::vector<PhysicsCommand> &PhysicsCommandBuffer::commands() const
+{
+    return _commands;
+}
+
+std::size_t PhysicsCommandBuffer::size() const
+{
+    return _commands.size();
+}
+
+bool PhysicsCommandBuffer::empty() const
+{
+    return _commands.empty();
+}
+
+void PhysicsCommandBuffer::cancel_pending(const std::uint64_t entity)
+{
+    const auto pending{_pending.find(entity)};
+    if (pending == _pending.end())
+    {
+        return;
+    }
+
+    // swap with the last command, so cancelling does not shift the rest
+    const std::size_t index{pending->second};
+    _pending.erase(pending);
+    if (index + 1 != _commands.size())
+    {
+        _commands[index] = _commands.back();
+        if (_commands[index]._type != PhysicsCommandType::kDestroy)
+        {
+            _pending[_commands[index]._entity] = index;
+        }
+    }
+    _commands.pop_back();
+}
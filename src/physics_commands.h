@@ -0,0 +1,72 @@
+#ifndef SRC_PHYSICS_COMMANDS_H
+#define SRC_PHYSICS_COMMANDS_H
+
+#include "shape_type.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+inline constexpr std::uint32_t kNoPhysicsBody{0xffffffff};
+
+enum class PhysicsCommandType : std::uint8_t
+{
+    kCreate,  // the entity got a collider and has no body yet
+    kUpdate,  // the collider of an entity with a body changed
+    kDestroy, // the collider went, with its entity or on its own
+};
+
+// A change to an entity's body, waiting for the next sync point. The shape,
+// position and velocity are read from the entity when the buffer is flushed,
+// as an entity is usually still being built when its collider is set.
+struct PhysicsCommand
+{
+    PhysicsCommandType _type{PhysicsCommandType::kCreate};
+    std::uint64_t _entity{0};
+    ShapeType _shape{ShapeType::kSphere};
+    Vector3 _dimensions{0.F, 0.F, 0.F}; // radius in x, or the box half extent
+    Vector3 _position{0.F, 0.F, 0.F};
+    Vector3 _velocity{0.F, 0.F, 0.F};
+    // BodyID::GetIndexAndSequenceNumber() of the body to destroy or update,
+    // or of the body a create made
+    std::uint32_t _body_id{kNoPhysicsBody};
+};
+
+// Body changes recorded by the collider observers over a frame, then applied
+// together by PhysicsEngine::apply_body_commands. An entity has at most one
+// create or update pending: repeats are dropped, and destroying an entity
+// whose body was never made cancels its create. A body is never updated after
+// its destroy: setting a collider again in the same frame makes a new body.
+// The vector keeps its capacity between frames.
+class PhysicsCommandBuffer
+{
+public:
+    PhysicsCommandBuffer() = default;
+
+    // mutator methods
+    void clear();
+    void create(std::uint64_t entity, ShapeType shape);
+    void update(std::uint64_t entity, ShapeType shape, std::uint32_t body_id);
+    void destroy(std::uint64_t entity, std::uint32_t body_id);
+    [[nodiscard]] std::vector<PhysicsCommand> &commands();
+
+    // accessor methods
+    [[nodiscard]] const std::vector<PhysicsCommand> &commands() const;
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] bool empty() const;
+
+private:
+    void cancel_pending(std::uint64_t entity);
+
+    std::vector<PhysicsCommand> _commands{};
+    // index in _commands of each entity's pending create or update
+    std::unordered_map<std::uint64_t, std::size_t> _pending{};
+    // entities with a pending destroy
+    std::unordered_set<std::uint64_t> _destroyed{};
+};
+
+#endif
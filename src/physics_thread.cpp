@@ -0,0 +1,136 @@
+#include "physics_thread.h"
+
+#include "flight_recorder.h"
+#include "physics.h"
+#include "spatial_query.h"
+#include "transform_snapshot.h"
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ratio>
+#include <thread>
+
+PhysicsThread::PhysicsThread(PhysicsEngine &physics_engine,
+                             const int tick_rate)
+    : _physics_engine(physics_engine),
+      _tick_duration(std::chrono::nanoseconds{std::chrono::seconds{1}} /
+                     tick_rate),
+      _delta_time(1.F / static_cast<float>(tick_rate))
+{
+}
+
+PhysicsThread::~PhysicsThread()
+{
+    stop();
+}
+
+void PhysicsThread::start()
+{
+    if (_running.exchange(true))
+    {
+        return;
+    }
+    _thread = std::thread{&PhysicsThread::run, this};
+}
+
+void PhysicsThread::stop()
+{
+    _running.store(false, std::memory_order_release);
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void PhysicsThread::set_paused(const bool paused)
+{
+    _paused.store(paused, std::memory_order_relaxed);
+}
+
+void PhysicsThread::request_step()
+{
+    _step_requested.store(true, std::memory_order_relaxed);
+}
+
+bool PhysicsThread::acquire_snapshot()
+{
+    return _snapshots.acquire();
+}
+
+SpatialQueryBatch &PhysicsThread::spatial_query_batch()
+{
+    return _spatial_queries.write_buffer();
+}
+
+void PhysicsThread::submit_spatial_queries()
+{
+    _spatial_queries.publish();
+}
+
+const TransformSnapshot &PhysicsThread::snapshot() const
+{
+    return _snapshots.read_buffer();
+}
+
+void PhysicsThread::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    // If the thread falls this many ticks behind (e.g. a debugger break),
+    // resynchronise to the wall clock instead of stepping to catch up
+    constexpr int kMaxTicksBehind{4};
+
+    spdlog::info("Physics thread started");
+    Clock::time_point next_tick{Clock::now()};
+    while (_running.load(std::memory_order_acquire))
+    {
+        const bool step_once{
+            _step_requested.exchange(false, std::memory_order_relaxed)};
+        const bool paused{_paused.load(std::memory_order_relaxed)};
+        const bool stepping{!paused || step_once};
+        const bool queries_submitted{_spatial_queries.acquire()};
+
+        // Nothing moves while paused, so leave the last snapshot current
+        // rather than publishing an identical one every tick, unless there
+        // are spatial queries to answer
+        if (stepping || queries_submitted)
+        {
+            const Clock::time_point step_start{Clock::now()};
+            TransformSnapshot &snapshot{_snapshots.write_buffer()};
+            {
+                const std::lock_guard<std::mutex> lock{_engine_mutex};
+                if (stepping)
+                {
+                    _physics_engine.step(_delta_time);
+                }
+                _physics_engine.read_transforms(snapshot);
+                // the latest batch is answered against every step, so each
+                // snapshot carries answers even if the render thread skips
+                // the one after its batch was submitted
+                _physics_engine.run_spatial_queries(
+                    _spatial_queries.read_buffer(),
+                    snapshot._spatial_query_results);
+            }
+            snapshot._step_milliseconds =
+                std::chrono::duration<float, std::milli>{Clock::now() -
+                                                         step_start}
+                    .count();
+            flight_recorder().record_physics_step(snapshot._step,
+                                                  snapshot._step_milliseconds,
+                                                  snapshot._transforms.size());
+            _snapshots.publish();
+        }
+
+        next_tick += _tick_duration;
+        const Clock::time_point now{Clock::now()};
+        if (now - next_tick > _tick_duration * kMaxTicksBehind)
+        {
+            next_tick = now;
+        }
+        std::this_thread::sleep_until(next_tick);
+    }
+    spdlog::info("Physics thread stopped");
+}
@@ -0,0 +1,73 @@
+#ifndef SRC_PHYSICS_THREAD_H
+#define SRC_PHYSICS_THREAD_H
+
+#include "physics.h"
+#include "spatial_query.h"
+#include "transform_snapshot.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+// Steps the physics engine at a fixed rate on a dedicated thread, so a frame
+// costs max(render, physics) rather than their sum. After every step the
+// dynamic body transforms are published to a triple buffer, which the render
+// thread reads without taking a lock. Spatial queries go the other way
+// through a second triple buffer; the latest batch is answered after every
+// step and published with its snapshot.
+class PhysicsThread
+{
+public:
+    PhysicsThread(PhysicsEngine &physics_engine, int tick_rate);
+    ~PhysicsThread();
+    PhysicsThread(const PhysicsThread &) = delete;
+    PhysicsThread &operator=(const PhysicsThread &) = delete;
+    PhysicsThread(PhysicsThread &&) = delete;
+    PhysicsThread &operator=(PhysicsThread &&) = delete;
+
+    // mutator methods
+    void start();
+    void stop();
+    void set_paused(bool paused);
+    void request_step();
+
+    // Make the most recently published snapshot current. Returns false if
+    // the physics thread has not finished a step since the last call.
+    bool acquire_snapshot();
+
+    // The batch to fill with this frame's spatial queries, then hand over
+    // with submit_spatial_queries. Batches submitted faster than the physics
+    // thread steps replace each other.
+    SpatialQueryBatch &spatial_query_batch();
+    void submit_spatial_queries();
+
+    // Run a function against the engine between physics steps. Use for rare
+    // operations only, as the physics thread waits on the same lock.
+    template <typename Function>
+    void with_engine(Function &&function)
+    {
+        const std::lock_guard<std::mutex> lock{_engine_mutex};
+        function(_physics_engine);
+    }
+
+    // accessor methods
+    [[nodiscard]] const TransformSnapshot &snapshot() const;
+
+private:
+    void run();
+
+    PhysicsEngine &_physics_engine;
+    std::chrono::nanoseconds _tick_duration;
+    float _delta_time;
+    TripleBuffer<TransformSnapshot> _snapshots{};
+    TripleBuffer<SpatialQueryBatch> _spatial_queries{};
+    std::mutex _engine_mutex{};
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _paused{false};
+    std::atomic<bool> _step_requested{false};
+    std::thread _thread{};
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "picking.h"
+
+#include <raylib.h>
+
+#include <cmath>
+
+namespace
+{
+Vector3 add(const Vector3 &first, const Vector3 &second)
+{
+    return Vector3{first.x + second.x, first.y + second.y, first.z + second.z};
+}
+
+Vector3 subtract(const Vector3 &first, const Vector3 &second)
+{
+    return Vector3{first.x - second.x, first.y - second.y, first.z - second.z};
+}
+
+Vector3 scale(const Vector3 &vector, const float factor)
+{
+    return Vector3{vector.x * factor, vector.y * factor, vector.z * factor};
+}
+
+Vector3 cross(const Vector3 &first, const Vector3 &second)
+{
+    return Vector3{first.y * second.z - first.z * second.y,
+                   first.z * second.x - first.x * second.z,
+                   first.x * second.y - first.y * second.x};
+}
+
+Vector3 normalise(const Vector3 &vector)
+{
+    const float length{
+        std::sqrt(vector.x * vector.x + vector.y * vector.y +
+                  vector.z * vector.z)};
+    return length > 0.F ? scale(vector, 1.F / length) : vector;
+}
+} // namespace
+
+PickRay viewport_pick_ray(const Camera3D &camera,
+                          const Vector2 &viewport_point,
+                          const float aspect_ratio)
+{
+    // normalised device coordinates, with y pointing up
+    const float ndc_x{2.F * viewport_point.x - 1.F};
+    const float ndc_y{1.F - 2.F * viewport_point.y};
+
+    const Vector3 forward{normalise(subtract(camera.target, camera.position))};
+    const Vector3 right{normalise(cross(forward, camera.up))};
+    const Vector3 up{cross(right, forward)};
+
+    if (camera.projection == CAMERA_ORTHOGRAPHIC)
+    {
+        // fovy is the view volume height, rays are parallel to the view axis
+        const float half_height{0.5F * camera.fovy};
+        const Vector3 offset{
+            add(scale(right, ndc_x * half_height * aspect_ratio),
+                scale(up, ndc_y * half_height))};
+        return PickRay{add(camera.position, offset), forward};
+    }
+
+    constexpr float kDegreesToRadians{0.017453292F};
+    const float tan_half_fovy{
+        std::tan(0.5F * camera.fovy * kDegreesToRadians)};
+    const Vector3 direction{
+        add(forward,
+            add(scale(right, ndc_x * tan_half_fovy * aspect_ratio),
+                scale(up, ndc_y * tan_half_fovy)))};
+    return PickRay{camera.position, normalise(direction)};
+}
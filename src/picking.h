@@ -0,0 +1,19 @@
+#ifndef SRC_PICKING_H
+#define SRC_PICKING_H
+
+#include <raylib.h>
+
+struct PickRay
+{
+    Vector3 _origin;
+    Vector3 _direction; // unit length
+};
+
+// Ray from the camera through a point on the viewport. viewport_point is
+// normalised, with (0, 0) at the top left and (1, 1) at the bottom right, so
+// the same function serves the window and the debug render texture.
+PickRay viewport_pick_ray(const Camera3D &camera,
+                          const Vector2 &viewport_point,
+                          float aspect_ratio);
+
+#endif
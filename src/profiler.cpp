@@ -0,0 +1,68 @@
+#include "profiler.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ratio>
+#include <vector>
+
+void FrameProfiler::begin_frame()
+{
+    _frame = (_frame + 1) % ProfileSection::kSampleCount;
+    for (ProfileSection &section : _sections)
+    {
+        section._milliseconds[static_cast<std::size_t>(_frame)] = 0.F;
+    }
+}
+
+void FrameProfiler::record(const char *name, const float milliseconds)
+{
+    // a handful of sections, so a linear search beats hashing
+    ProfileSection *found{nullptr};
+    for (ProfileSection &section : _sections)
+    {
+        if (section._name == name || std::strcmp(section._name, name) == 0)
+        {
+            found = &section;
+            break;
+        }
+    }
+    if (found == nullptr)
+    {
+        found = &_sections.emplace_back();
+        found->_name = name;
+    }
+
+    // sections entered more than once in a frame accumulate
+    found->_milliseconds[static_cast<std::size_t>(_frame)] += milliseconds;
+}
+
+const std::vector<ProfileSection> &FrameProfiler::sections() const
+{
+    return _sections;
+}
+
+int FrameProfiler::offset() const
+{
+    // the oldest sample is the one the next frame overwrites
+    return (_frame + 1) % ProfileSection::kSampleCount;
+}
+
+float FrameProfiler::latest(const ProfileSection &section) const
+{
+    return section._milliseconds[static_cast<std::size_t>(_frame)];
+}
+
+ScopedProfile::ScopedProfile(FrameProfiler &profiler, const char *name)
+    : _profiler(profiler), _name(name),
+      _start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedProfile::~ScopedProfile()
+{
+    _profiler.record(_name,
+                     std::chrono::duration<float, std::milli>{
+                         std::chrono::steady_clock::now() - _start}
+                         .count());
+}
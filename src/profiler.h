@@ -0,0 +1,56 @@
+#ifndef SRC_PROFILER_H
+#define SRC_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+struct ProfileSection
+{
+    static constexpr int kSampleCount{120};
+
+    const char *_name{nullptr};
+    std::array<float, kSampleCount> _milliseconds{};
+};
+
+// Per-frame timings for named sections of the main loop, kept as rolling
+// histories for the Dev Panel. Section names must be string literals.
+class FrameProfiler
+{
+public:
+    FrameProfiler() = default;
+
+    // mutator methods
+    void begin_frame();
+    void record(const char *name, float milliseconds);
+
+    // accessor methods
+    [[nodiscard]] const std::vector<ProfileSection> &sections() const;
+    // Index of the oldest sample, for ImGui::PlotLines' values_offset
+    [[nodiscard]] int offset() const;
+    [[nodiscard]] float latest(const ProfileSection &section) const;
+
+private:
+    std::vector<ProfileSection> _sections{};
+    int _frame{0}; // sample slot of the current frame
+};
+
+// Records the time between construction and destruction as one section
+class ScopedProfile
+{
+public:
+    ScopedProfile(FrameProfiler &profiler, const char *name);
+    ~ScopedProfile();
+    ScopedProfile(const ScopedProfile &) = delete;
+    ScopedProfile &operator=(const ScopedProfile &) = delete;
+    ScopedProfile(ScopedProfile &&) = delete;
+    ScopedProfile &operator=(ScopedProfile &&) = delete;
+
+private:
+    FrameProfiler &_profiler;
+    const char *_name;
+    std::chrono::steady_clock::time_point _start;
+};
+
+#endif
@@ -0,0 +1,734 @@
+#include "regression.h"
+
+#include "allocation_stats.h"
+#include "components.h"
+#include "constants.h"
+#include "memory_stats.h"
+#include "physics.h"
+#include "systems.h"
+#include "transform_snapshot.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/flecs.hpp>
+#include <flecs/addons/cpp/mixins/query/impl.hpp>
+#include <flecs/addons/cpp/world.hpp>
+#include <fmt/core.h>
+#include <raylib.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <ratio>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+const float kFrameTime{1.F / static_cast<float>(constants::kTickrate)};
+
+#ifdef NDEBUG
+constexpr bool kReleaseBuild{true};
+#else
+constexpr bool kReleaseBuild{false};
+#endif
+
+constexpr std::array<std::string_view, 4> kScenes{
+    "single_ball", "resting_1k", "falling_10k", "churn"};
+
+constexpr std::string_view kBaselineSource{
+    "Each scene entry is frame_time/<scene>.json from a Release build "
+    "configured with -DCOUNT_HEAP_ALLOCATIONS=ON, written here by the "
+    "record_frame_time_baseline target with a source naming the machine, "
+    "compiler and date it was recorded on. A scene with no entry is skipped."};
+
+double percentile(const std::vector<double> &sorted_values,
+                  const double fraction)
+{
+    // nearest rank
+    const auto rank{static_cast<std::size_t>(
+        std::ceil(fraction * static_cast<double>(sorted_values.size())))};
+    return sorted_values[std::clamp<std::size_t>(
+        rank, 1, sorted_values.size()) - 1];
+}
+
+// Time each tick and count the heap allocations made while ticking. Setup and
+// teardown are not measured.
+template <typename Tick>
+void measure_ticks(const int ticks, Tick &&tick, RegressionResult &result)
+{
+    std::vector<double> tick_milliseconds(static_cast<std::size_t>(ticks));
+    const std::uint64_t allocations_before{allocation_count()};
+    for (double &milliseconds : tick_milliseconds)
+    {
+        const auto start{std::chrono::steady_clock::now()};
+        tick();
+        milliseconds = std::chrono::duration<double, std::milli>{
+            std::chrono::steady_clock::now() - start}
+                           .count();
+    }
+    const std::uint64_t allocations{allocation_count() - allocations_before};
+
+    std::sort(tick_milliseconds.begin(), tick_milliseconds.end());
+    constexpr double kP50{0.50};
+    constexpr double kP95{0.95};
+    constexpr double kP99{0.99};
+    result._ticks = ticks;
+    result._p50_milliseconds = percentile(tick_milliseconds, kP50);
+    result._p95_milliseconds = percentile(tick_milliseconds, kP95);
+    result._p99_milliseconds = percentile(tick_milliseconds, kP99);
+    result._max_milliseconds = tick_milliseconds.back();
+    result._allocations_per_tick =
+        static_cast<double>(allocations) / static_cast<double>(ticks);
+}
+
+void initialise_physics(PhysicsEngine &physics_engine,
+                        const PhysicsCapacity &capacity)
+{
+    physics_engine.initialise(capacity);
+    install_jolt_allocation_hooks();
+}
+
+void spawn_large_floor(const flecs::world &world)
+{
+    constexpr float kFloorHalfExtent{20.F};
+    world.entity()
+        .set<Position>(Position{Vector3{0.F, -1.F, 0.F}})
+        .add<GridComponent>()
+        .set<BoxCollider>(
+            BoxCollider{Vector3{kFloorHalfExtent, 1.F, kFloorHalfExtent}});
+}
+
+// Spheres on a regular grid centred over the origin, with the bottom layer
+// at height
+void spawn_sphere_grid(const flecs::world &world,
+                       const int columns,
+                       const int layers,
+                       const float height)
+{
+    constexpr float kSpacing{2.2F * constants::kBallRadius};
+    const float offset{0.5F * kSpacing * static_cast<float>(columns - 1)};
+    for (int layer{0}; layer < layers; ++layer)
+    {
+        for (int row{0}; row < columns; ++row)
+        {
+            for (int column{0}; column < columns; ++column)
+            {
+                world.entity()
+                    .set<Position>(Position{
+                        Vector3{kSpacing * static_cast<float>(column) - offset,
+                                height + kSpacing * static_cast<float>(layer),
+                                kSpacing * static_cast<float>(row) - offset}})
+                    .set<SphereMesh>({constants::kSphereColours[0],
+                                      constants::kBallRadius})
+                    .add<SphereLod>()
+                    .set<SphereCollider>(SphereCollider{constants::kBallRadius})
+                    .set<Velocity>(Velocity{Vector3{0.F, 0.F, 0.F}})
+                    .add<RigidBodyTransform>();
+            }
+        }
+    }
+}
+
+// The path the windowed build takes: step, snapshot, write back to flecs
+void step_and_apply(PhysicsEngine &physics_engine,
+                    const flecs::world &world,
+                    TransformSnapshot &snapshot,
+                    SnapshotSyncStats &sync_stats)
+{
+    physics_engine.step(kFrameTime);
+    physics_engine.read_transforms(snapshot);
+    apply_transform_snapshot_system(world, snapshot, sync_stats);
+}
+
+// One sphere through update_sphere_system and PhysicsEngine::update
+void run_single_ball(RegressionResult &result)
+{
+    const flecs::world world;
+    spawn_floor_system(world);
+    spawn_sphere_system(world);
+    world.entity<DevPanelState>().set<DevPanelState>({0});
+
+    PhysicsEngine physics_engine{};
+    initialise_physics(physics_engine, PhysicsCapacity{});
+    create_entity_colliders_system(world, physics_engine);
+    physics_engine.start_simulation();
+
+    const flecs::query<const SphereCollider, Position, Velocity, DevPanelState>
+        update_sphere_query{world
+                                .query_builder<const SphereCollider,
+                                               Position,
+                                               Velocity,
+                                               DevPanelState>()
+                                .term_at(4)
+                                .singleton()
+                                .build()};
+
+    constexpr int kTicks{600};
+    measure_ticks(
+        kTicks,
+        [&]() {
+            update_sphere_system(update_sphere_query, kFrameTime, physics_engine);
+        },
+        result);
+    physics_engine.cleanup();
+}
+
+// 1024 spheres settled on the floor, mostly asleep
+void run_resting_1k(RegressionResult &result)
+{
+    const flecs::world world;
+    spawn_large_floor(world);
+    constexpr int kColumns{32};
+    spawn_sphere_grid(world, kColumns, 1, constants::kBallRadius);
+
+    PhysicsCapacity capacity{};
+    capacity._max_bodies = 2'048;
+    capacity._max_body_pairs = 4'096;
+    capacity._max_contact_constraints = 4'096;
+    PhysicsEngine physics_engine{};
+    initialise_physics(physics_engine, capacity);
+    create_entity_colliders_system(world, physics_engine);
+    physics_engine.start_simulation();
+
+    TransformSnapshot snapshot{};
+    SnapshotSyncStats sync_stats{};
+    constexpr int kTicks{300};
+    measure_ticks(
+        kTicks,
+        [&]() {
+            step_and_apply(physics_engine, world, snapshot, sync_stats);
+        },
+        result);
+    physics_engine.cleanup();
+}
+
+// 10,000 spheres dropped as a block, colliding with the floor and each other
+void run_falling_10k(RegressionResult &result)
+{
+    const flecs::world world;
+    spawn_large_floor(world);
+    constexpr int kColumns{25};
+    constexpr int kLayers{16};
+    constexpr float kDropHeight{5.F};
+    spawn_sphere_grid(world, kColumns, kLayers, kDropHeight);
+
+    PhysicsCapacity capacity{};
+    capacity._max_bodies = 16'384;
+    capacity._max_body_pairs = 65'536;
+    capacity._max_contact_constraints = 65'536;
+    capacity._temp_allocator_bytes = 64 * 1'024 * 1'024;
+    PhysicsEngine physics_engine{};
+    initialise_physics(physics_engine, capacity);
+    create_entity_colliders_system(world, physics_engine);
+    physics_engine.start_simulation();
+
+    TransformSnapshot snapshot{};
+    SnapshotSyncStats sync_stats{};
+    constexpr int kTicks{300};
+    measure_ticks(
+        kTicks,
+        [&]() {
+            step_and_apply(physics_engine, world, snapshot, sync_stats);
+        },
+        result);
+    physics_engine.cleanup();
+}
+
+// 50 spheres spawned and 50 despawned every tick, recycling bodies
+void run_churn(RegressionResult &result)
+{
+    const flecs::world world;
+    spawn_floor_system(world);
+
+    constexpr int kSpawnsPerTick{50};
+    constexpr std::size_t kLiveLimit{3'000};
+    PhysicsCapacity capacity{};
+    capacity._max_bodies = 8'192;
+    capacity._max_body_pairs = 8'192;
+    capacity._max_contact_constraints = 8'192;
+    PhysicsEngine physics_engine{};
+    initialise_physics(physics_engine, capacity);
+    create_entity_colliders_system(world, physics_engine);
+    physics_engine.prewarm_ball_pool(constants::kBallRadius, kLiveLimit);
+    physics_engine.start_simulation();
+
+    TransformSnapshot snapshot{};
+    SnapshotSyncStats sync_stats{};
+    std::deque<flecs::entity> live_balls;
+    int spawned{0};
+    constexpr int kTicks{600};
+    measure_ticks(
+        kTicks,
+        [&]() {
+            while (live_balls.size() + static_cast<std::size_t>(kSpawnsPerTick) >
+                   kLiveLimit)
+            {
+                despawn_ball_system(live_balls.front(), physics_engine, true);
+                live_balls.pop_front();
+            }
+            constexpr int kColumns{9};
+            constexpr int kLayers{5};
+            constexpr float kSpawnHeight{5.F};
+            for (int spawn{0}; spawn < kSpawnsPerTick; ++spawn, ++spawned)
+            {
+                const Vector3 position{
+                    static_cast<float>(spawned % kColumns) - 4.F,
+                    kSpawnHeight + static_cast<float>(spawned % kLayers),
+                    static_cast<float>((spawned / kColumns) % kColumns) - 4.F};
+                live_balls.push_back(spawn_ball_system(
+                    world, physics_engine, position, Vector3{0.F, -1.F, 0.F}));
+            }
+            step_and_apply(physics_engine, world, snapshot, sync_stats);
+        },
+        result);
+    physics_engine.cleanup();
+}
+
+// The metrics of a result as JSON members, one per line at indent. Results
+// and baseline scene entries share them, so a result can be pasted into the
+// baseline to accept it.
+std::string format_metrics(const RegressionResult &result,
+                           const std::string_view indent)
+{
+    return fmt::format("{0}\"ticks\": {1},\n"
+                       "{0}\"p50_ms\": {2:.4f},\n"
+                       "{0}\"p95_ms\": {3:.4f},\n"
+                       "{0}\"p99_ms\": {4:.4f},\n"
+                       "{0}\"max_ms\": {5:.4f},\n"
+                       "{0}\"allocations_per_tick\": {6:.2f},\n"
+                       "{0}\"peak_memory_mb\": {7:.1f}\n",
+                       indent,
+                       result._ticks,
+                       result._p50_milliseconds,
+                       result._p95_milliseconds,
+                       result._p99_milliseconds,
+                       result._max_milliseconds,
+                       result._allocations_per_tick,
+                       to_megabytes(result._peak_memory_bytes));
+}
+
+bool write_result(const RegressionResult &result, const std::string &path)
+{
+    const std::filesystem::path output_path{path};
+    if (output_path.has_parent_path())
+    {
+        std::filesystem::create_directories(output_path.parent_path());
+    }
+    std::ofstream output{output_path};
+    if (!output)
+    {
+        spdlog::error("Could not write regression results to {}", path);
+        return false;
+    }
+    output << fmt::format("{{\n  \"scene\": \"{}\",\n{}}}\n",
+                          result._scene,
+                          format_metrics(result, "  "));
+    return true;
+}
+
+// Just enough JSON for the baseline file: find the object or number stored
+// under a key, searching from the start of text.
+bool find_json_value(const std::string_view text,
+                     const std::string_view key,
+                     std::size_t &value_start)
+{
+    const std::string quoted_key{fmt::format("\"{}\"", key)};
+    const std::size_t key_position{text.find(quoted_key)};
+    if (key_position == std::string_view::npos)
+    {
+        return false;
+    }
+    const std::size_t colon{text.find(':', key_position + quoted_key.size())};
+    if (colon == std::string_view::npos)
+    {
+        return false;
+    }
+    value_start = text.find_first_not_of(" \t\r\n", colon + 1);
+    return value_start != std::string_view::npos;
+}
+
+bool find_json_object(const std::string_view text,
+                      const std::string_view key,
+                      std::string_view &object)
+{
+    std::size_t start{0};
+    if (!find_json_value(text, key, start) || text[start] != '{')
+    {
+        return false;
+    }
+    int depth{0};
+    for (std::size_t position{start}; position < text.size(); ++position)
+    {
+        if (text[position] == '{')
+        {
+            ++depth;
+        }
+        else if (text[position] == '}' && --depth == 0)
+        {
+            object = text.substr(start, position - start + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool find_json_number(const std::string_view text,
+                      const std::string_view key,
+                      double &value)
+{
+    std::size_t start{0};
+    if (!find_json_value(text, key, start))
+    {
+        return false;
+    }
+    const std::size_t end{text.find_first_of(",}\r\n", start)};
+    const std::string number{text.substr(start, end - start)};
+    char *number_end{nullptr};
+    value = std::strtod(number.c_str(), &number_end);
+    return number_end != number.c_str();
+}
+
+struct Tolerance
+{
+    double _relative{0.0};
+    double _absolute{0.0};
+};
+
+bool read_tolerance(const std::string_view baseline,
+                    const std::string_view metric,
+                    Tolerance &tolerance)
+{
+    std::string_view tolerances;
+    std::string_view metric_tolerance;
+    return find_json_object(baseline, "tolerances", tolerances) &&
+           find_json_object(tolerances, metric, metric_tolerance) &&
+           find_json_number(
+               metric_tolerance, "relative", tolerance._relative) &&
+           find_json_number(metric_tolerance, "absolute", tolerance._absolute);
+}
+
+// Only getting worse fails, getting much better just asks for a new baseline
+bool check_metric(const std::string_view scene_baseline,
+                  const std::string_view key,
+                  const double measured,
+                  const Tolerance &tolerance)
+{
+    double expected{0.0};
+    if (!find_json_number(scene_baseline, key, expected))
+    {
+        spdlog::error("Baseline has no {}", key);
+        return false;
+    }
+    const double limit{expected * (1.0 + tolerance._relative) +
+                       tolerance._absolute};
+    if (measured > limit)
+    {
+        spdlog::error("{} regressed: {:.3f}, baseline {:.3f}, limit {:.3f}",
+                      key,
+                      measured,
+                      expected,
+                      limit);
+        return false;
+    }
+    if (measured < expected * (1.0 - tolerance._relative) - tolerance._absolute)
+    {
+        spdlog::warn("{} improved: {:.3f}, baseline {:.3f}. Consider updating "
+                     "the baseline.",
+                     key,
+                     measured,
+                     expected);
+        return true;
+    }
+    spdlog::info("{}: {:.3f}, baseline {:.3f}", key, measured, expected);
+    return true;
+}
+
+enum class BaselineComparison
+{
+    kPassed,
+    kRegressed,
+    kMissing,
+};
+
+bool read_baseline(const std::string &baseline_path, std::string &baseline)
+{
+    const std::ifstream input{baseline_path};
+    if (!input)
+    {
+        spdlog::error("Could not read regression baseline {}", baseline_path);
+        return false;
+    }
+    std::stringstream contents;
+    contents << input.rdbuf();
+    baseline = contents.str();
+    return true;
+}
+
+BaselineComparison compare_with_baseline(const RegressionResult &result,
+                                         const std::string &baseline_path)
+{
+    std::string baseline;
+    if (!read_baseline(baseline_path, baseline))
+    {
+        return BaselineComparison::kRegressed;
+    }
+
+    std::string_view scenes;
+    if (!find_json_object(baseline, "scenes", scenes))
+    {
+        spdlog::error("Baseline has no scenes");
+        return BaselineComparison::kRegressed;
+    }
+    // Numbers are only meaningful from a Release run on the reference
+    // machine, so a scene nobody has recorded yet is not guessed at
+    std::string_view scene_baseline;
+    if (!find_json_object(scenes, result._scene, scene_baseline))
+    {
+        spdlog::warn("Baseline has no entry for scene {}, skipping the "
+                     "comparison. Record one from a Release run on the "
+                     "reference machine",
+                     result._scene);
+        return BaselineComparison::kMissing;
+    }
+
+    Tolerance time_tolerance{};
+    Tolerance allocation_tolerance{};
+    Tolerance memory_tolerance{};
+    if (!read_tolerance(baseline, "time_ms", time_tolerance) ||
+        !read_tolerance(baseline, "allocations_per_tick", allocation_tolerance) ||
+        !read_tolerance(baseline, "peak_memory_mb", memory_tolerance))
+    {
+        spdlog::error("Baseline tolerances are incomplete");
+        return BaselineComparison::kRegressed;
+    }
+
+    // check everything, so one run reports every regression
+    bool passed{true};
+    passed &= check_metric(
+        scene_baseline, "p50_ms", result._p50_milliseconds, time_tolerance);
+    passed &= check_metric(
+        scene_baseline, "p95_ms", result._p95_milliseconds, time_tolerance);
+    passed &= check_metric(
+        scene_baseline, "p99_ms", result._p99_milliseconds, time_tolerance);
+    // without COUNT_HEAP_ALLOCATIONS operator new is not counted, so the
+    // count would pass against any baseline recorded with it
+    if (counts_operator_new())
+    {
+        passed &= check_metric(scene_baseline,
+                               "allocations_per_tick",
+                               result._allocations_per_tick,
+                               allocation_tolerance);
+    }
+    else
+    {
+        spdlog::info("allocations_per_tick not checked: built without "
+                     "COUNT_HEAP_ALLOCATIONS");
+    }
+    passed &= check_metric(scene_baseline,
+                           "peak_memory_mb",
+                           to_megabytes(result._peak_memory_bytes),
+                           memory_tolerance);
+    return passed ? BaselineComparison::kPassed
+                  : BaselineComparison::kRegressed;
+}
+
+std::string compiler_name()
+{
+#if defined(__clang__)
+    return fmt::format("Clang {}", __clang_version__);
+#elif defined(__GNUC__)
+    return fmt::format("GCC {}", __VERSION__);
+#elif defined(_MSC_VER)
+    return fmt::format("MSVC {}", _MSC_VER);
+#else
+    return "unknown compiler";
+#endif
+}
+
+// Today in UTC, as YYYY-MM-DD
+std::string today()
+{
+    const std::time_t now{std::time(nullptr)};
+    std::array<char, sizeof("YYYY-MM-DD")> date{};
+    // NOLINTNEXTLINE [concurrency-mt-unsafe]
+    std::strftime(date.data(), date.size(), "%Y-%m-%d", std::gmtime(&now));
+    return std::string{date.data()};
+}
+
+// Rewrite the baseline with result as its scene's entry, keeping the
+// tolerances and the other scenes' entries as they are
+bool record_baseline(const RegressionResult &result,
+                     const std::string &baseline_path,
+                     const std::string &machine)
+{
+    std::string baseline;
+    if (!read_baseline(baseline_path, baseline))
+    {
+        return false;
+    }
+    std::string_view tolerances;
+    if (!find_json_object(baseline, "tolerances", tolerances))
+    {
+        spdlog::error("Baseline has no tolerances");
+        return false;
+    }
+    std::string_view scenes;
+    if (!find_json_object(baseline, "scenes", scenes))
+    {
+        spdlog::error("Baseline has no scenes");
+        return false;
+    }
+
+    std::string scene_entries;
+    for (const std::string_view scene : kScenes)
+    {
+        std::string entry;
+        std::string_view recorded;
+        if (scene == result._scene)
+        {
+            entry = fmt::format("{{\n"
+                                "      \"source\": \"{}, {}, {}\",\n"
+                                "{}"
+                                "    }}",
+                                machine,
+                                compiler_name(),
+                                today(),
+                                format_metrics(result, "      "));
+        }
+        else if (find_json_object(scenes, scene, recorded))
+        {
+            entry = std::string{recorded};
+        }
+        else
+        {
+            continue;
+        }
+        scene_entries += fmt::format("{}    \"{}\": {}",
+                                     scene_entries.empty() ? "" : ",\n",
+                                     scene,
+                                     entry);
+    }
+
+    std::ofstream output{baseline_path};
+    if (!output)
+    {
+        spdlog::error("Could not write regression baseline {}", baseline_path);
+        return false;
+    }
+    output << fmt::format("{{\n"
+                          "  \"source\": \"{}\",\n"
+                          "  \"tolerances\": {},\n"
+                          "  \"scenes\": {{\n"
+                          "{}\n"
+                          "  }}\n"
+                          "}}\n",
+                          kBaselineSource,
+                          tolerances,
+                          scene_entries);
+    spdlog::info("Recorded {} in {}", result._scene, baseline_path);
+    return true;
+}
+
+// Run one canonical scene, or return false when scene is not one of them
+bool run_scene(const std::string &scene, RegressionResult &result)
+{
+    // must happen before the first world is created
+    install_flecs_allocation_hooks();
+
+    result._scene = scene;
+
+    // contact and activation logging would dominate the tick times
+    spdlog::set_level(spdlog::level::warn);
+    if (scene == "single_ball")
+    {
+        run_single_ball(result);
+    }
+    else if (scene == "resting_1k")
+    {
+        run_resting_1k(result);
+    }
+    else if (scene == "falling_10k")
+    {
+        run_falling_10k(result);
+    }
+    else if (scene == "churn")
+    {
+        run_churn(result);
+    }
+    else
+    {
+        spdlog::set_level(spdlog::level::info);
+        spdlog::error("Unknown regression scene {}", scene);
+        return false;
+    }
+    spdlog::set_level(spdlog::level::info);
+    result._peak_memory_bytes = peak_resident_bytes();
+
+    spdlog::info("{}: {} ticks, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, "
+                 "max {:.3f} ms, {:.2f} allocations per tick, peak {:.1f} MB",
+                 result._scene,
+                 result._ticks,
+                 result._p50_milliseconds,
+                 result._p95_milliseconds,
+                 result._p99_milliseconds,
+                 result._max_milliseconds,
+                 result._allocations_per_tick,
+                 to_megabytes(result._peak_memory_bytes));
+    return true;
+}
+} // namespace
+
+int run_regression(const std::string &scene,
+                   const std::string &baseline_path,
+                   const std::string &output_path)
+{
+    RegressionResult result{};
+    if (!run_scene(scene, result))
+    {
+        return EXIT_FAILURE;
+    }
+
+    const bool written{write_result(result, output_path)};
+    const BaselineComparison comparison{
+        compare_with_baseline(result, baseline_path)};
+    if (!written || comparison == BaselineComparison::kRegressed)
+    {
+        return EXIT_FAILURE;
+    }
+    return comparison == BaselineComparison::kMissing ? kRegressionNoBaseline
+                                                      : EXIT_SUCCESS;
+}
+
+int record_regression_baseline(const std::string &scene,
+                               const std::string &baseline_path,
+                               const std::string &output_path,
+                               const std::string &machine)
+{
+    // the budgets and the allocation counts only mean anything from the
+    // build the tests are registered for
+    if (!kReleaseBuild || !counts_operator_new())
+    {
+        spdlog::error("Record the frame-time baseline from a Release build "
+                      "configured with -DCOUNT_HEAP_ALLOCATIONS=ON");
+        return EXIT_FAILURE;
+    }
+
+    RegressionResult result{};
+    if (!run_scene(scene, result) || !write_result(result, output_path) ||
+        !record_baseline(result, baseline_path, machine))
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+#ifndef SRC_REGRESSION_H
+#define SRC_REGRESSION_H
+
+#include <cstddef>
+#include <string>
+
+struct RegressionResult
+{
+    std::string _scene{};
+    int _ticks{0};
+    double _p50_milliseconds{0.0};
+    double _p95_milliseconds{0.0};
+    double _p99_milliseconds{0.0};
+    double _max_milliseconds{0.0};
+    double _allocations_per_tick{0.0};
+    std::size_t _peak_memory_bytes{0};
+};
+
+// Exit code for a scene with no baseline entry yet. CMakeLists.txt registers
+// it as the tests' SKIP_RETURN_CODE, so CTest reports them as skipped.
+inline constexpr int kRegressionNoBaseline{77};
+
+// Run one canonical scene (single_ball, resting_1k, falling_10k or churn)
+// headless, write its result as JSON to output_path and compare it against
+// the matching entry in baseline_path. Returns non-zero when the scene is
+// unknown or any metric is outside its tolerance, so CTest fails, and
+// kRegressionNoBaseline when baseline_path has no entry for the scene.
+// allocations_per_tick is only checked when operator new is counted.
+int run_regression(const std::string &scene,
+                   const std::string &baseline_path,
+                   const std::string &output_path);
+
+// Run one canonical scene, write its result to output_path and make it the
+// scene's entry in baseline_path, with a source naming machine, the compiler
+// and today's date. Refuses to record from anything but a Release build
+// with COUNT_HEAP_ALLOCATIONS.
+int record_regression_baseline(const std::string &scene,
+                               const std::string &baseline_path,
+                               const std::string &output_path,
+                               const std::string &machine);
+
+#endif
@@ -0,0 +1,46 @@
+#include "rigid_body_transform.h"
+
+#include "components.h"
+
+#include <raylib.h>
+#include <raymath.h>
+
+Vector3 to_vector3(const Vector4 &lanes)
+{
+    return Vector3{lanes.x, lanes.y, lanes.z};
+}
+
+Vector4 to_lanes(const Vector3 &vector)
+{
+    return Vector4{vector.x, vector.y, vector.z, 0.F};
+}
+
+RigidBodyTransform make_rigid_body_transform(const Position &position,
+                                             const Velocity &velocity)
+{
+    RigidBodyTransform transform{};
+    transform._position = to_lanes(position._centre);
+    transform._linear_velocity = to_lanes(velocity._value);
+    return transform;
+}
+
+Position position_of(const RigidBodyTransform &transform)
+{
+    return Position{to_vector3(transform._position)};
+}
+
+Velocity velocity_of(const RigidBodyTransform &transform)
+{
+    return Velocity{to_vector3(transform._linear_velocity)};
+}
+
+Matrix model_matrix(const Vector3 &position,
+                    const Quaternion &rotation,
+                    const float scale)
+{
+    // raylib matrices compose left to right
+    return MatrixMultiply(
+        MatrixMultiply(MatrixScale(scale, scale, scale),
+                       QuaternionToMatrix(rotation)),
+        MatrixTranslate(position.x, position.y, position.z));
+}
@@ -0,0 +1,27 @@
+#ifndef SRC_RIGID_BODY_TRANSFORM_H
+#define SRC_RIGID_BODY_TRANSFORM_H
+
+#include "components.h"
+
+#include <raylib.h>
+
+// Adapters between the 16-byte lane layout of RigidBodyTransform and the
+// raylib types the draw calls and older components use
+
+[[nodiscard]] Vector3 to_vector3(const Vector4 &lanes);
+[[nodiscard]] Vector4 to_lanes(const Vector3 &vector);
+
+// Starts unrotated and not spinning
+[[nodiscard]] RigidBodyTransform make_rigid_body_transform(
+    const Position &position,
+    const Velocity &velocity);
+
+[[nodiscard]] Position position_of(const RigidBodyTransform &transform);
+[[nodiscard]] Velocity velocity_of(const RigidBodyTransform &transform);
+
+// Uniform scale, then rotation, then translation, ready for DrawMesh
+[[nodiscard]] Matrix model_matrix(const Vector3 &position,
+                                  const Quaternion &rotation,
+                                  float scale);
+
+#endif
@@ -0,0 +1,134 @@
+#include "shape_cache.h"
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+#include <Jolt/Math/Vec3.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <raylib.h>
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace
+{
+// Dimensions closer than a tenth of a millimetre map to the same shape
+constexpr float kShapeQuantum{1.0e-4F};
+
+std::int32_t quantise(const float value)
+{
+    return static_cast<std::int32_t>(std::lround(value / kShapeQuantum));
+}
+
+float dequantise(const std::int32_t value)
+{
+    return static_cast<float>(value) * kShapeQuantum;
+}
+} // namespace
+
+std::size_t ShapeKeyHash::operator()(const ShapeKey &key) const
+{
+    // boost::hash_combine style mixing of the type and each dimension
+    constexpr std::size_t kGoldenRatio{0x9e3779b9};
+    std::size_t seed{std::hash<std::uint8_t>{}(
+        static_cast<std::uint8_t>(key._type))};
+    for (const std::int32_t dimension : key._dimensions)
+    {
+        seed ^= std::hash<std::int32_t>{}(dimension) + kGoldenRatio +
+                (seed << 6U) + (seed >> 2U);
+    }
+    return seed;
+}
+
+JPH::ShapeRefC ShapeCache::get_sphere(const float radius)
+{
+    const ShapeKey key{ShapeType::kSphere, {quantise(radius), 0, 0}};
+    JPH::ShapeRefC shape{find(key)};
+    if (shape == nullptr)
+    {
+        shape = new JPH::SphereShape(dequantise(key._dimensions[0]));
+        insert(key, shape);
+    }
+    return shape;
+}
+
+JPH::ShapeRefC ShapeCache::get_box(const Vector3 &half_extent)
+{
+    const ShapeKey key{ShapeType::kBox,
+                       {quantise(half_extent.x),
+                        quantise(half_extent.y),
+                        quantise(half_extent.z)}};
+    JPH::ShapeRefC shape{find(key)};
+    if (shape != nullptr)
+    {
+        return shape;
+    }
+
+    // Create the settings for the collision volume (the shape).
+    const JPH::BoxShapeSettings box_shape_settings{
+        JPH::Vec3{dequantise(key._dimensions[0]),
+                  dequantise(key._dimensions[1]),
+                  dequantise(key._dimensions[2])}};
+    const JPH::ShapeSettings::ShapeResult box_shape_result{
+        box_shape_settings.Create()};
+    if (box_shape_result.HasError())
+    {
+        spdlog::error("Error creating box shape: {}",
+                      box_shape_result.GetError());
+        return nullptr;
+    }
+    shape = box_shape_result.Get();
+    insert(key, shape);
+    return shape;
+}
+
+void ShapeCache::clear()
+{
+    _shapes.clear();
+}
+
+const ShapeCacheStats &ShapeCache::stats() const
+{
+    return _stats;
+}
+
+std::size_t ShapeCache::size() const
+{
+    return _shapes.size();
+}
+
+std::size_t ShapeCache::shape_bytes() const
+{
+    std::size_t bytes{0};
+    for (const auto &[key, shape] : _shapes)
+    {
+        bytes += shape->GetStats().mSizeBytes;
+    }
+    return bytes;
+}
+
+JPH::ShapeRefC ShapeCache::find(const ShapeKey &key)
+{
+    const auto cached_shape{_shapes.find(key)};
+    if (cached_shape == _shapes.end())
+    {
+        ++_stats._misses;
+        return nullptr;
+    }
+
+    // every hit is one shape allocation that did not happen
+    ++_stats._hits;
+    _stats._bytes_saved += cached_shape->second->GetStats().mSizeBytes;
+    return cached_shape->second;
+}
+
+void ShapeCache::insert(const ShapeKey &key, const JPH::ShapeRefC &shape)
+{
+    _shapes.emplace(key, shape);
+}
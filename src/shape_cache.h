@@ -0,0 +1,68 @@
+#ifndef SRC_SHAPE_CACHE_H
+#define SRC_SHAPE_CACHE_H
+
+#include "shape_type.h"
+
+// The Jolt headers don't include Jolt.h. Always include Jolt.h before including
+// any other Jolt header.
+#include <Jolt/Jolt.h> // NOLINT [misc-include-cleaner]
+
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+#include <raylib.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Colliders are keyed on their dimensions rounded to kShapeQuantum, so near
+// identical colliders share a shape too
+struct ShapeKey
+{
+    ShapeType _type;
+    std::array<std::int32_t, 3> _dimensions;
+
+    bool operator==(const ShapeKey &other) const
+    {
+        return _type == other._type && _dimensions == other._dimensions;
+    }
+};
+
+struct ShapeKeyHash
+{
+    std::size_t operator()(const ShapeKey &key) const;
+};
+
+struct ShapeCacheStats
+{
+    std::uint64_t _hits{0};
+    std::uint64_t _misses{0};
+    std::uint64_t _bytes_saved{0};
+};
+
+// Hands out shared, reference counted shapes for identical colliders, instead
+// of allocating a new shape for every body
+class ShapeCache
+{
+public:
+    ShapeCache() = default;
+
+    // mutator methods
+    JPH::ShapeRefC get_sphere(float radius);
+    JPH::ShapeRefC get_box(const Vector3 &half_extent);
+    void clear();
+
+    // accessor methods
+    [[nodiscard]] const ShapeCacheStats &stats() const;
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] std::size_t shape_bytes() const;
+
+private:
+    JPH::ShapeRefC find(const ShapeKey &key);
+    void insert(const ShapeKey &key, const JPH::ShapeRefC &shape);
+
+    std::unordered_map<ShapeKey, JPH::ShapeRefC, ShapeKeyHash> _shapes{};
+    ShapeCacheStats _stats{};
+};
+
+#endif
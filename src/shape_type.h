@@ -0,0 +1,14 @@
+#ifndef SRC_SHAPE_TYPE_H
+#define SRC_SHAPE_TYPE_H
+
+#include <cstdint>
+
+// Kind of collider behind a body. Kept apart from shape_cache.h so components
+// can name it without pulling in Jolt.
+enum class ShapeType : std::uint8_t
+{
+    kSphere,
+    kBox,
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "spatial_query.h"
+
+#include "components.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+void SpatialQueryBatch::clear()
+{
+    _requests.clear();
+}
+
+void SpatialQueryBatch::add(const SpatialQueryRequest &request)
+{
+    _requests.push_back(request);
+}
+
+const std::vector<SpatialQueryRequest> &SpatialQueryBatch::requests() const
+{
+    return _requests;
+}
+
+std::size_t SpatialQueryBatch::size() const
+{
+    return _requests.size();
+}
+
+bool SpatialQueryBatch::empty() const
+{
+    return _requests.empty();
+}
+
+void add_spatial_query_hit(SpatialQueryHits &hits, const std::uint64_t entity)
+{
+    const auto recorded{hits._entities.begin() + hits._count};
+    if (std::find(hits._entities.begin(), recorded, entity) != recorded)
+    {
+        return;
+    }
+    if (hits._count == hits._entities.size())
+    {
+        hits._truncated = true;
+        return;
+    }
+    hits._entities[hits._count++] = entity;
+}
@@ -0,0 +1,51 @@
+#ifndef SRC_SPATIAL_QUERY_H
+#define SRC_SPATIAL_QUERY_H
+
+#include "components.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SpatialQueryRequest
+{
+    std::uint64_t _entity{0};
+    std::uint32_t _ignore_body_id{0xffffffff}; // the asking entity's own body
+    Vector3 _origin{0.F, 0.F, 0.F};
+    SpatialQuery _query{};
+};
+
+// The answer to one request, for the entity that asked
+struct SpatialQueryResult
+{
+    std::uint64_t _entity{0};
+    SpatialQueryHits _hits{};
+};
+
+// Spatial queries collected from flecs systems over a frame, then answered
+// together by PhysicsEngine::run_spatial_queries. Keeps its capacity between
+// frames.
+class SpatialQueryBatch
+{
+public:
+    SpatialQueryBatch() = default;
+
+    // mutator methods
+    void clear();
+    void add(const SpatialQueryRequest &request);
+
+    // accessor methods
+    [[nodiscard]] const std::vector<SpatialQueryRequest> &requests() const;
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] bool empty() const;
+
+private:
+    std::vector<SpatialQueryRequest> _requests{};
+};
+
+// Record a hit, ignoring repeats of an entity already recorded
+void add_spatial_query_hit(SpatialQueryHits &hits, std::uint64_t entity);
+
+#endif
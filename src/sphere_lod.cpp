@@ -0,0 +1,130 @@
+#include "sphere_lod.h"
+
+#include "components.h"
+#include "viewport.h"
+
+#include <raylib.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+float projected_radius_pixels(const Camera3D &camera,
+                              const float screen_scale,
+                              const Position &position,
+                              const SphereMesh &sphere_mesh)
+{
+    const float radius_pixels{sphere_mesh._radius * screen_scale};
+    if (camera.projection == CAMERA_ORTHOGRAPHIC)
+    {
+        return radius_pixels;
+    }
+    const Vector3 &centre{position._centre};
+    const float delta_x{centre.x - camera.position.x};
+    const float delta_y{centre.y - camera.position.y};
+    const float delta_z{centre.z - camera.position.z};
+    const float distance{std::sqrt(delta_x * delta_x + delta_y * delta_y +
+                                   delta_z * delta_z)};
+
+    // inside the sphere it fills the screen, so keep full detail
+    return distance > sphere_mesh._radius
+               ? radius_pixels / distance
+               : kSphereLodLevels[0]._min_radius_pixels *
+                     (1.F + kSphereLodHysteresis);
+}
+} // namespace
+
+bool SphereLodView::update(const Camera3D &camera, const float viewport_height)
+{
+    if (_valid && _viewport_height == viewport_height &&
+        cameras_equal(_camera, camera))
+    {
+        return false;
+    }
+    _valid = true;
+    _camera = camera;
+    _viewport_height = viewport_height;
+    return true;
+}
+
+float sphere_lod_screen_scale(const Camera3D &camera,
+                              const float viewport_height)
+{
+    if (camera.projection == CAMERA_ORTHOGRAPHIC)
+    {
+        // fovy is the height of the view volume in world units, and distance
+        // does not matter
+        return viewport_height / camera.fovy;
+    }
+    constexpr float kDegreesToRadians{0.017453292F};
+    return viewport_height /
+           (2.F * std::tan(0.5F * camera.fovy * kDegreesToRadians));
+}
+
+std::uint8_t select_sphere_lod(const std::uint8_t current_level,
+                               const float projected_radius_pixels)
+{
+    std::uint8_t level{current_level > kSphereImpostorLevel
+                           ? kSphereImpostorLevel
+                           : current_level};
+
+    // coarsen while too small for the current level
+    while (level < kSphereImpostorLevel &&
+           projected_radius_pixels <
+               kSphereLodLevels[level]._min_radius_pixels *
+                   (1.F - kSphereLodHysteresis))
+    {
+        ++level;
+    }
+
+    // refine while comfortably large enough for the next finer level
+    while (level > 0 &&
+           projected_radius_pixels >=
+               kSphereLodLevels[level - 1U]._min_radius_pixels *
+                   (1.F + kSphereLodHysteresis))
+    {
+        --level;
+    }
+    return level;
+}
+
+std::size_t first_sphere_lod_change(const Camera3D &camera,
+                                    const float screen_scale,
+                                    const Position *positions,
+                                    const SphereMesh *sphere_meshes,
+                                    const SphereLod *sphere_lods,
+                                    const std::size_t count)
+{
+    for (std::size_t index{0}; index < count; ++index)
+    {
+        const std::uint8_t level{sphere_lods[index]._level};
+        if (select_sphere_lod(level,
+                              projected_radius_pixels(camera,
+                                                      screen_scale,
+                                                      positions[index],
+                                                      sphere_meshes[index])) !=
+            level)
+        {
+            return index;
+        }
+    }
+    return count;
+}
+
+void select_sphere_lods(const Camera3D &camera,
+                        const float screen_scale,
+                        const Position *positions,
+                        const SphereMesh *sphere_meshes,
+                        SphereLod *sphere_lods,
+                        const std::size_t count)
+{
+    for (std::size_t index{0}; index < count; ++index)
+    {
+        sphere_lods[index]._level = select_sphere_lod(
+            sphere_lods[index]._level,
+            projected_radius_pixels(
+                camera, screen_scale, positions[index], sphere_meshes[index]));
+    }
+}
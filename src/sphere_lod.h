@@ -0,0 +1,76 @@
+#ifndef SRC_SPHERE_LOD_H
+#define SRC_SPHERE_LOD_H
+
+#include "components.h"
+
+#include <raylib.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Sphere detail levels, finest first. A sphere uses the finest level whose
+// projected radius threshold (in pixels) it meets, and a flat billboard
+// impostor once it is smaller than the last threshold.
+struct SphereLodLevel
+{
+    int _rings;
+    int _slices;
+    float _min_radius_pixels;
+};
+
+inline constexpr std::array<SphereLodLevel, 3> kSphereLodLevels{
+    SphereLodLevel{16, 16, 48.F},
+    SphereLodLevel{10, 12, 16.F},
+    SphereLodLevel{6, 8, 4.F}};
+inline constexpr std::uint8_t kSphereImpostorLevel{
+    static_cast<std::uint8_t>(kSphereLodLevels.size())};
+
+// A sphere has to pass a threshold by this fraction before it changes level,
+// so spheres sitting on a boundary do not flicker between levels
+inline constexpr float kSphereLodHysteresis{0.15F};
+
+// The camera and viewport the current levels were picked for. While both stay
+// the same, only spheres that moved or resized need picking again.
+class SphereLodView
+{
+public:
+    SphereLodView() = default;
+
+    // mutator methods
+
+    // Returns true and records the new view when it differs from the last one
+    bool update(const Camera3D &camera, float viewport_height);
+
+private:
+    bool _valid{false};
+    Camera3D _camera{};
+    float _viewport_height{0.F};
+};
+
+// Pixels covered by one world unit at unit distance from the camera. Combined
+// with distance in select_sphere_lods to project each sphere's radius.
+float sphere_lod_screen_scale(const Camera3D &camera, float viewport_height);
+
+std::uint8_t select_sphere_lod(std::uint8_t current_level,
+                               float projected_radius_pixels);
+
+// Index of the first of a table's worth of spheres whose level
+// select_sphere_lods would change, or count if none would. Lets a pass leave
+// SphereLod untouched, and so unchanged for flecs, when no level moves.
+std::size_t first_sphere_lod_change(const Camera3D &camera,
+                                    float screen_scale,
+                                    const Position *positions,
+                                    const SphereMesh *sphere_meshes,
+                                    const SphereLod *sphere_lods,
+                                    std::size_t count);
+
+// Batch pass over a table's worth of spheres, updating each SphereLod in place
+void select_sphere_lods(const Camera3D &camera,
+                        float screen_scale,
+                        const Position *positions,
+                        const SphereMesh *sphere_meshes,
+                        SphereLod *sphere_lods,
+                        std::size_t count);
+
+#endif
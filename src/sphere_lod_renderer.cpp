@@ -0,0 +1,208 @@
+#include "sphere_lod_renderer.h"
+
+#include "components.h"
+#include "memory_stats.h"
+#include "rigid_body_transform.h"
+#include "sphere_lod.h"
+
+#include <raylib.h>
+#include <spdlog/spdlog.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+// Vertices DrawSphere emits for its fixed 16 rings and 16 slices
+constexpr std::uint64_t kDrawSphereVertices{(16 + 2) * 16 * 6};
+
+// Billboards are drawn as a single quad
+constexpr std::uint64_t kImpostorVertices{4};
+
+constexpr int kImpostorTextureSize{64};
+
+// raylib's default shader with the model matrix taken per instance, as
+// DrawMeshInstanced expects
+constexpr const char *kInstancingVertexShader{R"(#version 330
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in mat4 instanceTransform;
+uniform mat4 mvp;
+out vec2 fragTexCoord;
+void main()
+{
+    fragTexCoord = vertexTexCoord;
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+})"};
+constexpr const char *kInstancingFragmentShader{R"(#version 330
+in vec2 fragTexCoord;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+out vec4 finalColor;
+void main()
+{
+    finalColor = texture(texture0, fragTexCoord) * colDiffuse;
+})"};
+
+bool colours_equal(const Color &first, const Color &second)
+{
+    return first.r == second.r && first.g == second.g && first.b == second.b &&
+           first.a == second.a;
+}
+} // namespace
+
+void SphereLodRenderer::load()
+{
+    std::size_t level{0};
+    for (const SphereLodLevel &lod_level : kSphereLodLevels)
+    {
+        _meshes[level] = GenMeshSphere(1.F, lod_level._rings, lod_level._slices);
+        ++level;
+    }
+    _material = LoadMaterialDefault();
+    const Shader shader{LoadShaderFromMemory(kInstancingVertexShader,
+                                             kInstancingFragmentShader)};
+    const int instance_transform{
+        GetShaderLocationAttrib(shader, "instanceTransform")};
+    _instanced = instance_transform >= 0;
+    if (_instanced)
+    {
+        // UnloadMaterial unloads the shader with it
+        shader.locs[SHADER_LOC_MATRIX_MODEL] = instance_transform;
+        _material.shader = shader;
+    }
+    else
+    {
+        spdlog::warn("Sphere instancing shader did not build, drawing each "
+                     "sphere on its own");
+        UnloadShader(shader);
+    }
+
+    // white disc, tinted with the sphere colour when drawn
+    Image impostor_image{GenImageColor(kImpostorTextureSize,
+                                       kImpostorTextureSize,
+                                       BLANK)};
+    ImageDrawCircle(&impostor_image,
+                    kImpostorTextureSize / 2,
+                    kImpostorTextureSize / 2,
+                    kImpostorTextureSize / 2 - 1,
+                    WHITE);
+    _impostor_texture = LoadTextureFromImage(impostor_image);
+    UnloadImage(impostor_image);
+    _loaded = true;
+}
+
+void SphereLodRenderer::unload()
+{
+    if (!_loaded)
+    {
+        return;
+    }
+    for (const Mesh &mesh : _meshes)
+    {
+        UnloadMesh(mesh);
+    }
+    UnloadMaterial(_material);
+    UnloadTexture(_impostor_texture);
+    _loaded = false;
+}
+
+void SphereLodRenderer::begin_frame()
+{
+    _stats = SphereLodStats{};
+    for (std::vector<Matrix> &transforms : _transforms)
+    {
+        transforms.clear();
+    }
+}
+
+void SphereLodRenderer::draw(const Camera3D &camera,
+                             const Position &position,
+                             const Quaternion &rotation,
+                             const SphereMesh &sphere_mesh,
+                             const SphereLod &sphere_lod,
+                             const Color &colour)
+{
+    const std::size_t level{static_cast<std::size_t>(
+        sphere_lod._level < kSphereImpostorLevel ? sphere_lod._level
+                                                 : kSphereImpostorLevel)};
+    ++_stats._spheres_per_level[level];
+    _stats._vertices_without_lod += kDrawSphereVertices;
+
+    if (level == kSphereImpostorLevel)
+    {
+        DrawBillboard(camera,
+                      _impostor_texture,
+                      position._centre,
+                      2.F * sphere_mesh._radius,
+                      colour);
+        _stats._vertices += kImpostorVertices;
+        return;
+    }
+
+    std::vector<Matrix> &transforms{_transforms[level]};
+    if (!transforms.empty() && !colours_equal(_colours[level], colour))
+    {
+        draw_instances(level);
+    }
+    _colours[level] = colour;
+    // The impostor above is view aligned, so only meshes need the rotation
+    transforms.push_back(
+        model_matrix(position._centre, rotation, sphere_mesh._radius));
+    _stats._vertices += static_cast<std::uint64_t>(_meshes[level].vertexCount);
+}
+
+void SphereLodRenderer::end_frame()
+{
+    for (std::size_t level{0}; level < _transforms.size(); ++level)
+    {
+        draw_instances(level);
+    }
+}
+
+void SphereLodRenderer::draw_instances(const std::size_t level)
+{
+    std::vector<Matrix> &transforms{_transforms[level]};
+    if (transforms.empty())
+    {
+        return;
+    }
+    _material.maps[MATERIAL_MAP_DIFFUSE].color = _colours[level];
+    if (_instanced)
+    {
+        DrawMeshInstanced(_meshes[level],
+                          _material,
+                          transforms.data(),
+                          static_cast<int>(transforms.size()));
+        ++_stats._mesh_draw_calls;
+    }
+    else
+    {
+        for (const Matrix &transform : transforms)
+        {
+            DrawMesh(_meshes[level], _material, transform);
+        }
+        _stats._mesh_draw_calls += static_cast<std::uint32_t>(transforms.size());
+    }
+    transforms.clear();
+}
+
+const SphereLodStats &SphereLodRenderer::stats() const
+{
+    return _stats;
+}
+
+std::size_t SphereLodRenderer::gpu_bytes() const
+{
+    // GenMeshSphere uploads positions, normals and texture coordinates
+    constexpr std::size_t kFloatsPerVertex{3 + 3 + 2};
+
+    std::size_t bytes{texture_bytes(_impostor_texture)};
+    for (const Mesh &mesh : _meshes)
+    {
+        bytes += static_cast<std::size_t>(mesh.vertexCount) *
+                 kFloatsPerVertex * sizeof(float);
+    }
+    return bytes;
+}
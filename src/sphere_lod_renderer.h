@@ -0,0 +1,66 @@
+#ifndef SRC_SPHERE_LOD_RENDERER_H
+#define SRC_SPHERE_LOD_RENDERER_H
+
+#include "components.h"
+#include "sphere_lod.h"
+
+#include <raylib.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SphereLodStats
+{
+    std::array<std::uint32_t, kSphereLodLevels.size() + 1> _spheres_per_level{};
+    std::uint64_t _vertices{0};
+    std::uint64_t _vertices_without_lod{0};
+    std::uint32_t _mesh_draw_calls{0};
+};
+
+// Owns the GPU side of sphere LOD: one unit sphere mesh per detail level, the
+// shader that instances them, and a disc texture for the billboard impostor.
+// Spheres are queued per level between begin_frame and end_frame, then drawn
+// with one DrawMeshInstanced call per level. Needs a GL context, so load after
+// InitWindow and unload before the window closes.
+class SphereLodRenderer
+{
+public:
+    SphereLodRenderer() = default;
+
+    // mutator methods
+    void load();
+    void unload();
+    void begin_frame();
+    // Impostors go straight into rlgl's batch, meshes wait for end_frame
+    void draw(const Camera3D &camera,
+              const Position &position,
+              const Quaternion &rotation,
+              const SphereMesh &sphere_mesh,
+              const SphereLod &sphere_lod,
+              const Color &colour);
+    // Call before EndMode3D
+    void end_frame();
+
+    // accessor methods
+    [[nodiscard]] const SphereLodStats &stats() const;
+    [[nodiscard]] std::size_t gpu_bytes() const;
+
+private:
+    void draw_instances(std::size_t level);
+
+    std::array<Mesh, kSphereLodLevels.size()> _meshes{};
+    Material _material{};
+    // false if the instancing shader did not build, then each sphere is drawn
+    // on its own with the default shader
+    bool _instanced{false};
+    // one colour per level, a sphere of another colour flushes the level
+    std::array<std::vector<Matrix>, kSphereLodLevels.size()> _transforms{};
+    std::array<Color, kSphereLodLevels.size()> _colours{};
+    Texture2D _impostor_texture{};
+    bool _loaded{false};
+    SphereLodStats _stats{};
+};
+
+#endif
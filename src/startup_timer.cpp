@@ -0,0 +1,69 @@
+#include "startup_timer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <mutex>
+#include <ratio>
+#include <vector>
+
+namespace
+{
+double milliseconds_between(const std::chrono::steady_clock::time_point start,
+                            const std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>{end - start}.count();
+}
+} // namespace
+
+StartupTimer::StartupTimer() : _mutex{}, _start{std::chrono::steady_clock::now()}
+{
+}
+
+void StartupTimer::record(const char *name,
+                          const char *thread,
+                          const std::chrono::steady_clock::time_point start,
+                          const std::chrono::steady_clock::time_point end)
+{
+    const std::lock_guard<std::mutex> lock{_mutex};
+    _phases.push_back(StartupPhase{name,
+                                   thread,
+                                   milliseconds_between(_start, start),
+                                   milliseconds_between(start, end)});
+}
+
+void StartupTimer::log() const
+{
+    const std::lock_guard<std::mutex> lock{_mutex};
+    const double total{
+        milliseconds_between(_start, std::chrono::steady_clock::now())};
+
+    // the serial sum is what startup took before phases overlapped
+    double serial{0.0};
+    spdlog::info("Startup phases:");
+    for (const StartupPhase &phase : _phases)
+    {
+        spdlog::info("  {:<7} {:<24} starts {:8.2f} ms, takes {:8.2f} ms",
+                     phase._thread,
+                     phase._name,
+                     phase._start_milliseconds,
+                     phase._milliseconds);
+        serial += phase._milliseconds;
+    }
+    spdlog::info("Ready after {:.2f} ms, {:.2f} ms of phases in total",
+                 total,
+                 serial);
+}
+
+ScopedStartupPhase::ScopedStartupPhase(StartupTimer &timer,
+                                       const char *name,
+                                       const char *thread)
+    : _timer{timer}, _name{name}, _thread{thread},
+      _start{std::chrono::steady_clock::now()}
+{
+}
+
+ScopedStartupPhase::~ScopedStartupPhase()
+{
+    _timer.record(_name, _thread, _start, std::chrono::steady_clock::now());
+}
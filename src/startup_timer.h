@@ -0,0 +1,59 @@
+#ifndef SRC_STARTUP_TIMER_H
+#define SRC_STARTUP_TIMER_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+struct StartupPhase
+{
+    const char *_name{nullptr};
+    const char *_thread{nullptr};
+    double _start_milliseconds{0.0}; // since the timer was created
+    double _milliseconds{0.0};
+};
+
+// Wall clock time of each startup phase, for the report logged once the first
+// frame is about to start. Phases can be recorded from any thread, and names
+// must be string literals.
+class StartupTimer
+{
+public:
+    StartupTimer();
+
+    // mutator methods
+    void record(const char *name,
+                const char *thread,
+                std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+
+    // accessor methods
+    void log() const;
+
+private:
+    mutable std::mutex _mutex;
+    std::chrono::steady_clock::time_point _start;
+    std::vector<StartupPhase> _phases{};
+};
+
+// Records the time between construction and destruction as one phase
+class ScopedStartupPhase
+{
+public:
+    ScopedStartupPhase(StartupTimer &timer,
+                       const char *name,
+                       const char *thread);
+    ~ScopedStartupPhase();
+    ScopedStartupPhase(const ScopedStartupPhase &) = delete;
+    ScopedStartupPhase &operator=(const ScopedStartupPhase &) = delete;
+    ScopedStartupPhase(ScopedStartupPhase &&) = delete;
+    ScopedStartupPhase &operator=(ScopedStartupPhase &&) = delete;
+
+private:
+    StartupTimer &_timer;
+    const char *_name;
+    const char *_thread;
+    std::chrono::steady_clock::time_point _start;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "static_geometry_renderer.h"
+
+#include "static_mesh.h"
+
+#include <raylib.h>
+#include <raymath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+// UnloadMesh frees the CPU arrays with raylib's allocator, so they have to be
+// allocated with it too
+template <typename Element>
+Element *raylib_copy(const std::vector<Element> &source)
+{
+    const auto bytes{static_cast<unsigned int>(source.size() * sizeof(Element))};
+    auto *copy{static_cast<Element *>(MemAlloc(bytes))};
+    std::memcpy(copy, source.data(), bytes);
+    return copy;
+}
+} // namespace
+
+void StaticGeometryRenderer::load()
+{
+    // the default shader multiplies in the baked vertex colours
+    _material = LoadMaterialDefault();
+    _loaded = true;
+}
+
+void StaticGeometryRenderer::unload()
+{
+    if (!_loaded)
+    {
+        return;
+    }
+    unload_mesh();
+    UnloadMaterial(_material);
+    _loaded = false;
+}
+
+void StaticGeometryRenderer::upload(const StaticMeshData &mesh_data)
+{
+    unload_mesh();
+    ++_uploads;
+    if (mesh_data.vertex_count() == 0)
+    {
+        return;
+    }
+
+    _mesh = Mesh{};
+    _mesh.vertexCount = static_cast<int>(mesh_data.vertex_count());
+    _mesh.triangleCount = static_cast<int>(mesh_data.triangle_count());
+    _mesh.vertices = raylib_copy(mesh_data._positions);
+    _mesh.normals = raylib_copy(mesh_data._normals);
+    _mesh.colors = raylib_copy(mesh_data._colours);
+    _mesh.indices = raylib_copy(mesh_data._indices);
+    UploadMesh(&_mesh, false);
+    _has_mesh = true;
+}
+
+void StaticGeometryRenderer::draw() const
+{
+    if (_has_mesh)
+    {
+        // vertices are baked in world space
+        DrawMesh(_mesh, _material, MatrixIdentity());
+    }
+}
+
+void StaticGeometryRenderer::unload_mesh()
+{
+    if (_has_mesh)
+    {
+        UnloadMesh(_mesh);
+        _mesh = Mesh{};
+        _has_mesh = false;
+    }
+}
+
+std::size_t StaticGeometryRenderer::gpu_bytes() const
+{
+    if (!_has_mesh)
+    {
+        return 0;
+    }
+    // positions and normals, RGBA colours and 16-bit indices
+    constexpr std::size_t kVertexBytes{(3 + 3) * sizeof(float) + 4};
+    return static_cast<std::size_t>(_mesh.vertexCount) * kVertexBytes +
+           static_cast<std::size_t>(_mesh.triangleCount) * 3 *
+               sizeof(unsigned short);
+}
+
+std::size_t StaticGeometryRenderer::triangle_count() const
+{
+    return _has_mesh ? static_cast<std::size_t>(_mesh.triangleCount) : 0;
+}
+
+std::uint64_t StaticGeometryRenderer::uploads() const
+{
+    return _uploads;
+}
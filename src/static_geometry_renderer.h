@@ -0,0 +1,43 @@
+#ifndef SRC_STATIC_GEOMETRY_RENDERER_H
+#define SRC_STATIC_GEOMETRY_RENDERER_H
+
+#include "static_mesh.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Owns the GPU copy of the baked static geometry: one mesh holding the floor
+// grid and every static collider, uploaded again only when they change and
+// drawn with a single DrawMesh. Needs a GL context, so load after InitWindow
+// and unload before the window closes.
+class StaticGeometryRenderer
+{
+public:
+    StaticGeometryRenderer() = default;
+
+    // mutator methods
+    void load();
+    void unload();
+
+    // Replaces the current mesh with a copy of mesh_data
+    void upload(const StaticMeshData &mesh_data);
+    void draw() const;
+
+    // accessor methods
+    [[nodiscard]] std::size_t gpu_bytes() const;
+    [[nodiscard]] std::size_t triangle_count() const;
+    [[nodiscard]] std::uint64_t uploads() const;
+
+private:
+    void unload_mesh();
+
+    Mesh _mesh{};
+    Material _material{};
+    bool _loaded{false};
+    bool _has_mesh{false};
+    std::uint64_t _uploads{0};
+};
+
+#endif
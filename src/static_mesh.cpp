@@ -0,0 +1,156 @@
+#include "static_mesh.h"
+
+#include <raylib.h>
+
+#include <array>
+#include <cstddef>
+
+namespace
+{
+constexpr std::size_t kQuadVertices{4};
+constexpr std::array<unsigned short, 6> kQuadIndices{0, 1, 2, 0, 2, 3};
+
+Vector3 add(const Vector3 &first, const Vector3 &second)
+{
+    return Vector3{first.x + second.x, first.y + second.y, first.z + second.z};
+}
+
+Vector3 subtract(const Vector3 &first, const Vector3 &second)
+{
+    return Vector3{first.x - second.x, first.y - second.y, first.z - second.z};
+}
+
+bool has_room(const StaticMeshData &mesh, const std::size_t vertices)
+{
+    return mesh.vertex_count() + vertices <= kMaxStaticMeshVertices;
+}
+
+// Quad centred on centre spanning +-u and +-v. Wound counter-clockwise seen
+// from the side u x v points to, which must be the normal.
+void append_quad(StaticMeshData &mesh,
+                 const Vector3 &centre,
+                 const Vector3 &u,
+                 const Vector3 &v,
+                 const Vector3 &normal,
+                 const Color &colour)
+{
+    const auto first_index{static_cast<unsigned short>(mesh.vertex_count())};
+    const std::array<Vector3, kQuadVertices> corners{
+        subtract(subtract(centre, u), v),
+        subtract(add(centre, u), v),
+        add(add(centre, u), v),
+        add(subtract(centre, u), v)};
+    for (const Vector3 &corner : corners)
+    {
+        mesh._positions.insert(mesh._positions.end(),
+                               {corner.x, corner.y, corner.z});
+        mesh._normals.insert(mesh._normals.end(),
+                             {normal.x, normal.y, normal.z});
+        mesh._colours.insert(mesh._colours.end(),
+                             {colour.r, colour.g, colour.b, colour.a});
+    }
+    for (const unsigned short corner : kQuadIndices)
+    {
+        mesh._indices.push_back(
+            static_cast<unsigned short>(first_index + corner));
+    }
+}
+
+Color shade(const Color &colour, const float brightness)
+{
+    const auto channel{[brightness](const unsigned char value) {
+        return static_cast<unsigned char>(static_cast<float>(value) *
+                                          brightness);
+    }};
+    return Color{channel(colour.r), channel(colour.g), channel(colour.b),
+                 colour.a};
+}
+} // namespace
+
+std::size_t StaticMeshData::vertex_count() const
+{
+    return _positions.size() / 3;
+}
+
+std::size_t StaticMeshData::triangle_count() const
+{
+    return _indices.size() / 3;
+}
+
+bool append_grid(StaticMeshData &mesh,
+                 const int slices,
+                 const float spacing,
+                 const float line_width)
+{
+    const int half_slices{slices / 2};
+    const auto lines{static_cast<std::size_t>(2 * (2 * half_slices + 1))};
+    if (!has_room(mesh, lines * kQuadVertices))
+    {
+        return false;
+    }
+
+    // DrawGrid draws the centre lines darker than the rest
+    constexpr Color kCentreLineColour{127, 127, 127, 255};
+    constexpr Color kLineColour{191, 191, 191, 255};
+    // lifted clear of anything with its top face at y = 0
+    constexpr float kGridHeight{0.002F};
+
+    const Vector3 up{0.F, 1.F, 0.F};
+    const float half_length{static_cast<float>(half_slices) * spacing};
+    const float half_width{0.5F * line_width};
+    for (int line{-half_slices}; line <= half_slices; ++line)
+    {
+        const Color colour{line == 0 ? kCentreLineColour : kLineColour};
+        const float offset{static_cast<float>(line) * spacing};
+
+        // along z, then along x
+        append_quad(mesh,
+                    Vector3{offset, kGridHeight, 0.F},
+                    Vector3{0.F, 0.F, half_length},
+                    Vector3{half_width, 0.F, 0.F},
+                    up,
+                    colour);
+        append_quad(mesh,
+                    Vector3{0.F, kGridHeight, offset},
+                    Vector3{0.F, 0.F, half_width},
+                    Vector3{half_length, 0.F, 0.F},
+                    up,
+                    colour);
+    }
+    return true;
+}
+
+bool append_box(StaticMeshData &mesh,
+                const Vector3 &centre,
+                const Vector3 &half_extent,
+                const Color &colour)
+{
+    constexpr std::size_t kFaces{6};
+    if (!has_room(mesh, kFaces * kQuadVertices))
+    {
+        return false;
+    }
+
+    const Vector3 x{half_extent.x, 0.F, 0.F};
+    const Vector3 y{0.F, half_extent.y, 0.F};
+    const Vector3 z{0.F, 0.F, half_extent.z};
+    constexpr float kTopBrightness{1.F};
+    constexpr float kSideBrightness{0.85F};
+    constexpr float kFrontBrightness{0.7F};
+    constexpr float kBottomBrightness{0.55F};
+
+    // For each face u x v points out of the box
+    append_quad(mesh, add(centre, y), z, x, Vector3{0.F, 1.F, 0.F},
+                shade(colour, kTopBrightness));
+    append_quad(mesh, subtract(centre, y), x, z, Vector3{0.F, -1.F, 0.F},
+                shade(colour, kBottomBrightness));
+    append_quad(mesh, add(centre, x), y, z, Vector3{1.F, 0.F, 0.F},
+                shade(colour, kSideBrightness));
+    append_quad(mesh, subtract(centre, x), z, y, Vector3{-1.F, 0.F, 0.F},
+                shade(colour, kSideBrightness));
+    append_quad(mesh, add(centre, z), x, y, Vector3{0.F, 0.F, 1.F},
+                shade(colour, kFrontBrightness));
+    append_quad(mesh, subtract(centre, z), y, x, Vector3{0.F, 0.F, -1.F},
+                shade(colour, kFrontBrightness));
+    return true;
+}
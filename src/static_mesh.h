@@ -0,0 +1,42 @@
+#ifndef SRC_STATIC_MESH_H
+#define SRC_STATIC_MESH_H
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <vector>
+
+// raylib meshes index with unsigned short
+inline constexpr std::size_t kMaxStaticMeshVertices{65'536};
+
+// CPU side of a baked static mesh, laid out the way raylib's Mesh expects so
+// it can be copied straight into one. Vertices are in world space.
+struct StaticMeshData
+{
+    std::vector<float> _positions{};         // x, y, z per vertex
+    std::vector<float> _normals{};           // x, y, z per vertex
+    std::vector<unsigned char> _colours{};   // r, g, b, a per vertex
+    std::vector<unsigned short> _indices{};  // three per triangle
+
+    [[nodiscard]] std::size_t vertex_count() const;
+    [[nodiscard]] std::size_t triangle_count() const;
+};
+
+// Each append returns false, leaving the mesh as it was, when the extra
+// vertices would not fit in a 16-bit index.
+
+// Same layout and colours as raylib's DrawGrid, but as thin quads lying just
+// above y = 0, since raylib meshes can only hold triangles
+bool append_grid(StaticMeshData &mesh,
+                 int slices,
+                 float spacing,
+                 float line_width);
+
+// Axis aligned box with outward facing normals. Faces are shaded by their
+// direction, so the box reads as solid without a lighting shader.
+bool append_box(StaticMeshData &mesh,
+                const Vector3 &centre,
+                const Vector3 &half_extent,
+                const Color &colour);
+
+#endif
@@ -2,28 +2,95 @@
 
 #include "components.h"
 #include "constants.h"
+#include "debug_draw.h"
+#include "flecs_stats.h"
+#include "history.h"
+#include "memory_stats.h"
+#include "particles.h"
 #include "physics.h"
+#include "physics_commands.h"
+#include "physics_thread.h"
+#include "picking.h"
+#include "profiler.h"
+#include "rigid_body_transform.h"
+#include "spatial_query.h"
+#include "sphere_lod.h"
+#include "sphere_lod_renderer.h"
+#include "static_geometry_renderer.h"
+#include "static_mesh.h"
+#include "tick_scheduler.h"
+#include "transform_snapshot.h"
+#include "viewport.h"
+#include "world_partition.h"
 
 #include <flecs/addons/cpp/entity.hpp>
 #include <flecs/addons/cpp/flecs.hpp>
+#include <flecs/addons/cpp/iter.hpp>
 #include <flecs/addons/cpp/mixins/query/impl.hpp>
 #include <flecs/addons/cpp/world.hpp>
 #include <fmt/core.h>
 #include <imgui.h>
 #include <raylib.h>
+#include <raymath.h>
+#include <rlgl.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <array>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <ratio>
 #include <string>
+#include <utility>
+#include <vector>
 
-void draw_grid_system(
-    const flecs::query<const Position, const GridComponent> &draw_grid_query)
+void bake_static_geometry_system(
+    const flecs::query<const Position, const GridComponent> &static_grid_query,
+    const flecs::query<const Position, const BoxCollider>
+        &static_collider_query,
+    StaticGeometryRenderer &static_geometry_renderer)
 {
-    draw_grid_query.each(
-        [](const Position & /* position */, const GridComponent &grid) {
-            DrawGrid(grid.slices, grid.spacing);
-        });
+    // both are always asked, the first changed() call on a query is what
+    // turns its change tracking on
+    const bool grid_changed{static_grid_query.changed()};
+    const bool colliders_changed{static_collider_query.changed()};
+    if (!grid_changed && !colliders_changed)
+    {
+        return;
+    }
+
+    StaticMeshData mesh_data{};
+    static_grid_query.each([&mesh_data](const Position & /* position */,
+                                        const GridComponent &grid) {
+        // centred on the origin, like DrawGrid
+        if (!append_grid(mesh_data,
+                         grid.slices,
+                         grid.spacing,
+                         constants::kGridLineWidth))
+        {
+            spdlog::warn("Static geometry is full, skipping a grid");
+        }
+    });
+    static_collider_query.each([&mesh_data](const Position &position,
+                                            const BoxCollider &box_collider) {
+        if (!append_box(mesh_data,
+                        position._centre,
+                        box_collider._half_extent,
+                        constants::kStaticGeometryColour))
+        {
+            spdlog::warn("Static geometry is full, skipping a box collider");
+        }
+    });
+    static_geometry_renderer.upload(mesh_data);
+}
+
+void draw_static_geometry_system(
+    const StaticGeometryRenderer &static_geometry_renderer)
+{
+    static_geometry_renderer.draw();
 }
 
 void draw_scene_text_system(const Font &font)
@@ -38,6 +105,28 @@ void draw_scene_text_system(const Font &font)
     DrawFPS(constants::kFPSPositionX, constants::kFPSPositionY);
 }
 
+void draw_scene_text_overlay_system(const Vector2 &origin)
+{
+    ImDrawList *draw_list{ImGui::GetWindowDrawList()};
+    const auto font_size{static_cast<float>(constants::kTextFontSize)};
+    const ImColor text_colour{DARKGRAY.r, DARKGRAY.g, DARKGRAY.b, DARKGRAY.a};
+    draw_list->AddText(
+        ImGui::GetFont(),
+        font_size,
+        ImVec2{origin.x + static_cast<float>(constants::kTextPositionX),
+               origin.y + static_cast<float>(constants::kTextPositionY)},
+        text_colour,
+        "Press F9 for ImGui debug mode");
+    const ImColor fps_colour{LIME.r, LIME.g, LIME.b, LIME.a};
+    draw_list->AddText(
+        ImGui::GetFont(),
+        font_size,
+        ImVec2{origin.x + static_cast<float>(constants::kFPSPositionX),
+               origin.y + static_cast<float>(constants::kFPSPositionY)},
+        fps_colour,
+        fmt::format("{} FPS", GetFPS()).c_str());
+}
+
 void render_simulation_tree_node(DevPanelState &dev_panel_state)
 {
     ImGui::SeparatorText("Simulation");
@@ -121,11 +210,14 @@ void render_simulation_tree_node(DevPanelState &dev_panel_state)
     ImGui::PopID();
 }
 
-void render_introspection_tree_node(const Position &position,
+void render_introspection_tree_node(const std::uint64_t entity_id,
+                                    const Position &position,
                                     const Velocity &velocity)
 {
     if (ImGui::TreeNode("Sphere components"))
     {
+        ImGui::Text("%s", // NOLINT [cppcoreguidelines-pro-type-vararg]
+                    fmt::format("Entity: {}", entity_id).c_str());
         if (ImGui::TreeNode("Position"))
         {
             ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
@@ -156,28 +248,127 @@ void render_introspection_tree_node(const Position &position,
                 fmt::format("{:.{}f}", velocity._value.z, 2).c_str());
             ImGui::TreePop();
         }
+        ImGui::TreePop();
+    }
+}
+
+void render_history_tree_node(const flecs::entity &entity,
+                              DevPanelState &dev_panel_state)
+{
+    ImGui::Checkbox("Record history", &dev_panel_state._record_history);
+    if (!entity.has<History>() || !ImGui::TreeNode("History"))
+    {
+        return;
+    }
+    History *history{entity.get_mut<History>()};
+    ImGui::SliderInt("Samples shown",
+                     &history->_window,
+                     constants::kHistoryMinWindow,
+                     static_cast<int>(constants::kHistoryCapacity),
+                     "%d",
+                     ImGuiSliderFlags_Logarithmic);
+
+    constexpr float kPlotHeight{40.F};
+    HistoryPlot plot{};
+    for (std::size_t field{0}; field < kHistoryFieldCount; ++field)
+    {
+        const std::uint32_t bit{
+            history_field_bit(static_cast<HistoryField>(field))};
+        bool recorded{(history->_fields & bit) != 0};
+        if (ImGui::Checkbox(kHistoryFieldLabels[field], &recorded))
+        {
+            history->_fields ^= bit;
+            history->_rings[field].clear();
+        }
+        const HistoryRing &ring{history->_rings[field]};
+        if (!recorded || ring.size() == 0)
+        {
+            continue;
+        }
+        const std::size_t points{decimate_min_max(
+            ring, static_cast<std::size_t>(history->_window), plot)};
+        const std::string overlay{
+            fmt::format("{:.{}f}", ring.at(ring.size() - 1), 2)};
+        ImGui::PushID(static_cast<int>(field));
+        ImGui::PlotLines("",
+                         plot.data(),
+                         static_cast<int>(points),
+                         0,
+                         overlay.c_str(),
+                         FLT_MAX,
+                         FLT_MAX,
+                         ImVec2{0.F, kPlotHeight});
+        ImGui::PopID();
     }
+    ImGui::TreePop();
 }
 
 void draw_dev_panel_system(
     const flecs::
         query<const Position, const Velocity, const SphereMesh, DevPanelState>
-            &draw_dev_panel_query)
+            &draw_dev_panel_query,
+    const TransformSnapshot &physics_snapshot,
+    const SnapshotSyncStats &sync_stats)
 {
-    draw_dev_panel_query.each([](const Position &position,
-                                 const Velocity &velocity,
-                                 const SphereMesh & /* sphere_mesh */,
-                                 DevPanelState &dev_panel_state) {
-        ImGui::Begin("Dev Panel");
+    ImGui::Begin("Dev Panel");
 
-        ImGui::Text("%s", // NOLINT [cppcoreguidelines-pro-type-vararg]
-                    fmt::format("FPS: {}", GetFPS()).c_str());
+    ImGui::Text("%s", // NOLINT [cppcoreguidelines-pro-type-vararg]
+                fmt::format("FPS: {}", GetFPS()).c_str());
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Physics step {}: {:.{}f} ms",
+                    physics_snapshot._step,
+                    physics_snapshot._step_milliseconds,
+                    3)
+            .c_str());
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Bodies synced: {} moved of {}",
+                    sync_stats._moved_bodies,
+                    sync_stats._bodies)
+            .c_str());
 
-        render_simulation_tree_node(dev_panel_state);
-        render_introspection_tree_node(position, velocity);
+    // Panel controls are drawn once, with the first sphere. Introspection
+    // shows the entity picked in the viewport, or the first sphere if none is.
+    bool controls_drawn{false};
+    draw_dev_panel_query.each([&controls_drawn](
+                                  flecs::entity entity,
+                                  const Position &position,
+                                  const Velocity &velocity,
+                                  const SphereMesh & /* sphere_mesh */,
+                                  DevPanelState &dev_panel_state) {
+        const bool first_sphere{!controls_drawn};
+        if (first_sphere)
+        {
+            render_simulation_tree_node(dev_panel_state);
+            controls_drawn = true;
+        }
 
-        ImGui::TreePop();
-        if (ImGui::TreeNode("Sphere colour"))
+        const bool inspected{
+            entity.id() == dev_panel_state._selected_entity ||
+            (dev_panel_state._selected_entity == 0 && first_sphere)};
+        if (inspected)
+        {
+            dev_panel_state._inspected_entity = entity.id();
+            render_introspection_tree_node(entity.id(), position, velocity);
+            render_history_tree_node(entity, dev_panel_state);
+            const SpatialQueryHits *ground_probe{
+                entity.get<SpatialQueryHits>()};
+            if (ground_probe != nullptr)
+            {
+                ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+                    "%s",
+                    ground_probe->_count > 0
+                        ? fmt::format("Ground probe: entity {} {:.{}f} m below",
+                                      ground_probe->_entities[0],
+                                      ground_probe->_distance,
+                                      2)
+                              .c_str()
+                        : "Ground probe: nothing below");
+            }
+        }
+
+        if (first_sphere && ImGui::TreeNode("Sphere colour"))
         {
             int index{0};
             for (const std::string &colour : constants::kSphereColourLabels)
@@ -187,26 +378,554 @@ void draw_dev_panel_system(
                                    index);
                 ++index;
             }
+            ImGui::TreePop();
+        }
+    });
+    ImGui::End();
+}
+
+void draw_physics_debug_system(const DebugVertexCollector &physics_debug)
+{
+    // rlgl collects these in its own vertex buffer and flushes it when full,
+    // so a frame of debug geometry costs a handful of draw calls. Chunks hold
+    // whole lines and triangles, so a flush never splits one.
+    constexpr std::size_t kChunkVertices{6 * 1'024};
+    const auto submit{[](const std::vector<DebugVertex> &vertices,
+                         const int mode) {
+        for (std::size_t first{0}; first < vertices.size();
+             first += kChunkVertices)
+        {
+            const std::size_t end{
+                std::min(first + kChunkVertices, vertices.size())};
+            rlCheckRenderBatchLimit(static_cast<int>(end - first));
+            rlBegin(mode);
+            for (std::size_t index{first}; index < end; ++index)
+            {
+                const DebugVertex &vertex{vertices[index]};
+                rlColor4ub(vertex._colour.r,
+                           vertex._colour.g,
+                           vertex._colour.b,
+                           vertex._colour.a);
+                rlVertex3f(vertex._position.x,
+                           vertex._position.y,
+                           vertex._position.z);
+            }
+            rlEnd();
+        }
+    }};
+
+    // Jolt's shapes are not all wound the same way
+    rlDisableBackfaceCulling();
+    submit(physics_debug.triangles(), RL_TRIANGLES);
+    submit(physics_debug.lines(), RL_LINES);
+    rlDrawRenderBatchActive();
+    rlEnableBackfaceCulling();
+}
+
+void draw_particles_system(const ParticleSystem &particles,
+                           const ParticleSettings &settings)
+{
+    if (particles.empty())
+    {
+        return;
+    }
+    // Each particle is a streak back along its velocity, two vertices in
+    // rlgl's batch, so a million cost a few dozen draw calls. Past
+    // constants::kMaxDrawnParticles an even sample of them is drawn.
+    constexpr std::size_t kChunkVertices{6 * 1'024};
+    constexpr std::size_t kChunkParticles{kChunkVertices / 2};
+    const std::size_t stride{
+        (particles.size() + constants::kMaxDrawnParticles - 1) /
+        constants::kMaxDrawnParticles};
+    std::size_t particle{0};
+    while (particle < particles.size())
+    {
+        rlCheckRenderBatchLimit(static_cast<int>(kChunkVertices));
+        rlBegin(RL_LINES);
+        for (std::size_t drawn{0};
+             drawn < kChunkParticles && particle < particles.size();
+             ++drawn, particle += stride)
+        {
+            const Vector3 head{particles.position(particle)};
+            const Vector3 tail{Vector3Subtract(
+                head,
+                Vector3Scale(particles.velocity(particle),
+                             settings._streak_seconds))};
+            const Color colour{particles.colour(particle)};
+            rlColor4ub(colour.r, colour.g, colour.b, colour.a);
+            rlVertex3f(tail.x, tail.y, tail.z);
+            rlVertex3f(head.x, head.y, head.z);
         }
+        rlEnd();
+    }
+    rlDrawRenderBatchActive();
+}
+
+void draw_particles_panel_system(ParticleSystem &particles,
+                                 ParticleSettings &settings)
+{
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("Particles");
+    ImGui::Checkbox("Emit", &settings._emitting);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+    {
+        particles.clear();
+    }
+    constexpr float kMaxGravity{30.F};
+    constexpr float kMaxDrag{4.F};
+    constexpr float kMaxStreakSeconds{0.2F};
+    ImGui::SliderFloat("Gravity", &settings._gravity, -kMaxGravity, 0.F);
+    ImGui::SliderFloat("Drag", &settings._drag, 0.F, kMaxDrag);
+    ImGui::SliderFloat("Restitution", &settings._restitution, 0.F, 1.F);
+    ImGui::SliderFloat(
+        "Streak (s)", &settings._streak_seconds, 0.F, kMaxStreakSeconds);
+
+    const std::size_t stride{
+        (particles.size() + constants::kMaxDrawnParticles - 1) /
+        constants::kMaxDrawnParticles};
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("{} of {} particles, {} kernel",
+                    particles.size(),
+                    constants::kMaxParticles,
+                    ParticleSystem::kernel_name())
+            .c_str());
+    if (stride > 1)
+    {
+        ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+            "%s",
+            fmt::format("Drawing 1 in {} particles", stride).c_str());
+    }
+    ImGui::End();
+}
+
+void draw_physics_debug_panel_system(const DebugVertexCollector &physics_debug,
+                                     const bool available,
+                                     DebugDrawSettings &settings)
+{
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("Physics debug view");
+    if (!available)
+    {
+        ImGui::TextUnformatted(
+            "Jolt was built without its debug renderer (Distribution)");
+        ImGui::End();
+        return;
+    }
+    ImGui::Checkbox("Show physics debug view", &settings._enabled);
+    ImGui::BeginDisabled(!settings._enabled);
+    ImGui::Checkbox("Shapes", &settings._shapes);
+    ImGui::SameLine();
+    ImGui::Checkbox("Wireframe", &settings._wireframe);
+    ImGui::Checkbox("Sleeping bodies in red", &settings._sleep_colours);
+    ImGui::Checkbox("Broad phase bounds", &settings._bounding_boxes);
+    ImGui::Checkbox("Velocities", &settings._velocities);
+    ImGui::SameLine();
+    ImGui::Checkbox("Centres of mass", &settings._centres_of_mass);
+    ImGui::Checkbox("Contacts", &settings._contacts);
+    ImGui::EndDisabled();
+
+    // rlgl's batch holds four vertices per element
+    constexpr std::size_t kBatchVertices{4 * RL_DEFAULT_BATCH_BUFFER_ELEMENTS};
+    const std::size_t vertices{physics_debug.lines().size() +
+                               physics_debug.triangles().size()};
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("{} shapes, {} lines, {} triangles, ~{} draw calls",
+                    physics_debug.mesh_count(),
+                    physics_debug.line_count(),
+                    physics_debug.triangle_count(),
+                    (vertices + kBatchVertices - 1) / kBatchVertices)
+            .c_str());
+    ImGui::End();
+}
+
+void draw_world_partition_panel_system(const WorldPartition &world_partition,
+                                       WorldPartitionSettings &settings)
+{
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("World partition");
+    ImGui::Checkbox("Stream cells around the camera", &settings._enabled);
+    // parked entities are filed by cell, so the size is fixed while streaming
+    ImGui::BeginDisabled(settings._enabled);
+    constexpr float kMinCellSize{4.F};
+    constexpr float kMaxCellSize{128.F};
+    ImGui::SliderFloat(
+        "Cell size", &settings._cell_size, kMinCellSize, kMaxCellSize, "%.0f");
+    ImGui::EndDisabled();
+    ImGui::SliderInt("Load radius",
+                     &settings._load_radius,
+                     0,
+                     constants::kPartitionMaxRadius);
+    ImGui::SliderInt("Unload radius",
+                     &settings._unload_radius,
+                     settings._load_radius,
+                     constants::kPartitionMaxRadius);
+    constexpr float kMinBudget{0.1F};
+    constexpr float kMaxBudget{8.F};
+    ImGui::SliderFloat("Load budget (ms)",
+                       &settings._load_budget_milliseconds,
+                       kMinBudget,
+                       kMaxBudget,
+                       "%.1f");
+    if (!world_partition.active())
+    {
         ImGui::End();
+        return;
+    }
+    const PartitionCell &centre{world_partition.centre()};
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Centre cell ({}, {}), {} loaded, {} queued",
+                    centre._x,
+                    centre._z,
+                    world_partition.loaded_cell_count(),
+                    world_partition.queued_cell_count())
+            .c_str());
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Parked: {} entities in {} cells",
+                    world_partition.parked_entity_count(),
+                    world_partition.parked_cell_count())
+            .c_str());
+    ImGui::End();
+}
+
+void draw_viewport_panel_system(const ViewportDirtyTracker &viewport_tracker,
+                                const SphereLodStats &sphere_lod_stats,
+                                DevPanelState &dev_panel_state)
+{
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("Viewport");
+    ImGui::Checkbox("Render at viewport resolution",
+                    &dev_panel_state._render_direct);
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Frames rendered: {}, skipped: {}",
+                    viewport_tracker.rendered_frames(),
+                    viewport_tracker.skipped_frames())
+            .c_str());
+
+    const auto &spheres_per_level{sphere_lod_stats._spheres_per_level};
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Sphere LODs: {} / {} / {}, impostors: {}",
+                    spheres_per_level[0],
+                    spheres_per_level[1],
+                    spheres_per_level[2],
+                    spheres_per_level[kSphereImpostorLevel])
+            .c_str());
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Sphere vertices: {} (without LOD: {})",
+                    sphere_lod_stats._vertices,
+                    sphere_lod_stats._vertices_without_lod)
+            .c_str());
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Sphere mesh draw calls: {}",
+                    sphere_lod_stats._mesh_draw_calls)
+            .c_str());
+    ImGui::End();
+}
+
+void pick_entity_system(PhysicsThread &physics_thread,
+                        const Camera3D &camera,
+                        const Vector2 &viewport_point,
+                        const float aspect_ratio,
+                        DevPanelState &dev_panel_state)
+{
+    constexpr float kMaxPickDistance{1'000.F};
+    const PickRay ray{viewport_pick_ray(camera, viewport_point, aspect_ratio)};
+
+    const auto pick_start{std::chrono::steady_clock::now()};
+    RayHit hit{};
+    bool hit_found{false};
+    physics_thread.with_engine(
+        [&ray, &hit, &hit_found](const PhysicsEngine &physics_engine) {
+            hit_found = physics_engine.cast_ray(
+                ray._origin, ray._direction, kMaxPickDistance, hit);
+        });
+    const float pick_microseconds{
+        std::chrono::duration<float, std::micro>{
+            std::chrono::steady_clock::now() - pick_start}
+            .count()};
+
+    // clicking empty space clears the selection
+    dev_panel_state._selected_entity = hit_found ? hit._entity : 0;
+    if (hit_found)
+    {
+        spdlog::info("Picked entity {} at distance {:.{}f} in {:.{}f} us",
+                     hit._entity,
+                     hit._distance,
+                     2,
+                     pick_microseconds,
+                     1);
+    }
+}
+
+void draw_memory_panel_system(const MemoryStats &memory_stats,
+                              const MemoryHistory &memory_history)
+{
+    constexpr float kPlotHeight{40.F};
+    const auto plot{[&memory_history](const char *label, const float *values) {
+        ImGui::PlotLines(label,
+                         values,
+                         MemoryHistory::kSampleCount,
+                         memory_history.offset(),
+                         nullptr,
+                         0.F,
+                         FLT_MAX,
+                         ImVec2{0.F, kPlotHeight});
+    }};
+    const auto bytes_row{[](const char *label, const std::size_t bytes) {
+        ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+            "%s",
+            fmt::format("{}: {:.{}f} KB",
+                        label,
+                        static_cast<float>(bytes) / 1'024.F,
+                        1)
+                .c_str());
+    }};
+
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("Memory");
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("Total: {:.{}f} MB",
+                    to_megabytes(memory_stats.total_bytes()),
+                    3)
+            .c_str());
+
+    const FlecsMemoryStats &flecs_stats{memory_stats._flecs};
+    if (ImGui::TreeNode("flecs world"))
+    {
+        ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+            "%s",
+            fmt::format("{} entities, {} tables ({} empty)",
+                        flecs_stats._entities,
+                        flecs_stats._tables,
+                        flecs_stats._empty_tables)
+                .c_str());
+        bytes_row("Components", flecs_stats._component_bytes);
+        bytes_row("Entity index (est.)", flecs_stats._entity_index_bytes);
+        bytes_row("Tables (est.)", flecs_stats._table_bytes);
+        plot("MB##flecs", memory_history.flecs_megabytes());
+        ImGui::TreePop();
+    }
+
+    const JoltMemoryStats &jolt_stats{memory_stats._jolt};
+    if (ImGui::TreeNode("Jolt physics system"))
+    {
+        ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+            "%s",
+            fmt::format("{} / {} bodies ({} active)",
+                        jolt_stats._bodies,
+                        jolt_stats._max_bodies,
+                        jolt_stats._active_bodies)
+                .c_str());
+        ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+            "%s",
+            fmt::format("Capacity: {} body pairs, {} contact constraints",
+                        jolt_stats._max_body_pairs,
+                        jolt_stats._max_contact_constraints)
+                .c_str());
+        bytes_row("Bodies", jolt_stats._body_bytes);
+        bytes_row("Body manager (est.)", jolt_stats._body_manager_bytes);
+        bytes_row("Broadphase (est.)", jolt_stats._broad_phase_bytes);
+        bytes_row("Contact cache (est.)", jolt_stats._contact_cache_bytes);
+        bytes_row("Temp allocator", jolt_stats._temp_allocator_bytes);
+        bytes_row("Shapes", jolt_stats._shape_bytes);
+        plot("MB##jolt", memory_history.jolt_megabytes());
+        ImGui::TreePop();
+    }
+
+    const RenderMemoryStats &render_stats{memory_stats._render};
+    if (ImGui::TreeNode("Render resources"))
+    {
+        bytes_row("Game texture", render_stats._game_texture_bytes);
+        bytes_row("Debug textures", render_stats._debug_texture_bytes);
+        bytes_row("Font atlas", render_stats._font_atlas_bytes);
+        bytes_row("Sphere meshes", render_stats._mesh_bytes);
+        plot("MB##render", memory_history.render_megabytes());
+        ImGui::TreePop();
+    }
+    ImGui::End();
+}
+
+void draw_profiler_panel_system(const FrameProfiler &profiler)
+{
+    constexpr float kPlotHeight{30.F};
+
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("Profiler");
+    for (const ProfileSection &section : profiler.sections())
+    {
+        const std::string label{fmt::format(
+            "{}: {:.{}f} ms", section._name, profiler.latest(section), 3)};
+        ImGui::PlotLines(label.c_str(),
+                         section._milliseconds.data(),
+                         ProfileSection::kSampleCount,
+                         profiler.offset(),
+                         nullptr,
+                         0.F,
+                         FLT_MAX,
+                         ImVec2{0.F, kPlotHeight});
+    }
+    ImGui::End();
+}
+
+void draw_tick_scheduler_panel_system(const TickScheduler &tick_scheduler)
+{
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("Tick sources");
+    for (std::size_t source{0}; source < kTickSourceCount; ++source)
+    {
+        const TickSourceStats &stats{
+            tick_scheduler.stats(static_cast<TickSource>(source))};
+        ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+            "%s",
+            fmt::format("{}: {:.1f} / {:.0f} Hz, {:.3f} ms per tick, "
+                        "{:.2f} ms/s",
+                        kTickSourceLabels[source],
+                        stats._measured_rate,
+                        stats._rate,
+                        stats._milliseconds_per_tick,
+                        stats._load)
+                .c_str());
+    }
+    ImGui::End();
+}
+
+void draw_flecs_stats_panel_system(const FlecsStatsHistory &flecs_stats)
+{
+    constexpr float kPlotHeight{30.F};
+    const auto plot{[&flecs_stats](const char *label, const float *values) {
+        ImGui::PlotLines(label,
+                         values,
+                         FlecsStatsHistory::kSampleCount,
+                         flecs_stats.offset(),
+                         nullptr,
+                         0.F,
+                         FLT_MAX,
+                         ImVec2{0.F, kPlotHeight});
+    }};
+
+    // Appends to the window opened by draw_dev_panel_system
+    ImGui::Begin("Dev Panel");
+    ImGui::SeparatorText("flecs");
+    ImGui::Text( // NOLINT [cppcoreguidelines-pro-type-vararg]
+        "%s",
+        fmt::format("{} entities, {} tables ({} empty)",
+                    flecs_stats.entities(),
+                    flecs_stats.tables(),
+                    flecs_stats.empty_tables())
+            .c_str());
+    plot("Entities", flecs_stats.entity_samples());
+    plot("Tables", flecs_stats.table_samples());
+    plot("Entities per table", flecs_stats.entities_per_table_samples());
+
+    if (ImGui::TreeNode("Query matches"))
+    {
+        for (const QueryMatchHistory &query : flecs_stats.queries())
+        {
+            const std::string label{fmt::format("{}: {} entities, {} tables",
+                                                query._name,
+                                                query._entities,
+                                                query._tables)};
+            plot(label.c_str(), query._entity_samples.data());
+        }
+        ImGui::TreePop();
+    }
+    ImGui::End();
+}
+
+void select_sphere_lod_system(
+    const flecs::query<const Position, const SphereMesh, SphereLod>
+        &select_sphere_lod_query,
+    const Camera3D &camera,
+    const float viewport_height,
+    SphereLodView &sphere_lod_view)
+{
+    // While the view is unchanged only tables whose spheres moved or resized
+    // need new levels. The first changed() call also turns on the per table
+    // change tracking iter.changed() relies on.
+    const bool view_changed{sphere_lod_view.update(camera, viewport_height)};
+    if (!select_sphere_lod_query.changed() && !view_changed)
+    {
+        return;
+    }
+
+    const float screen_scale{sphere_lod_screen_scale(camera, viewport_height)};
+    select_sphere_lod_query.iter([&camera, screen_scale, view_changed](
+                                     flecs::iter &iter,
+                                     const Position *position,
+                                     const SphereMesh *sphere_mesh,
+                                     SphereLod *sphere_lod) {
+        // leave SphereLod unmarked unless a level actually changes, so
+        // drawing does not see a change
+        const std::size_t first_change{
+            view_changed || iter.changed()
+                ? first_sphere_lod_change(camera,
+                                          screen_scale,
+                                          position,
+                                          sphere_mesh,
+                                          sphere_lod,
+                                          iter.count())
+                : iter.count()};
+        if (first_change == iter.count())
+        {
+            iter.skip();
+            return;
+        }
+        select_sphere_lods(camera,
+                           screen_scale,
+                           position + first_change,
+                           sphere_mesh + first_change,
+                           sphere_lod + first_change,
+                           iter.count() - first_change);
     });
 }
 
 void draw_sphere_system(
     const flecs::query<const Position,
                        const SphereMesh,
-                       const DevPanelState //const CameraComponent
-                       > &draw_sphere_query)
+                       const SphereLod,
+                       const RigidBodyTransform *,
+                       const DevPanelState> &draw_sphere_query,
+    SphereLodRenderer &sphere_lod_renderer,
+    const Camera3D &camera)
 {
-    draw_sphere_query.each([](const Position &position,
-                              const SphereMesh &sphere_mesh,
-                              const DevPanelState &dev_panel_state) {
+    sphere_lod_renderer.begin_frame();
+    draw_sphere_query.each([&sphere_lod_renderer, &camera](
+                               const Position &position,
+                               const SphereMesh &sphere_mesh,
+                               const SphereLod &sphere_lod,
+                               const RigidBodyTransform *transform,
+                               const DevPanelState &dev_panel_state) {
         const size_t selected_colour_index{
             static_cast<size_t>(dev_panel_state._selected_sphere_colour)};
         const Color sphere_colour{
             constants::kSphereColours[selected_colour_index]};
-        DrawSphere(position._centre, sphere_mesh._radius, sphere_colour);
+        const Quaternion rotation{transform != nullptr
+                                      ? transform->_rotation
+                                      : Quaternion{0.F, 0.F, 0.F, 1.F}};
+        sphere_lod_renderer.draw(camera,
+                                 position,
+                                 rotation,
+                                 sphere_mesh,
+                                 sphere_lod,
+                                 sphere_colour);
     });
+    sphere_lod_renderer.end_frame();
 }
 
 void spawn_camera_system(const flecs::world &world, Camera3D *camera)
@@ -217,11 +936,18 @@ void spawn_camera_system(const flecs::world &world, Camera3D *camera)
 void spawn_sphere_system(const flecs::world &world)
 {
     constexpr float kSphereInitialPositionY{10.F};
+    const Position position{Vector3{0.F, kSphereInitialPositionY, 0.F}};
+    const Velocity velocity{Vector3{0.5F, 0.F, 0.F}};
     world.entity()
-        .set<Position>(Position{Vector3{0.F, kSphereInitialPositionY, 0.F}})
+        .set<Position>(position)
         .set<SphereMesh>({constants::kSphereColours[0], 0.5F})
+        .add<SphereLod>()
         .set<SphereCollider>(SphereCollider{0.5F})
-        .set<Velocity>(Velocity{Vector3{0.5F, 0.F, 0.F}});
+        .set<Velocity>(velocity)
+        .set<RigidBodyTransform>(make_rigid_body_transform(position, velocity))
+        .set<SpatialQuery>(SpatialQuery{SpatialQueryType::kRaycast,
+                                        constants::kGroundProbeRange})
+        .add<SpatialQueryHits>();
 }
 
 void spawn_floor_system(const flecs::world &world)
@@ -232,6 +958,49 @@ void spawn_floor_system(const flecs::world &world)
         .set<BoxCollider>(BoxCollider{Vector3{5.F, 1.F, 5.F}});
 }
 
+void spawn_particle_emitter_system(const flecs::world &world)
+{
+    constexpr float kEmitterHeight{0.5F};
+    world.entity()
+        .set<Position>(Position{Vector3{0.F, kEmitterHeight, 0.F}})
+        .set<ParticleEmitter>(ParticleEmitter{});
+}
+
+void emit_particles_system(
+    const flecs::query<const Position, ParticleEmitter> &emitter_query,
+    const float frame_time,
+    ParticleSystem &particles)
+{
+    constexpr float kTwoPi{2.F * PI};
+    emitter_query.each([frame_time, &particles](const Position &position,
+                                                ParticleEmitter &emitter) {
+        emitter._owed += emitter._rate * frame_time;
+        const float whole{std::floor(emitter._owed)};
+        emitter._owed -= whole;
+        for (auto remaining{static_cast<std::size_t>(whole)}; remaining > 0;
+             --remaining)
+        {
+            const float angle{kTwoPi * next_particle_random(emitter._seed)};
+            const float sideways{emitter._spread * emitter._speed *
+                                 next_particle_random(emitter._seed)};
+            const float lifetime{
+                emitter._lifetime *
+                (0.5F + 0.5F * next_particle_random(emitter._seed))};
+            if (!particles.emit(position._centre,
+                                Vector3{sideways * std::cos(angle),
+                                        emitter._speed,
+                                        sideways * std::sin(angle)},
+                                lifetime,
+                                emitter._colour))
+            {
+                // full, and the owed particles are dropped rather than
+                // bunched up for when there is room
+                return;
+            }
+        }
+    });
+}
+
 void update_sphere_system(
     const flecs::query<const SphereCollider, Position, Velocity, DevPanelState>
         &update_sphere_query,
@@ -261,17 +1030,506 @@ void update_sphere_system(
 void create_entity_colliders_system(const flecs::world &world,
                                     PhysicsEngine &physics_engine)
 {
-    world.each([&physics_engine](const BoxCollider &box_collider,
+    world.each([&physics_engine](flecs::entity entity,
+                                 const BoxCollider &box_collider,
                                  const Position &position) {
         physics_engine.create_floor(box_collider._half_extent,
-                                    position._centre);
+                                    position._centre,
+                                    entity.id());
     });
 
-    world.each([&physics_engine](const SphereCollider &sphere_collider,
+    world.each([&physics_engine](flecs::entity entity,
+                                 const SphereCollider &sphere_collider,
                                  const Position &position,
                                  const Velocity &velocity) {
-        physics_engine.create_ball(sphere_collider._radius,
-                                   position._centre,
-                                   velocity._value);
+        const JPH::BodyID body_id{
+            physics_engine.create_ball(sphere_collider._radius,
+                                       position._centre,
+                                       velocity._value,
+                                       entity.id())};
+        entity.set<PhysicsBody>(PhysicsBody{
+            body_id.GetIndexAndSequenceNumber(), ShapeType::kSphere});
+    });
+}
+
+flecs::entity spawn_ball_entity_system(const flecs::world &world,
+                                       const Vector3 &position,
+                                       const Vector3 &velocity)
+{
+    return world.entity()
+        .set<Position>(Position{position})
+        .set<SphereMesh>({constants::kSphereColours[0], constants::kBallRadius})
+        .add<SphereLod>()
+        .set<SphereCollider>(SphereCollider{constants::kBallRadius})
+        .set<Velocity>(Velocity{velocity})
+        .set<RigidBodyTransform>(make_rigid_body_transform(Position{position},
+                                                           Velocity{velocity}));
+}
+
+flecs::entity spawn_ball_system(const flecs::world &world,
+                                PhysicsEngine &physics_engine,
+                                const Vector3 &position,
+                                const Vector3 &velocity)
+{
+    const flecs::entity entity{
+        spawn_ball_entity_system(world, position, velocity)};
+    const JPH::BodyID body_id{physics_engine.spawn_ball(
+        constants::kBallRadius, position, velocity, entity.id())};
+    entity.set<PhysicsBody>(
+        PhysicsBody{body_id.GetIndexAndSequenceNumber(), ShapeType::kSphere});
+    return entity;
+}
+
+void despawn_ball_system(const flecs::entity &entity,
+                         PhysicsEngine &physics_engine,
+                         const bool recycle_body)
+{
+    const PhysicsBody *physics_body{entity.get<PhysicsBody>()};
+    if (physics_body != nullptr)
+    {
+        physics_engine.despawn_body(JPH::BodyID{physics_body->_body_id},
+                                    recycle_body);
+        // the body is gone already, so the collider observers have nothing
+        // left to destroy
+        entity.remove<PhysicsBody>();
+    }
+    entity.destruct();
+}
+
+void observe_colliders_system(const flecs::world &world,
+                              PhysicsCommandBuffer &physics_commands)
+{
+    const auto record_set{[&physics_commands](const flecs::entity &entity,
+                                              const ShapeType shape) {
+        const PhysicsBody *physics_body{entity.get<PhysicsBody>()};
+        if (physics_body == nullptr)
+        {
+            physics_commands.create(entity.id(), shape);
+            return;
+        }
+        // a body can't change between a sphere and a box, so it is replaced
+        if (physics_body->_shape != shape)
+        {
+            physics_commands.destroy(entity.id(), physics_body->_body_id);
+            physics_commands.create(entity.id(), shape);
+            return;
+        }
+        physics_commands.update(entity.id(), shape, physics_body->_body_id);
+    }};
+    // OnRemove runs before the collider goes, so a deleted entity still has
+    // its PhysicsBody here
+    const auto record_remove{
+        [&physics_commands](const flecs::entity &entity) {
+            const PhysicsBody *physics_body{entity.get<PhysicsBody>()};
+            physics_commands.destroy(entity.id(),
+                                     physics_body != nullptr
+                                         ? physics_body->_body_id
+                                         : kNoPhysicsBody);
+        }};
+
+    world.observer<const SphereCollider>()
+        .event(flecs::OnSet)
+        .each([record_set](flecs::entity entity,
+                           const SphereCollider & /* sphere_collider */) {
+            record_set(entity, ShapeType::kSphere);
+        });
+    world.observer<const BoxCollider>()
+        .event(flecs::OnSet)
+        .each([record_set](flecs::entity entity,
+                           const BoxCollider & /* box_collider */) {
+            record_set(entity, ShapeType::kBox);
+        });
+    // Parked entities are disabled, which observers skip unless they ask
+    // for it, and their bodies have to go too
+    world.observer<const SphereCollider>()
+        .with(flecs::Disabled)
+        .optional()
+        .event(flecs::OnRemove)
+        .each([record_remove](flecs::entity entity,
+                              const SphereCollider & /* sphere_collider */) {
+            record_remove(entity);
+        });
+    world.observer<const BoxCollider>()
+        .with(flecs::Disabled)
+        .optional()
+        .event(flecs::OnRemove)
+        .each([record_remove](flecs::entity entity,
+                              const BoxCollider & /* box_collider */) {
+            record_remove(entity);
+        });
+}
+
+void resolve_physics_commands_system(const flecs::world &world,
+                                     PhysicsCommandBuffer &physics_commands)
+{
+    // resolved commands are moved down over the dropped ones
+    std::vector<PhysicsCommand> &commands{physics_commands.commands()};
+    std::size_t resolved{0};
+    for (PhysicsCommand &command : commands)
+    {
+        if (command._type != PhysicsCommandType::kDestroy)
+        {
+            const flecs::entity entity{world.entity(command._entity)};
+            const Position *position{
+                entity.is_alive() ? entity.get<Position>() : nullptr};
+            const SphereCollider *sphere_collider{
+                position != nullptr ? entity.get<SphereCollider>() : nullptr};
+            const BoxCollider *box_collider{
+                position != nullptr ? entity.get<BoxCollider>() : nullptr};
+            if (command._shape == ShapeType::kSphere &&
+                sphere_collider != nullptr)
+            {
+                command._dimensions =
+                    Vector3{sphere_collider->_radius, 0.F, 0.F};
+            }
+            else if (command._shape == ShapeType::kBox &&
+                     box_collider != nullptr)
+            {
+                command._dimensions = box_collider->_half_extent;
+            }
+            else
+            {
+                continue;
+            }
+            const Velocity *velocity{entity.get<Velocity>()};
+            command._position = position->_centre;
+            command._velocity = velocity != nullptr ? velocity->_value
+                                                    : Vector3{0.F, 0.F, 0.F};
+        }
+        commands[resolved] = command;
+        ++resolved;
+    }
+    commands.resize(resolved);
+}
+
+void write_physics_bodies_system(const flecs::world &world,
+                                 PhysicsCommandBuffer &physics_commands)
+{
+    // destroys go first: an entity whose collider was replaced has both a
+    // destroy of its old body and a create of its new one, in either order
+    for (const PhysicsCommand &command : physics_commands.commands())
+    {
+        const flecs::entity entity{world.entity(command._entity)};
+        if (command._type == PhysicsCommandType::kDestroy && entity.is_alive())
+        {
+            // only the collider was removed, the entity lives on
+            entity.remove<PhysicsBody>();
+        }
+    }
+    for (const PhysicsCommand &command : physics_commands.commands())
+    {
+        const flecs::entity entity{world.entity(command._entity)};
+        if (command._type == PhysicsCommandType::kCreate &&
+            command._body_id != kNoPhysicsBody && entity.is_alive())
+        {
+            entity.set<PhysicsBody>(
+                PhysicsBody{command._body_id, command._shape});
+        }
+    }
+    physics_commands.clear();
+}
+
+// Bodies brought back by one unpark_entities and the time it spent on them
+struct PartitionLoadCost
+{
+    std::size_t _bodies{0};
+    double _milliseconds{0.0};
+};
+
+// Enable parked entities again and add their bodies back in one batch
+PartitionLoadCost unpark_entities(const flecs::world &world,
+                                  const std::vector<std::uint64_t> &entities,
+                                  PhysicsThread &physics_thread)
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point enable_start{Clock::now()};
+    std::vector<std::uint32_t> body_ids;
+    body_ids.reserve(entities.size());
+    for (const std::uint64_t id : entities)
+    {
+        const flecs::entity entity{world.entity(id)};
+        if (!entity.is_alive())
+        {
+            continue;
+        }
+        entity.enable();
+        const PhysicsBody *physics_body{entity.get<PhysicsBody>()};
+        if (physics_body != nullptr)
+        {
+            body_ids.push_back(physics_body->_body_id);
+        }
+    }
+    Clock::duration work{Clock::now() - enable_start};
+    if (!body_ids.empty())
+    {
+        physics_thread.with_engine([&body_ids, &work](PhysicsEngine &engine) {
+            // timed inside the lock, so waiting for a step to finish does
+            // not count towards the cost of the bodies
+            const Clock::time_point unpark_start{Clock::now()};
+            engine.unpark_bodies(body_ids);
+            work += Clock::now() - unpark_start;
+        });
+    }
+    return PartitionLoadCost{
+        body_ids.size(),
+        std::chrono::duration<double, std::milli>{work}.count()};
+}
+
+// Disable the entities in cells the partition no longer wants, and take
+// their bodies out of the broadphase in one batch
+void park_far_entities(
+    const flecs::query<const Position,
+                       const PhysicsBody,
+                       const SphereCollider *,
+                       const BoxCollider *> &partition_query,
+    const float cell_size,
+    WorldPartition &world_partition,
+    PhysicsThread &physics_thread)
+{
+    std::vector<std::pair<flecs::entity, PartitionCell>> parked;
+    std::vector<std::uint32_t> body_ids;
+    partition_query.each([&](flecs::entity entity,
+                             const Position &position,
+                             const PhysicsBody &physics_body,
+                             const SphereCollider *sphere_collider,
+                             const BoxCollider *box_collider) {
+        // bodies wider than a cell, like the floor, are always loaded
+        float extent{0.F};
+        if (sphere_collider != nullptr)
+        {
+            extent = sphere_collider->_radius;
+        }
+        else if (box_collider != nullptr)
+        {
+            const Vector3 &half_extent{box_collider->_half_extent};
+            extent = std::max({half_extent.x, half_extent.y, half_extent.z});
+        }
+        if (2.F * extent > cell_size)
+        {
+            return;
+        }
+        const PartitionCell cell{
+            partition_cell_of(position._centre, cell_size)};
+        if (world_partition.is_wanted(cell))
+        {
+            return;
+        }
+        parked.emplace_back(entity, cell);
+        body_ids.push_back(physics_body._body_id);
+    });
+
+    // disabling is a structural change, so it waits until the query is done
+    for (const auto &[entity, cell] : parked)
+    {
+        entity.disable();
+        world_partition.park(cell, entity.id());
+    }
+    if (!body_ids.empty())
+    {
+        physics_thread.with_engine([&body_ids](PhysicsEngine &engine) {
+            engine.park_bodies(body_ids);
+        });
+    }
+}
+
+void unpark_world_partition_system(const flecs::world &world,
+                                   WorldPartition &world_partition,
+                                   PhysicsThread &physics_thread)
+{
+    if (!world_partition.active())
+    {
+        return;
+    }
+    std::vector<std::uint64_t> entities;
+    world_partition.reset(entities);
+    unpark_entities(world, entities, physics_thread);
+}
+
+void stream_world_partition_system(
+    const flecs::world &world,
+    const flecs::query<const Position,
+                       const PhysicsBody,
+                       const SphereCollider *,
+                       const BoxCollider *> &partition_query,
+    const Vector3 &camera_position,
+    const WorldPartitionSettings &settings,
+    WorldPartition &world_partition,
+    PhysicsThread &physics_thread)
+{
+    if (!settings._enabled)
+    {
+        unpark_world_partition_system(world, world_partition, physics_thread);
+        return;
+    }
+
+    const PartitionCell centre{
+        partition_cell_of(camera_position, settings._cell_size)};
+    if (world_partition.update_centre(
+            centre, settings._load_radius, settings._unload_radius))
+    {
+        park_far_entities(partition_query,
+                          settings._cell_size,
+                          world_partition,
+                          physics_thread);
+    }
+
+    // Bring queued cells in nearest first, while the estimated cost of
+    // adding their bodies fits the budget. Each cell is checked before it
+    // loads, so one large cell cannot blow the budget. The first cell with
+    // anything in it always loads, so loading cannot stall.
+    const auto budget{static_cast<double>(settings._load_budget_milliseconds)};
+    std::vector<std::uint64_t> entities;
+    while (world_partition.queued_cell_count() > 0)
+    {
+        const double estimate{world_partition.estimated_load_milliseconds(
+            entities.size() + world_partition.next_load_size())};
+        if (!entities.empty() && estimate > budget)
+        {
+            break;
+        }
+        world_partition.load_next(entities);
+    }
+    if (entities.empty())
+    {
+        return;
+    }
+    const PartitionLoadCost cost{
+        unpark_entities(world, entities, physics_thread)};
+    world_partition.record_load_cost(cost._bodies, cost._milliseconds);
+}
+
+void apply_transform_snapshot_system(const flecs::world &world,
+                                     const TransformSnapshot &snapshot,
+                                     SnapshotSyncStats &sync_stats)
+{
+    // Only bodies Jolt moved since the last applied snapshot are written, so
+    // tables of resting spheres are not marked changed and the queries
+    // downstream can skip them
+    sync_stats._bodies = snapshot._transforms.size();
+    sync_stats._moved_bodies = 0;
+    for (const BodyTransform &transform : snapshot._transforms)
+    {
+        if (transform._moved_step <= sync_stats._applied_step)
+        {
+            continue;
+        }
+        const flecs::entity entity{world.entity(transform._entity)};
+        if (!entity.is_alive())
+        {
+            continue;
+        }
+        entity.set<Position>(position_of(transform._transform));
+        entity.set<Velocity>(velocity_of(transform._transform));
+        if (entity.has<RigidBodyTransform>())
+        {
+            entity.set<RigidBodyTransform>(transform._transform);
+        }
+        ++sync_stats._moved_bodies;
+    }
+    sync_stats._applied_step = snapshot._step;
+}
+
+void collect_spatial_queries_system(
+    const flecs::query<const Position,
+                       const SpatialQuery,
+                       const PhysicsBody *,
+                       SpatialQueryHits> &spatial_query_query,
+    SpatialQueryBatch &batch)
+{
+    batch.clear();
+    spatial_query_query.each([&batch](flecs::entity entity,
+                                      const Position &position,
+                                      const SpatialQuery &spatial_query,
+                                      const PhysicsBody *physics_body,
+                                      SpatialQueryHits & /* hits */) {
+        SpatialQueryRequest request{};
+        request._entity = entity.id();
+        request._origin = position._centre;
+        request._query = spatial_query;
+        if (physics_body != nullptr)
+        {
+            request._ignore_body_id = physics_body->_body_id;
+        }
+        batch.add(request);
+    });
+}
+
+void write_spatial_query_results_system(
+    const flecs::world &world,
+    const std::vector<SpatialQueryResult> &results)
+{
+    for (const SpatialQueryResult &result : results)
+    {
+        // the entity may have gone, or stopped asking, since it was queried
+        const flecs::entity entity{world.entity(result._entity)};
+        if (!entity.is_alive())
+        {
+            continue;
+        }
+        SpatialQueryHits *hits{entity.get_mut<SpatialQueryHits>()};
+        if (hits != nullptr)
+        {
+            *hits = result._hits;
+        }
+    }
+}
+
+void track_history_system(const flecs::world &world,
+                          const flecs::query<History> &history_query,
+                          const DevPanelState &dev_panel_state)
+{
+    const std::uint64_t inspected{
+        dev_panel_state._record_history ? dev_panel_state._inspected_entity
+                                        : 0};
+
+    // entities can't lose components while the query is iterating them
+    std::vector<flecs::entity> stale{};
+    history_query.each([inspected, &stale](flecs::entity entity,
+                                           History & /* history */) {
+        if (entity.id() != inspected)
+        {
+            stale.push_back(entity);
+        }
+    });
+    for (flecs::entity &entity : stale)
+    {
+        entity.remove<History>();
+    }
+
+    if (inspected == 0)
+    {
+        return;
+    }
+    const flecs::entity entity{world.entity(inspected)};
+    if (entity.is_alive() && entity.has<Position>() &&
+        entity.has<Velocity>() && !entity.has<History>())
+    {
+        entity.add<History>();
+    }
+}
+
+void record_history_system(
+    const flecs::query<const Position, const Velocity, History>
+        &record_history_query)
+{
+    record_history_query.each([](const Position &position,
+                                 const Velocity &velocity,
+                                 History &history) {
+        const std::array<float, kHistoryFieldCount> values{
+            position._centre.x,
+            position._centre.y,
+            position._centre.z,
+            velocity._value.x,
+            velocity._value.y,
+            velocity._value.z,
+            Vector3Length(velocity._value)};
+        for (std::size_t field{0}; field < kHistoryFieldCount; ++field)
+        {
+            if ((history._fields &
+                 history_field_bit(static_cast<HistoryField>(field))) != 0)
+            {
+                history._rings[field].push(values[field]);
+            }
+        }
     });
 }
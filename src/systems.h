@@ -2,27 +2,103 @@
 #define SRC_SYSTEMS_H
 
 #include "components.h"
+#include "debug_draw.h"
+#include "flecs_stats.h"
+#include "memory_stats.h"
+#include "particles.h"
 #include "physics.h"
+#include "physics_commands.h"
+#include "physics_thread.h"
+#include "profiler.h"
+#include "spatial_query.h"
+#include "sphere_lod.h"
+#include "sphere_lod_renderer.h"
+#include "static_geometry_renderer.h"
+#include "tick_scheduler.h"
+#include "transform_snapshot.h"
+#include "viewport.h"
+#include "world_partition.h"
 
 #include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/entity.hpp>
 #include <flecs/addons/cpp/flecs.hpp>
 #include <flecs/addons/cpp/mixins/query/impl.hpp>
 #include <flecs/addons/cpp/world.hpp>
 #include <raylib.h>
 
-void draw_grid_system(
-    const flecs::query<const Position, const GridComponent> &draw_grid_query);
+#include <vector>
+
+// Rebuilds the static geometry mesh from grids and box colliders, only when
+// one of them was added, removed or changed
+void bake_static_geometry_system(
+    const flecs::query<const Position, const GridComponent> &static_grid_query,
+    const flecs::query<const Position, const BoxCollider>
+        &static_collider_query,
+    StaticGeometryRenderer &static_geometry_renderer);
+void draw_static_geometry_system(
+    const StaticGeometryRenderer &static_geometry_renderer);
 void draw_scene_text_system(const Font &font);
+// The same text drawn by ImGui over the debug view's image, whose top left
+// corner is at origin, so the kept scene texture is not drawn to every frame
+void draw_scene_text_overlay_system(const Vector2 &origin);
 void draw_dev_panel_system(
     const flecs::
         query<const Position, const Velocity, const SphereMesh, DevPanelState>
-            &draw_dev_panel_query);
+            &draw_dev_panel_query,
+    const TransformSnapshot &physics_snapshot,
+    const SnapshotSyncStats &sync_stats);
+// Submits the collected physics debug geometry through rlgl's batch. Call
+// between BeginMode3D and EndMode3D.
+void draw_physics_debug_system(const DebugVertexCollector &physics_debug);
+void draw_physics_debug_panel_system(const DebugVertexCollector &physics_debug,
+                                     bool available,
+                                     DebugDrawSettings &settings);
+// Submits the particles as velocity streaks through rlgl's batch. Call
+// between BeginMode3D and EndMode3D.
+void draw_particles_system(const ParticleSystem &particles,
+                           const ParticleSettings &settings);
+void draw_particles_panel_system(ParticleSystem &particles,
+                                 ParticleSettings &settings);
+void draw_world_partition_panel_system(const WorldPartition &world_partition,
+                                       WorldPartitionSettings &settings);
+void draw_viewport_panel_system(const ViewportDirtyTracker &viewport_tracker,
+                                const SphereLodStats &sphere_lod_stats,
+                                DevPanelState &dev_panel_state);
+void pick_entity_system(PhysicsThread &physics_thread,
+                        const Camera3D &camera,
+                        const Vector2 &viewport_point,
+                        float aspect_ratio,
+                        DevPanelState &dev_panel_state);
+void draw_memory_panel_system(const MemoryStats &memory_stats,
+                              const MemoryHistory &memory_history);
+void draw_profiler_panel_system(const FrameProfiler &profiler);
+// Measured rate and cost of each tick source, against the rate asked for
+void draw_tick_scheduler_panel_system(const TickScheduler &tick_scheduler);
+void draw_flecs_stats_panel_system(const FlecsStatsHistory &flecs_stats);
+void select_sphere_lod_system(
+    const flecs::query<const Position, const SphereMesh, SphereLod>
+        &select_sphere_lod_query,
+    const Camera3D &camera,
+    float viewport_height,
+    SphereLodView &sphere_lod_view);
 void draw_sphere_system(
-    const flecs::query<const Position, const SphereMesh, const DevPanelState>
-        &draw_sphere_query);
+    const flecs::query<const Position,
+                       const SphereMesh,
+                       const SphereLod,
+                       const RigidBodyTransform *,
+                       const DevPanelState> &draw_sphere_query,
+    SphereLodRenderer &sphere_lod_renderer,
+    const Camera3D &camera);
 
 void spawn_sphere_system(const flecs::world &world);
 void spawn_floor_system(const flecs::world &world);
+void spawn_particle_emitter_system(const flecs::world &world);
+// Particles owed by each emitter since the last frame. Stops adding once
+// ParticleSystem is full.
+void emit_particles_system(
+    const flecs::query<const Position, ParticleEmitter> &emitter_query,
+    float frame_time,
+    ParticleSystem &particles);
 
 void update_sphere_system(
     const flecs::query<const SphereCollider, Position, Velocity, DevPanelState>
@@ -31,5 +107,74 @@ void update_sphere_system(
     PhysicsEngine &physics_engine);
 void create_entity_colliders_system(const flecs::world &world,
                                     PhysicsEngine &physics_engine);
+// A ball entity without a body, for the collider observers to pick up
+flecs::entity spawn_ball_entity_system(const flecs::world &world,
+                                       const Vector3 &position,
+                                       const Vector3 &velocity);
+flecs::entity spawn_ball_system(const flecs::world &world,
+                                PhysicsEngine &physics_engine,
+                                const Vector3 &position,
+                                const Vector3 &velocity);
+void despawn_ball_system(const flecs::entity &entity,
+                         PhysicsEngine &physics_engine,
+                         bool recycle_body);
+// Colliders set or removed once the simulation runs are recorded into
+// physics_commands by flecs observers, which live as long as the world, so
+// physics_commands has to outlive it too. Each frame the commands are
+// resolved against their entities, applied with
+// PhysicsEngine::apply_body_commands, then the new bodies are written back.
+void observe_colliders_system(const flecs::world &world,
+                              PhysicsCommandBuffer &physics_commands);
+// Fill in each create and update from its entity, dropping commands whose
+// entity or collider has gone since
+void resolve_physics_commands_system(const flecs::world &world,
+                                     PhysicsCommandBuffer &physics_commands);
+void write_physics_bodies_system(const flecs::world &world,
+                                 PhysicsCommandBuffer &physics_commands);
+// Spatial queries are answered in one batch per frame: collect every
+// entity's SpatialQuery, hand the batch to PhysicsThread, then write the
+// answers that come back with a snapshot to the entities that asked.
+void collect_spatial_queries_system(
+    const flecs::query<const Position,
+                       const SpatialQuery,
+                       const PhysicsBody *,
+                       SpatialQueryHits> &spatial_query_query,
+    SpatialQueryBatch &batch);
+void write_spatial_query_results_system(
+    const flecs::world &world,
+    const std::vector<SpatialQueryResult> &results);
+// Keep the cells around the camera loaded. Entities in cells past the
+// unload radius are disabled and their bodies parked outside the broadphase;
+// cells coming into the load radius are brought back nearest first, within
+// the per frame load budget. Entities wider than a cell are never parked.
+// Turning streaming off brings everything back at once.
+void stream_world_partition_system(
+    const flecs::world &world,
+    const flecs::query<const Position,
+                       const PhysicsBody,
+                       const SphereCollider *,
+                       const BoxCollider *> &partition_query,
+    const Vector3 &camera_position,
+    const WorldPartitionSettings &settings,
+    WorldPartition &world_partition,
+    PhysicsThread &physics_thread);
+// Bring every parked entity back and forget the loaded cells, as if
+// streaming had just been turned on. Call outside
+// PhysicsThread::with_engine, which this takes.
+void unpark_world_partition_system(const flecs::world &world,
+                                   WorldPartition &world_partition,
+                                   PhysicsThread &physics_thread);
+void apply_transform_snapshot_system(const flecs::world &world,
+                                     const TransformSnapshot &snapshot,
+                                     SnapshotSyncStats &sync_stats);
+// Give the inspected entity a History while recording is on, and take it
+// away from every other entity
+void track_history_system(const flecs::world &world,
+                          const flecs::query<History> &history_query,
+                          const DevPanelState &dev_panel_state);
+// Append one sample to every History, call once per snapshot applied
+void record_history_system(
+    const flecs::query<const Position, const Velocity, History>
+        &record_history_query);
 
 #endif
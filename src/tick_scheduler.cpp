@@ -0,0 +1,96 @@
+#include "tick_scheduler.h"
+
+#include "constants.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/entity.hpp>
+#include <flecs/addons/cpp/world.hpp>
+
+#include <chrono>
+#include <cstddef>
+
+TickScheduler::TickScheduler(const flecs::world &world)
+{
+    const auto gameplay{static_cast<std::size_t>(TickSource::kGameplay)};
+    const auto telemetry{static_cast<std::size_t>(TickSource::kTelemetry)};
+
+    _sources[gameplay] = world.timer("Gameplay tick")
+                             .interval(1.F / static_cast<float>(
+                                                 constants::kGameplayTickrate));
+    // every nth gameplay tick, rather than a timer of its own
+    _sources[telemetry] = world.timer("Telemetry tick")
+                              .rate(constants::kGameplayTickrate /
+                                        constants::kTelemetryTickrate,
+                                    _sources[gameplay]);
+
+    _stats[gameplay]._rate = static_cast<float>(constants::kGameplayTickrate);
+    _stats[telemetry]._rate =
+        static_cast<float>(constants::kTelemetryTickrate);
+}
+
+void TickScheduler::advance(const flecs::world &world, const float delta_time)
+{
+    // progress only runs flecs' own systems here, the timers among them
+    world.progress(delta_time);
+
+    for (std::size_t source{0}; source < kTickSourceCount; ++source)
+    {
+        const flecs::TickSource *tick_source{
+            _sources[source].get<flecs::TickSource>()};
+        _ticked[source] = tick_source != nullptr && tick_source->tick;
+        if (_ticked[source])
+        {
+            ++_window_ticks[source];
+            ++_stats[source]._ticks;
+        }
+    }
+
+    _window_seconds += delta_time;
+    if (_window_seconds < constants::kTickLoadWindowSeconds)
+    {
+        return;
+    }
+    for (std::size_t source{0}; source < kTickSourceCount; ++source)
+    {
+        TickSourceStats &stats{_stats[source]};
+        const auto ticks{static_cast<float>(_window_ticks[source])};
+        stats._measured_rate = ticks / _window_seconds;
+        stats._milliseconds_per_tick =
+            ticks > 0.F ? _window_milliseconds[source] / ticks : 0.F;
+        stats._load = _window_milliseconds[source] / _window_seconds;
+    }
+    _window_seconds = 0.F;
+    _window_ticks.fill(0);
+    _window_milliseconds.fill(0.F);
+}
+
+void TickScheduler::record_work(const TickSource source,
+                                const float milliseconds)
+{
+    _window_milliseconds[static_cast<std::size_t>(source)] += milliseconds;
+}
+
+bool TickScheduler::ticked(const TickSource source) const
+{
+    return _ticked[static_cast<std::size_t>(source)];
+}
+
+const TickSourceStats &TickScheduler::stats(const TickSource source) const
+{
+    return _stats[static_cast<std::size_t>(source)];
+}
+
+ScopedTickWork::ScopedTickWork(TickScheduler &scheduler,
+                               const TickSource source)
+    : _scheduler(scheduler), _source(source),
+      _start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedTickWork::~ScopedTickWork()
+{
+    _scheduler.record_work(_source,
+                           std::chrono::duration<float, std::milli>{
+                               std::chrono::steady_clock::now() - _start}
+                               .count());
+}
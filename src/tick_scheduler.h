@@ -0,0 +1,87 @@
+#ifndef SRC_TICK_SCHEDULER_H
+#define SRC_TICK_SCHEDULER_H
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/entity.hpp>
+#include <flecs/addons/cpp/world.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Work in the main loop that runs at its own rate rather than every frame.
+// Physics is not here, it steps on its own thread, see PhysicsThread.
+enum class TickSource : std::uint8_t
+{
+    kGameplay,  // input and game state, constants::kGameplayTickrate
+    kTelemetry, // memory and flecs statistics, constants::kTelemetryTickrate
+    kCount,
+};
+
+inline constexpr std::size_t kTickSourceCount{
+    static_cast<std::size_t>(TickSource::kCount)};
+inline constexpr std::array<const char *, kTickSourceCount> kTickSourceLabels{
+    "Gameplay",
+    "Telemetry"};
+
+// Over the last complete constants::kTickLoadWindowSeconds
+struct TickSourceStats
+{
+    float _rate{0.F};          // ticks per second asked for
+    float _measured_rate{0.F}; // ticks per second seen
+    float _milliseconds_per_tick{0.F};
+    float _load{0.F}; // milliseconds of work per second of wall time
+    std::uint64_t _ticks{0}; // since the scheduler was made
+};
+
+// Named flecs tick sources, one per TickSource: an interval timer for
+// gameplay, and a rate filter over it for telemetry, so the two never drift
+// apart. flecs timers keep the remainder when they fire, so time is not lost
+// to frames that overshoot a tick. A source ticks at most once per frame.
+// Callers check ticked after advance and report how long the work took, so
+// the Dev Panel can show what each rate costs.
+class TickScheduler
+{
+public:
+    explicit TickScheduler(const flecs::world &world);
+
+    // mutator methods
+    // Run the world's timers on by delta_time seconds. Call once per frame.
+    void advance(const flecs::world &world, float delta_time);
+    void record_work(TickSource source, float milliseconds);
+
+    // accessor methods
+    [[nodiscard]] bool ticked(TickSource source) const;
+    [[nodiscard]] const TickSourceStats &stats(TickSource source) const;
+
+private:
+    std::array<flecs::entity, kTickSourceCount> _sources{};
+    std::array<bool, kTickSourceCount> _ticked{};
+    std::array<TickSourceStats, kTickSourceCount> _stats{};
+
+    // the window being measured
+    float _window_seconds{0.F};
+    std::array<std::uint32_t, kTickSourceCount> _window_ticks{};
+    std::array<float, kTickSourceCount> _window_milliseconds{};
+};
+
+// Records the time between construction and destruction as work done for
+// one tick of source
+class ScopedTickWork
+{
+public:
+    ScopedTickWork(TickScheduler &scheduler, TickSource source);
+    ~ScopedTickWork();
+    ScopedTickWork(const ScopedTickWork &) = delete;
+    ScopedTickWork &operator=(const ScopedTickWork &) = delete;
+    ScopedTickWork(ScopedTickWork &&) = delete;
+    ScopedTickWork &operator=(ScopedTickWork &&) = delete;
+
+private:
+    TickScheduler &_scheduler;
+    TickSource _source;
+    std::chrono::steady_clock::time_point _start;
+};
+
+#endif
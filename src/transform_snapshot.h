@@ -0,0 +1,39 @@
+#ifndef SRC_TRANSFORM_SNAPSHOT_H
+#define SRC_TRANSFORM_SNAPSHOT_H
+
+#include "components.h"
+#include "spatial_query.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct BodyTransform
+{
+    std::uint64_t _entity{0};
+    std::uint64_t _moved_step{0}; // last step the body moved in
+    RigidBodyTransform _transform{};
+};
+
+// State of every dynamic body at the end of one physics step. Written by the
+// physics thread and only ever read by the render thread once published.
+struct TransformSnapshot
+{
+    std::uint64_t _step{0};
+    float _step_milliseconds{0.F};
+    std::vector<BodyTransform> _transforms;
+    // answers to the latest submitted batch of spatial queries, as of _step
+    std::vector<SpatialQueryResult> _spatial_query_results;
+};
+
+// What applying snapshots wrote back to flecs. Snapshots can be dropped
+// when the render thread falls behind, so bodies are compared against the
+// last applied step rather than the previous snapshot.
+struct SnapshotSyncStats
+{
+    std::uint64_t _applied_step{0};
+    std::size_t _bodies{0};
+    std::size_t _moved_bodies{0};
+};
+
+#endif
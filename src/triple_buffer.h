@@ -0,0 +1,63 @@
+#ifndef SRC_TRIPLE_BUFFER_H
+#define SRC_TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer triple buffer. The producer always owns one
+// buffer to write into and the consumer one to read from; the third sits in
+// the shared slot. Publishing and acquiring swap a buffer with the shared slot
+// using a single atomic exchange, so neither side ever blocks the other.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    // producer methods
+    T &write_buffer()
+    {
+        return _buffers[_write_index];
+    }
+
+    void publish()
+    {
+        const std::uint8_t previous{_shared.exchange(
+            static_cast<std::uint8_t>(_write_index | kFreshBit),
+            std::memory_order_acq_rel)};
+        _write_index = static_cast<std::uint8_t>(previous & kIndexMask);
+    }
+
+    // consumer methods
+
+    // Swap in the most recently published buffer, if there is one. Returns
+    // false and keeps the current read buffer when nothing new was published.
+    bool acquire()
+    {
+        if ((_shared.load(std::memory_order_relaxed) & kFreshBit) == 0)
+        {
+            return false;
+        }
+        const std::uint8_t previous{
+            _shared.exchange(_read_index, std::memory_order_acq_rel)};
+        _read_index = static_cast<std::uint8_t>(previous & kIndexMask);
+        return true;
+    }
+
+    [[nodiscard]] const T &read_buffer() const
+    {
+        return _buffers[_read_index];
+    }
+
+private:
+    static constexpr std::uint8_t kIndexMask{0x3};
+    static constexpr std::uint8_t kFreshBit{0x4};
+
+    std::array<T, 3> _buffers{};
+    std::uint8_t _write_index{0};
+    std::atomic<std::uint8_t> _shared{1};
+    std::uint8_t _read_index{2};
+};
+
+#endif
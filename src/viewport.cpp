@@ -0,0 +1,62 @@
+#include "viewport.h"
+
+#include "components.h"
+
+#include <raylib.h>
+
+#include <cstdint>
+
+namespace
+{
+bool vectors_equal(const Vector3 &first, const Vector3 &second)
+{
+    return first.x == second.x && first.y == second.y && first.z == second.z;
+}
+} // namespace
+
+bool cameras_equal(const Camera3D &first, const Camera3D &second)
+{
+    return vectors_equal(first.position, second.position) &&
+           vectors_equal(first.target, second.target) &&
+           vectors_equal(first.up, second.up) && first.fovy == second.fovy &&
+           first.projection == second.projection;
+}
+
+bool ViewportDirtyTracker::needs_redraw(const Camera3D &camera,
+                                        const bool scene_changed,
+                                        const DevPanelState &dev_panel_state)
+{
+    const bool unchanged{
+        _valid && !scene_changed && cameras_equal(_camera, camera) &&
+        _selected_sphere_colour == dev_panel_state._selected_sphere_colour &&
+        _paused == dev_panel_state._paused &&
+        _render_direct == dev_panel_state._render_direct};
+    if (unchanged)
+    {
+        ++_skipped_frames;
+        return false;
+    }
+
+    _valid = true;
+    _camera = camera;
+    _selected_sphere_colour = dev_panel_state._selected_sphere_colour;
+    _paused = dev_panel_state._paused;
+    _render_direct = dev_panel_state._render_direct;
+    ++_rendered_frames;
+    return true;
+}
+
+void ViewportDirtyTracker::invalidate()
+{
+    _valid = false;
+}
+
+std::uint64_t ViewportDirtyTracker::rendered_frames() const
+{
+    return _rendered_frames;
+}
+
+std::uint64_t ViewportDirtyTracker::skipped_frames() const
+{
+    return _skipped_frames;
+}
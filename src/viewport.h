@@ -0,0 +1,49 @@
+#ifndef SRC_VIEWPORT_H
+#define SRC_VIEWPORT_H
+
+#include "components.h"
+
+#include <raylib.h>
+
+#include <cstdint>
+
+// Exact comparison, any camera movement at all counts as a change
+[[nodiscard]] bool cameras_equal(const Camera3D &first, const Camera3D &second);
+
+// Tracks the inputs of the debug viewport's offscreen passes, so they can be
+// skipped while the camera, the drawn components and the Dev Panel state are
+// all unchanged. A skipped frame makes no offscreen pass at all: the scene
+// textures keep their previous contents and the scene text, which changes
+// every frame, is drawn by ImGui over the image instead.
+class ViewportDirtyTracker
+{
+public:
+    ViewportDirtyTracker() = default;
+
+    // mutator methods
+
+    // Returns true and records the new inputs when the viewport needs
+    // rendering again, otherwise counts the frame as skipped.
+    bool needs_redraw(const Camera3D &camera,
+                      bool scene_changed,
+                      const DevPanelState &dev_panel_state);
+
+    // Force the next frame to redraw, e.g. because the textures were not
+    // rendered to while the debug view was closed.
+    void invalidate();
+
+    // accessor methods
+    [[nodiscard]] std::uint64_t rendered_frames() const;
+    [[nodiscard]] std::uint64_t skipped_frames() const;
+
+private:
+    bool _valid{false};
+    Camera3D _camera{};
+    int _selected_sphere_colour{0};
+    bool _paused{false};
+    bool _render_direct{false};
+    std::uint64_t _rendered_frames{0};
+    std::uint64_t _skipped_frames{0};
+};
+
+#endif
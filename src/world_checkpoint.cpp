@@ -0,0 +1,413 @@
+#include "world_checkpoint.h"
+
+#include "components.h"
+#include "physics.h"
+#include "systems.h"
+#include "transform_snapshot.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/entity.hpp>
+#include <flecs/addons/cpp/flecs.hpp>
+#include <flecs/addons/cpp/world.hpp>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <ratio>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr std::uint32_t kCheckpointMagic{0x504B4357}; // "WCKP"
+constexpr std::uint32_t kCheckpointVersion{3};
+constexpr std::size_t kSectionAlignment{16};
+
+// CheckpointEntity::_components bits
+constexpr std::uint32_t kHasPosition{1U << 0U};
+constexpr std::uint32_t kHasVelocity{1U << 1U};
+constexpr std::uint32_t kHasSphereMesh{1U << 2U};
+constexpr std::uint32_t kHasSphereCollider{1U << 3U};
+constexpr std::uint32_t kHasBoxCollider{1U << 4U};
+constexpr std::uint32_t kHasGrid{1U << 5U};
+constexpr std::uint32_t kHasSphereLod{1U << 6U};
+constexpr std::uint32_t kHasRigidBodyTransform{1U << 7U};
+constexpr std::uint32_t kHasPhysicsBody{1U << 8U};
+constexpr std::uint32_t kHasSpatialQuery{1U << 9U};
+
+static_assert(std::is_trivially_copyable_v<CheckpointEntity> &&
+                  std::is_trivially_copyable_v<CheckpointBody>,
+              "Checkpoint records are copied to and from files as bytes");
+
+struct CheckpointFileHeader
+{
+    std::uint32_t _magic{kCheckpointMagic};
+    std::uint32_t _version{kCheckpointVersion};
+    std::uint32_t _entity_record_bytes{sizeof(CheckpointEntity)};
+    std::uint32_t _body_record_bytes{sizeof(CheckpointBody)};
+    std::uint64_t _entities{0};
+    std::uint64_t _static_bodies{0};
+    std::uint64_t _dynamic_bodies{0};
+    std::uint64_t _jolt_state_bytes{0};
+    std::uint64_t _step{0};
+    std::uint32_t _sphere_body_id{0};
+    PhysicsCapacity _capacity{};
+    DevPanelState _dev_panel_state{};
+};
+
+constexpr std::size_t align_section(const std::size_t offset)
+{
+    return (offset + kSectionAlignment - 1) / kSectionAlignment *
+           kSectionAlignment;
+}
+
+double milliseconds_since(const std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>{
+        std::chrono::steady_clock::now() - start}
+        .count();
+}
+
+template <typename Component>
+void capture_component(const flecs::entity &entity,
+                       const std::uint32_t bit,
+                       std::uint32_t &components,
+                       Component &record)
+{
+    const Component *component{entity.get<Component>()};
+    if (component != nullptr)
+    {
+        components |= bit;
+        record = *component;
+    }
+}
+
+template <typename Component>
+void restore_component(const flecs::entity &entity,
+                       const std::uint32_t bit,
+                       const std::uint32_t components,
+                       const Component &record)
+{
+    if ((components & bit) != 0)
+    {
+        entity.set<Component>(record);
+    }
+}
+
+// Writes sections one after the other, padding each to kSectionAlignment
+class SectionWriter
+{
+public:
+    explicit SectionWriter(std::ofstream &output) : _output{output}
+    {
+    }
+
+    void write(const void *data, const std::size_t bytes)
+    {
+        constexpr char kPadding[kSectionAlignment]{};
+        const std::size_t aligned{align_section(_offset)};
+        _output.write(kPadding, static_cast<std::streamsize>(aligned - _offset));
+        _output.write(static_cast<const char *>(data),
+                      static_cast<std::streamsize>(bytes));
+        _offset = aligned + bytes;
+    }
+
+    [[nodiscard]] std::size_t offset() const
+    {
+        return _offset;
+    }
+
+private:
+    std::ofstream &_output;
+    std::size_t _offset{0};
+};
+
+template <typename Record>
+std::size_t read_section(const std::vector<unsigned char> &file,
+                         const std::size_t offset,
+                         const std::size_t count,
+                         std::vector<Record> &records)
+{
+    const std::size_t start{align_section(offset)};
+    records.resize(count);
+    if (count > 0)
+    {
+        std::memcpy(records.data(), file.data() + start, count * sizeof(Record));
+    }
+    return start + count * sizeof(Record);
+}
+} // namespace
+
+double CheckpointIoStats::megabytes_per_second() const
+{
+    constexpr double kBytesPerMegabyte{1'024.0 * 1'024.0};
+    constexpr double kMillisecondsPerSecond{1'000.0};
+    if (_milliseconds <= 0.0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(_bytes) / kBytesPerMegabyte /
+           (_milliseconds / kMillisecondsPerSecond);
+}
+
+void capture_world_checkpoint(const flecs::world &world,
+                              const PhysicsEngine &physics_engine,
+                              WorldCheckpoint &checkpoint)
+{
+    // every scene entity has a position
+    checkpoint._entities.clear();
+    world.each([&checkpoint](flecs::entity entity, const Position &position) {
+        CheckpointEntity &record{checkpoint._entities.emplace_back()};
+        record._entity = entity.id();
+        record._components = kHasPosition;
+        record._position = position;
+        std::uint32_t &components{record._components};
+        capture_component(entity, kHasVelocity, components, record._velocity);
+        capture_component(
+            entity, kHasSphereMesh, components, record._sphere_mesh);
+        capture_component(
+            entity, kHasSphereCollider, components, record._sphere_collider);
+        capture_component(
+            entity, kHasBoxCollider, components, record._box_collider);
+        capture_component(entity, kHasGrid, components, record._grid);
+        capture_component(entity, kHasSphereLod, components, record._sphere_lod);
+        capture_component(entity,
+                          kHasRigidBodyTransform,
+                          components,
+                          record._rigid_body_transform);
+        capture_component(
+            entity, kHasPhysicsBody, components, record._physics_body);
+        capture_component(
+            entity, kHasSpatialQuery, components, record._spatial_query);
+    });
+
+    const DevPanelState *dev_panel_state{world.get<DevPanelState>()};
+    checkpoint._dev_panel_state =
+        dev_panel_state != nullptr ? *dev_panel_state : DevPanelState{};
+    physics_engine.save_checkpoint(checkpoint._physics);
+}
+
+CheckpointIoStats write_world_checkpoint(const WorldCheckpoint &checkpoint,
+                                         const std::string &path)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    CheckpointIoStats stats{};
+    std::ofstream output{path, std::ios::binary | std::ios::trunc};
+    if (!output)
+    {
+        spdlog::error("Could not open {} to write a checkpoint", path);
+        return stats;
+    }
+
+    const PhysicsCheckpoint &physics{checkpoint._physics};
+    CheckpointFileHeader header{};
+    header._entities = checkpoint._entities.size();
+    header._static_bodies = physics._static_bodies.size();
+    header._dynamic_bodies = physics._dynamic_bodies.size();
+    header._jolt_state_bytes = physics._jolt_state.size();
+    header._step = physics._step;
+    header._sphere_body_id = physics._sphere_body_id;
+    header._capacity = physics._capacity;
+    header._dev_panel_state = checkpoint._dev_panel_state;
+
+    SectionWriter writer{output};
+    writer.write(&header, sizeof(header));
+    writer.write(checkpoint._entities.data(),
+                 checkpoint._entities.size() * sizeof(CheckpointEntity));
+    writer.write(physics._static_bodies.data(),
+                 physics._static_bodies.size() * sizeof(CheckpointBody));
+    writer.write(physics._dynamic_bodies.data(),
+                 physics._dynamic_bodies.size() * sizeof(CheckpointBody));
+    writer.write(physics._jolt_state.data(), physics._jolt_state.size());
+    output.close();
+    if (!output)
+    {
+        spdlog::error("Could not write the checkpoint to {}", path);
+        return stats;
+    }
+
+    stats._succeeded = true;
+    stats._bytes = writer.offset();
+    stats._milliseconds = milliseconds_since(start);
+    return stats;
+}
+
+CheckpointIoStats read_world_checkpoint(const std::string &path,
+                                        WorldCheckpoint &checkpoint)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    CheckpointIoStats stats{};
+    std::ifstream input{path, std::ios::binary | std::ios::ate};
+    if (!input)
+    {
+        spdlog::error("Could not open checkpoint {}", path);
+        return stats;
+    }
+    std::vector<unsigned char> file(static_cast<std::size_t>(input.tellg()));
+    input.seekg(0);
+    input.read(reinterpret_cast<char *>(file.data()), // NOLINT
+               static_cast<std::streamsize>(file.size()));
+
+    CheckpointFileHeader header{};
+    if (!input || file.size() < sizeof(header))
+    {
+        spdlog::error("Could not read checkpoint {}", path);
+        return stats;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header._magic != kCheckpointMagic ||
+        header._version != kCheckpointVersion ||
+        header._entity_record_bytes != sizeof(CheckpointEntity) ||
+        header._body_record_bytes != sizeof(CheckpointBody))
+    {
+        spdlog::error("{} is not a checkpoint written by this build", path);
+        return stats;
+    }
+    std::size_t expected_bytes{align_section(sizeof(header))};
+    expected_bytes = align_section(expected_bytes + header._entities *
+                                                        sizeof(CheckpointEntity));
+    expected_bytes = align_section(
+        expected_bytes + header._static_bodies * sizeof(CheckpointBody));
+    expected_bytes = align_section(
+        expected_bytes + header._dynamic_bodies * sizeof(CheckpointBody));
+    expected_bytes += header._jolt_state_bytes;
+    if (file.size() != expected_bytes)
+    {
+        spdlog::error("Checkpoint {} is truncated or corrupt", path);
+        return stats;
+    }
+
+    PhysicsCheckpoint &physics{checkpoint._physics};
+    physics._capacity = header._capacity;
+    physics._step = header._step;
+    physics._sphere_body_id = header._sphere_body_id;
+    checkpoint._dev_panel_state = header._dev_panel_state;
+    std::size_t offset{sizeof(header)};
+    offset = read_section(file, offset, header._entities, checkpoint._entities);
+    offset =
+        read_section(file, offset, header._static_bodies, physics._static_bodies);
+    offset = read_section(
+        file, offset, header._dynamic_bodies, physics._dynamic_bodies);
+    read_section(file, offset, header._jolt_state_bytes, physics._jolt_state);
+
+    stats._succeeded = true;
+    stats._bytes = file.size();
+    stats._milliseconds = milliseconds_since(start);
+    return stats;
+}
+
+bool restore_world_checkpoint(const WorldCheckpoint &checkpoint,
+                              const flecs::world &world,
+                              PhysicsEngine &physics_engine)
+{
+    // Register the components before recreating any entity, so they take
+    // their usual low IDs rather than colliding with a restored entity
+    world.component<Position>();
+    world.component<Velocity>();
+    world.component<SphereMesh>();
+    world.component<SphereCollider>();
+    world.component<BoxCollider>();
+    world.component<GridComponent>();
+    world.component<SphereLod>();
+    world.component<RigidBodyTransform>();
+    world.component<PhysicsBody>();
+    world.component<SpatialQuery>();
+    world.component<SpatialQueryHits>();
+    world.component<DevPanelState>();
+
+    for (const CheckpointEntity &record : checkpoint._entities)
+    {
+        const flecs::entity entity{world.ensure(record._entity)};
+        const std::uint32_t components{record._components};
+        restore_component(entity, kHasPosition, components, record._position);
+        restore_component(entity, kHasVelocity, components, record._velocity);
+        restore_component(
+            entity, kHasSphereMesh, components, record._sphere_mesh);
+        restore_component(
+            entity, kHasSphereCollider, components, record._sphere_collider);
+        restore_component(
+            entity, kHasBoxCollider, components, record._box_collider);
+        restore_component(entity, kHasGrid, components, record._grid);
+        restore_component(entity, kHasSphereLod, components, record._sphere_lod);
+        restore_component(entity,
+                          kHasRigidBodyTransform,
+                          components,
+                          record._rigid_body_transform);
+        restore_component(
+            entity, kHasPhysicsBody, components, record._physics_body);
+        if ((components & kHasSpatialQuery) != 0)
+        {
+            // the hits are answered afresh on the next frame
+            entity.set<SpatialQuery>(record._spatial_query)
+                .add<SpatialQueryHits>();
+        }
+    }
+    world.entity<DevPanelState>().set<DevPanelState>(
+        checkpoint._dev_panel_state);
+
+    physics_engine.initialise(checkpoint._physics._capacity);
+    if (!physics_engine.restore_checkpoint(checkpoint._physics))
+    {
+        return false;
+    }
+    physics_engine.start_simulation();
+
+    // The entities were captured from the last applied snapshot, which may be
+    // a step behind the engine, so bring them up to date
+    TransformSnapshot snapshot{};
+    SnapshotSyncStats sync_stats{};
+    physics_engine.read_transforms(snapshot);
+    apply_transform_snapshot_system(world, snapshot, sync_stats);
+    return true;
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    if (_pending.valid())
+    {
+        _pending.wait();
+    }
+}
+
+bool CheckpointWriter::save(WorldCheckpoint &&checkpoint,
+                            const std::string &path)
+{
+    if (busy())
+    {
+        return false;
+    }
+    _pending = std::async(
+        std::launch::async,
+        [checkpoint = std::move(checkpoint), path]() {
+            return write_world_checkpoint(checkpoint, path);
+        });
+    return true;
+}
+
+bool CheckpointWriter::poll(CheckpointIoStats &stats)
+{
+    if (!_pending.valid() || busy())
+    {
+        return false;
+    }
+    stats = _pending.get();
+    return true;
+}
+
+CheckpointIoStats CheckpointWriter::wait()
+{
+    return _pending.valid() ? _pending.get() : CheckpointIoStats{};
+}
+
+bool CheckpointWriter::busy() const
+{
+    return _pending.valid() &&
+           _pending.wait_for(std::chrono::seconds{0}) !=
+               std::future_status::ready;
+}
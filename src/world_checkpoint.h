@@ -0,0 +1,99 @@
+#ifndef SRC_WORLD_CHECKPOINT_H
+#define SRC_WORLD_CHECKPOINT_H
+
+#include "components.h"
+#include "physics.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/world.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+// A checkpoint file is a header followed by fixed-size entity and body records
+// and Jolt's saved state, each section 16-byte aligned. Like the baked font it
+// uses the native layout, so loading is a read and one copy per section, and
+// a file is only ever loaded by the build that wrote it.
+
+// One flecs entity with every scene component, _components says which are set
+struct alignas(16) CheckpointEntity
+{
+    RigidBodyTransform _rigid_body_transform{};
+    std::uint64_t _entity{0};
+    std::uint32_t _components{0};
+    PhysicsBody _physics_body{0, ShapeType::kSphere};
+    Position _position{Vector3{0.F, 0.F, 0.F}};
+    Velocity _velocity{Vector3{0.F, 0.F, 0.F}};
+    SphereMesh _sphere_mesh{};
+    SphereCollider _sphere_collider{0.F};
+    BoxCollider _box_collider{Vector3{0.F, 0.F, 0.F}};
+    GridComponent _grid{};
+    SphereLod _sphere_lod{};
+    SpatialQuery _spatial_query{};
+};
+
+struct WorldCheckpoint
+{
+    PhysicsCheckpoint _physics{};
+    DevPanelState _dev_panel_state{};
+    std::vector<CheckpointEntity> _entities;
+};
+
+struct CheckpointIoStats
+{
+    bool _succeeded{false};
+    std::size_t _bytes{0};
+    double _milliseconds{0.0};
+
+    [[nodiscard]] double megabytes_per_second() const;
+};
+
+// Copy the world and engine state. The engine must not be stepping, so for
+// the physics thread call this from PhysicsThread::with_engine. Disabled
+// entities are skipped, so bring back anything the world partition parked
+// first, with unpark_world_partition_system.
+void capture_world_checkpoint(const flecs::world &world,
+                              const PhysicsEngine &physics_engine,
+                              WorldCheckpoint &checkpoint);
+
+CheckpointIoStats write_world_checkpoint(const WorldCheckpoint &checkpoint,
+                                         const std::string &path);
+CheckpointIoStats read_world_checkpoint(const std::string &path,
+                                        WorldCheckpoint &checkpoint);
+
+// Recreate a checkpoint in an empty world and an engine that has not been
+// initialised yet. Entities keep their IDs, so bodies still point at them.
+bool restore_world_checkpoint(const WorldCheckpoint &checkpoint,
+                              const flecs::world &world,
+                              PhysicsEngine &physics_engine);
+
+// Writes checkpoints on a background thread, one at a time, so saving costs
+// the frame only the time to copy the state
+class CheckpointWriter
+{
+public:
+    CheckpointWriter() = default;
+    ~CheckpointWriter();
+    CheckpointWriter(const CheckpointWriter &) = delete;
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+    CheckpointWriter(CheckpointWriter &&) = delete;
+    CheckpointWriter &operator=(CheckpointWriter &&) = delete;
+
+    // mutator methods
+    // Returns false, dropping the checkpoint, while a save is still running
+    bool save(WorldCheckpoint &&checkpoint, const std::string &path);
+    // Returns true once for each finished save, with its stats
+    bool poll(CheckpointIoStats &stats);
+    CheckpointIoStats wait();
+
+    // accessor methods
+    [[nodiscard]] bool busy() const;
+
+private:
+    std::future<CheckpointIoStats> _pending{};
+};
+
+#endif
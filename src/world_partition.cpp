@@ -0,0 +1,207 @@
+#include "world_partition.h"
+
+#include "constants.h"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+std::size_t PartitionCellHash::operator()(const PartitionCell &cell) const
+{
+    const auto x{static_cast<std::uint32_t>(cell._x)};
+    const auto z{static_cast<std::uint32_t>(cell._z)};
+    return std::hash<std::uint64_t>{}((static_cast<std::uint64_t>(x) << 32U) |
+                                      z);
+}
+
+PartitionCell partition_cell_of(const Vector3 &position, const float cell_size)
+{
+    return PartitionCell{
+        static_cast<std::int32_t>(std::floor(position.x / cell_size)),
+        static_cast<std::int32_t>(std::floor(position.z / cell_size))};
+}
+
+int partition_cell_distance(const PartitionCell &from, const PartitionCell &to)
+{
+    return std::max(std::abs(from._x - to._x), std::abs(from._z - to._z));
+}
+
+bool WorldPartition::update_centre(const PartitionCell &centre,
+                                   const int load_radius,
+                                   const int unload_radius)
+{
+    const int kept_radius{std::max(unload_radius, load_radius)};
+    if (_active && centre == _centre && load_radius == _load_radius &&
+        kept_radius == _unload_radius)
+    {
+        if (++_frames_since_sweep < constants::kPartitionSweepFrames)
+        {
+            return false;
+        }
+        _frames_since_sweep = 0;
+        return true;
+    }
+
+    _active = true;
+    _centre = centre;
+    _load_radius = load_radius;
+    _unload_radius = kept_radius;
+    _frames_since_sweep = 0;
+    for (auto cell{_loaded.begin()}; cell != _loaded.end();)
+    {
+        if (partition_cell_distance(*cell, _centre) > _unload_radius)
+        {
+            cell = _loaded.erase(cell);
+            continue;
+        }
+        ++cell;
+    }
+    queue_loads();
+    return true;
+}
+
+void WorldPartition::park(const PartitionCell &cell,
+                          const std::uint64_t entity)
+{
+    _parked[cell].push_back(entity);
+    ++_parked_entities;
+}
+
+bool WorldPartition::load_next(std::vector<std::uint64_t> &entities)
+{
+    if (_queued.empty())
+    {
+        return false;
+    }
+    const PartitionCell cell{_queued.back()};
+    _queued.pop_back();
+    _loaded.insert(cell);
+
+    const auto parked{_parked.find(cell)};
+    if (parked != _parked.end())
+    {
+        entities.insert(
+            entities.end(), parked->second.begin(), parked->second.end());
+        _parked_entities -= parked->second.size();
+        _parked.erase(parked);
+    }
+    return true;
+}
+
+void WorldPartition::reset(std::vector<std::uint64_t> &entities)
+{
+    for (const auto &[cell, parked] : _parked)
+    {
+        entities.insert(entities.end(), parked.begin(), parked.end());
+    }
+    _parked.clear();
+    _parked_entities = 0;
+    _loaded.clear();
+    _queued.clear();
+    _active = false;
+}
+
+void WorldPartition::record_load_cost(const std::size_t bodies,
+                                      const double milliseconds)
+{
+    if (bodies == 0)
+    {
+        return;
+    }
+    // smoothed, so one slow frame does not stall loading for long
+    constexpr double kSmoothing{0.2};
+    const double per_body{milliseconds / static_cast<double>(bodies)};
+    _milliseconds_per_body =
+        _milliseconds_per_body == 0.0
+            ? per_body
+            : _milliseconds_per_body +
+                  kSmoothing * (per_body - _milliseconds_per_body);
+}
+
+bool WorldPartition::active() const
+{
+    return _active;
+}
+
+bool WorldPartition::is_wanted(const PartitionCell &cell) const
+{
+    return partition_cell_distance(cell, _centre) <= _load_radius ||
+           _loaded.count(cell) != 0;
+}
+
+double WorldPartition::estimated_load_milliseconds(
+    const std::size_t bodies) const
+{
+    return _milliseconds_per_body * static_cast<double>(bodies);
+}
+
+std::size_t WorldPartition::next_load_size() const
+{
+    if (_queued.empty())
+    {
+        return 0;
+    }
+    const auto parked{_parked.find(_queued.back())};
+    return parked != _parked.end() ? parked->second.size() : 0;
+}
+
+const PartitionCell &WorldPartition::centre() const
+{
+    return _centre;
+}
+
+std::size_t WorldPartition::loaded_cell_count() const
+{
+    return _loaded.size();
+}
+
+std::size_t WorldPartition::queued_cell_count() const
+{
+    return _queued.size();
+}
+
+std::size_t WorldPartition::parked_cell_count() const
+{
+    return _parked.size();
+}
+
+std::size_t WorldPartition::parked_entity_count() const
+{
+    return _parked_entities;
+}
+
+void WorldPartition::queue_loads()
+{
+    _queued.clear();
+    for (int z{-_load_radius}; z <= _load_radius; ++z)
+    {
+        for (int x{-_load_radius}; x <= _load_radius; ++x)
+        {
+            const PartitionCell cell{_centre._x + x, _centre._z + z};
+            if (_loaded.count(cell) == 0)
+            {
+                _queued.push_back(cell);
+            }
+        }
+    }
+
+    // nearest last, so loading pops from the back
+    const PartitionCell centre{_centre};
+    const auto distance_squared{[centre](const PartitionCell &cell) {
+        const int x{cell._x - centre._x};
+        const int z{cell._z - centre._z};
+        return x * x + z * z;
+    }};
+    std::sort(_queued.begin(),
+              _queued.end(),
+              [&distance_squared](const PartitionCell &lhs,
+                                  const PartitionCell &rhs) {
+                  return distance_squared(lhs) > distance_squared(rhs);
+              });
+}
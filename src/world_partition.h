@@ -0,0 +1,109 @@
+#ifndef SRC_WORLD_PARTITION_H
+#define SRC_WORLD_PARTITION_H
+
+#include "constants.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Streaming of the world around the camera, toggled from the Dev Panel
+struct WorldPartitionSettings
+{
+    bool _enabled{false};
+    float _cell_size{constants::kPartitionCellSize};
+    int _load_radius{constants::kPartitionLoadRadius}; // in cells
+    // Loaded cells stay until they are this far away, so a camera moving
+    // back and forth over a border does not load and unload the same cells
+    int _unload_radius{constants::kPartitionUnloadRadius};
+    // Time a frame may spend bringing cells back in
+    float _load_budget_milliseconds{
+        constants::kPartitionLoadBudgetMilliseconds};
+};
+
+// A square column of the world, cell size wide in x and z
+struct PartitionCell
+{
+    std::int32_t _x{0};
+    std::int32_t _z{0};
+
+    bool operator==(const PartitionCell &other) const
+    {
+        return _x == other._x && _z == other._z;
+    }
+};
+
+struct PartitionCellHash
+{
+    std::size_t operator()(const PartitionCell &cell) const;
+};
+
+PartitionCell partition_cell_of(const Vector3 &position, float cell_size);
+// Cells apart along the furthest axis, so a radius covers a square
+int partition_cell_distance(const PartitionCell &from, const PartitionCell &to);
+
+// Which cells are loaded around a centre cell, and the entities parked in the
+// ones that are not. A cell is wanted while it is loaded or within the load
+// radius. Entities in cells that are not wanted get parked; wanted cells
+// that are not loaded yet are queued, nearest first, and hand their parked
+// entities back as they load. Nothing here touches flecs or Jolt, see
+// stream_world_partition_system.
+class WorldPartition
+{
+public:
+    WorldPartition() = default;
+
+    // mutator methods
+    // Move the centre and radii. Loaded cells past the unload radius are
+    // dropped and the load queue is rebuilt. Returns true when entities
+    // should be checked for parking: the centre or radii changed, or
+    // constants::kPartitionSweepFrames calls went by, to catch bodies that
+    // moved into a far cell on their own.
+    bool update_centre(const PartitionCell &centre,
+                       int load_radius,
+                       int unload_radius);
+    void park(const PartitionCell &cell, std::uint64_t entity);
+    // Load the nearest queued cell, appending the entities parked in it.
+    // Returns false when no cell is queued.
+    bool load_next(std::vector<std::uint64_t> &entities);
+    // Append every parked entity and forget all cells, for turning
+    // streaming off
+    void reset(std::vector<std::uint64_t> &entities);
+    // Cost of the last batch of bodies brought back, to estimate the next
+    void record_load_cost(std::size_t bodies, double milliseconds);
+
+    // accessor methods
+    [[nodiscard]] bool active() const;
+    [[nodiscard]] bool is_wanted(const PartitionCell &cell) const;
+    [[nodiscard]] double estimated_load_milliseconds(std::size_t bodies) const;
+    // Entities load_next would hand back, 0 when no cell is queued
+    [[nodiscard]] std::size_t next_load_size() const;
+    [[nodiscard]] const PartitionCell &centre() const;
+    [[nodiscard]] std::size_t loaded_cell_count() const;
+    [[nodiscard]] std::size_t queued_cell_count() const;
+    [[nodiscard]] std::size_t parked_cell_count() const;
+    [[nodiscard]] std::size_t parked_entity_count() const;
+
+private:
+    void queue_loads();
+
+    PartitionCell _centre{};
+    bool _active{false};
+    int _load_radius{0};
+    int _unload_radius{0};
+    int _frames_since_sweep{0};
+    std::unordered_set<PartitionCell, PartitionCellHash> _loaded{};
+    std::vector<PartitionCell> _queued{}; // nearest last
+    std::unordered_map<PartitionCell,
+                       std::vector<std::uint64_t>,
+                       PartitionCellHash>
+        _parked{};
+    std::size_t _parked_entities{0};
+    double _milliseconds_per_body{0.0};
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "body_trace.h"
+
+#include "check.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Columns have to come back bit for bit, including negative zero and NaN
+bool same_bits(const std::vector<float> &lhs, const std::vector<float> &rhs)
+{
+    return lhs.size() == rhs.size() &&
+           (lhs.empty() ||
+            std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(float)) ==
+                0);
+}
+
+bool same_columns(const BodyTraceColumns &lhs, const BodyTraceColumns &rhs)
+{
+    bool same{lhs._step == rhs._step && lhs._delta_time == rhs._delta_time &&
+              lhs._entities == rhs._entities &&
+              lhs._sleeping == rhs._sleeping && lhs._contacts == rhs._contacts};
+    for (std::size_t axis{0}; axis < 3; ++axis)
+    {
+        same = same && same_bits(lhs._position[axis], rhs._position[axis]) &&
+               same_bits(lhs._velocity[axis], rhs._velocity[axis]);
+    }
+    return same;
+}
+
+// A few bodies falling, one asleep, then a body despawned and two spawned
+std::vector<BodyTraceColumns> make_steps()
+{
+    std::vector<BodyTraceColumns> steps;
+    constexpr int kSteps{5};
+    for (int step{0}; step < kSteps; ++step)
+    {
+        BodyTraceColumns columns{};
+        columns._step = static_cast<std::uint64_t>(step + 1);
+        columns._delta_time = 1.F / 60.F;
+        std::vector<std::uint64_t> entities{530, 531, 532, 4'294'967'828};
+        if (step >= 3)
+        {
+            entities = {530, 532, 4'294'967'828, 600, 12};
+        }
+        columns.resize(entities.size());
+        columns._entities = entities;
+        for (std::size_t index{0}; index < entities.size(); ++index)
+        {
+            const auto offset{static_cast<float>(index)};
+            const bool sleeping{index == 1};
+            const float fall{sleeping ? 0.F : 0.1F * static_cast<float>(step)};
+            columns._position[0][index] = offset;
+            columns._position[1][index] = 5.F - fall;
+            columns._position[2][index] = -offset;
+            columns._velocity[0][index] = 0.F;
+            columns._velocity[1][index] = sleeping ? -0.F : -fall * 60.F;
+            columns._velocity[2][index] = index == 4 ? NAN : 0.25F;
+            columns._sleeping[index] = sleeping ? 1 : 0;
+            columns._contacts[index] =
+                static_cast<std::uint16_t>(index == 2 ? 300 : index);
+        }
+        steps.push_back(columns);
+    }
+    // an empty step, everything despawned
+    BodyTraceColumns empty{};
+    empty._step = kSteps + 1;
+    empty._delta_time = 1.F / 60.F;
+    steps.push_back(empty);
+    return steps;
+}
+
+void test_round_trip()
+{
+    const std::string path{
+        (std::filesystem::temp_directory_path() / "body_trace_test.trace")
+            .string()};
+    const std::vector<BodyTraceColumns> steps{make_steps()};
+
+    BodyTraceWriter writer{};
+    check(writer.open(path), "opens the trace for writing");
+    for (const BodyTraceColumns &columns : steps)
+    {
+        writer.write(columns);
+    }
+    check(writer.close(), "writes every step without errors");
+    check(writer.steps() == steps.size(), "counts the steps written");
+    check(writer.dropped_steps() == 0, "drops nothing");
+    check(writer.written_bytes() < writer.raw_bytes(),
+          "compresses below the raw column size");
+
+    BodyTraceReader reader{};
+    check(reader.open(path), "opens the trace for reading");
+    BodyTraceColumns columns{};
+    std::size_t read{0};
+    while (reader.read(columns))
+    {
+        check(read < steps.size() && same_columns(columns, steps[read]),
+              "reads back every step exactly");
+        ++read;
+    }
+    check(!reader.failed(), "reaches the end without errors");
+    check(read == steps.size(), "reads every step");
+    std::filesystem::remove(path);
+}
+
+void test_reports_write_errors()
+{
+    BodyTraceWriter writer{};
+    check(!writer.open((std::filesystem::temp_directory_path() /
+                        "no_such_directory" / "body_trace_test.trace")
+                           .string()),
+          "fails to open a trace it cannot create");
+    check(writer.close(), "closing a writer that never opened is harmless");
+
+    // every write to /dev/full fails with no space left
+    const std::string full_device{"/dev/full"};
+    if (!std::filesystem::exists(full_device) || !writer.open(full_device))
+    {
+        return;
+    }
+    for (const BodyTraceColumns &columns : make_steps())
+    {
+        writer.write(columns);
+    }
+    check(!writer.close(), "reports a write that fails");
+    check(writer.failed(), "remembers the failure");
+}
+
+void test_rejects_other_files()
+{
+    const std::string path{
+        (std::filesystem::temp_directory_path() / "body_trace_test.bad")
+            .string()};
+    std::FILE *file{std::fopen(path.c_str(), "wb")};
+    std::fputs("not a trace", file);
+    std::fclose(file);
+
+    BodyTraceReader reader{};
+    check(!reader.open(path), "rejects a file without the trace magic");
+    BodyTraceColumns columns{};
+    check(!reader.read(columns), "reads nothing from a rejected file");
+    std::filesystem::remove(path);
+}
+
+void test_contact_counter()
+{
+    BodyContactCounter counter{4};
+    counter.add(1);
+    counter.add(1);
+    counter.add(3);
+    counter.add(9); // out of range, ignored
+    check(counter.take(1) == 2, "counts contacts per body");
+    check(counter.take(1) == 0, "take resets the count");
+    check(counter.take(3) == 1, "keeps bodies apart");
+    check(counter.take(9) == 0, "out of range bodies have no contacts");
+}
+} // namespace
+
+int main()
+{
+    test_round_trip();
+    test_reports_write_errors();
+    test_rejects_other_files();
+    test_contact_counter();
+    return check_result("body trace");
+}
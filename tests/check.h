@@ -0,0 +1,34 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+// The unit tests' harness: check every expectation, so one run reports all
+// the failures, then return check_result from main
+
+inline int check_failures{0};
+
+inline void check(const bool condition, const char *description)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << description << '\n';
+        ++check_failures;
+    }
+}
+
+// Report how the checks of suite, e.g. "history", went and return the exit
+// code for CTest
+inline int check_result(const char *suite)
+{
+    if (check_failures > 0)
+    {
+        std::cerr << check_failures << ' ' << suite << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "All " << suite << " checks passed\n";
+    return EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "debug_draw.h"
+
+#include "check.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+
+namespace
+{
+Matrix translation(const float x, const float y, const float z)
+{
+    Matrix matrix{};
+    matrix.m0 = 1.F;
+    matrix.m5 = 1.F;
+    matrix.m10 = 1.F;
+    matrix.m15 = 1.F;
+    matrix.m12 = x;
+    matrix.m13 = y;
+    matrix.m14 = z;
+    return matrix;
+}
+
+// One white triangle in the xz plane facing up, as Jolt would hand it over
+DebugMesh make_triangle_mesh()
+{
+    DebugMesh mesh{};
+    mesh._positions = {Vector3{0.F, 0.F, 0.F},
+                       Vector3{0.F, 0.F, 1.F},
+                       Vector3{1.F, 0.F, 0.F}};
+    mesh._normals.assign(3, Vector3{0.F, 1.F, 0.F});
+    mesh._colours.assign(3, Color{255, 255, 255, 255});
+    mesh._indices = {0, 1, 2};
+    return mesh;
+}
+
+void test_lines_and_triangles()
+{
+    DebugVertexCollector collector{};
+    collector.add_line(
+        Vector3{0.F, 0.F, 0.F}, Vector3{1.F, 0.F, 0.F}, Color{255, 0, 0, 255});
+    collector.add_triangle(Vector3{0.F, 0.F, 0.F},
+                           Vector3{1.F, 0.F, 0.F},
+                           Vector3{0.F, 1.F, 0.F},
+                           Color{0, 255, 0, 255});
+    check(collector.line_count() == 1, "collects a line as two vertices");
+    check(collector.triangle_count() == 1,
+          "collects a triangle as three vertices");
+    check(collector.lines()[1]._position.x == 1.F, "keeps line end points");
+    check(collector.triangles()[2]._colour.g == 255,
+          "keeps triangle colours");
+}
+
+void test_mesh_is_placed_and_tinted()
+{
+    const DebugMesh mesh{make_triangle_mesh()};
+    DebugVertexCollector collector{};
+    const Color tint{255, 128, 0, 255};
+    collector.add_mesh(mesh, translation(2.F, 3.F, 4.F), tint, false);
+    check(collector.mesh_count() == 1, "counts meshes placed");
+    check(collector.triangle_count() == 1, "copies every triangle");
+    const DebugVertex &vertex{collector.triangles()[1]};
+    check(vertex._position.x == 2.F && vertex._position.y == 3.F &&
+              vertex._position.z == 5.F,
+          "moves vertices by the transform");
+    check(vertex._colour.b == 0 && vertex._colour.r > vertex._colour.g &&
+              vertex._colour.g > 0,
+          "multiplies in the tint");
+    check(vertex._colour.a == 255, "keeps opaque shapes opaque");
+}
+
+void test_wireframe_mesh()
+{
+    const DebugMesh mesh{make_triangle_mesh()};
+    DebugVertexCollector collector{};
+    collector.add_mesh(
+        mesh, translation(0.F, 0.F, 0.F), Color{255, 255, 255, 255}, true);
+    check(collector.triangle_count() == 0, "wireframes draw no triangles");
+    check(collector.line_count() == 3, "wireframes draw each edge");
+}
+
+void test_clear_keeps_capacity()
+{
+    const DebugMesh mesh{make_triangle_mesh()};
+    DebugVertexCollector collector{};
+    for (int copy{0}; copy < 100; ++copy)
+    {
+        collector.add_mesh(
+            mesh, translation(0.F, 0.F, 0.F), Color{255, 255, 255, 255},
+            copy % 2 == 0);
+    }
+    const std::size_t line_capacity{collector.lines().capacity()};
+    const std::size_t triangle_capacity{collector.triangles().capacity()};
+    collector.clear();
+    check(collector.line_count() == 0 && collector.triangle_count() == 0 &&
+              collector.mesh_count() == 0,
+          "clear empties the frame");
+    check(collector.lines().capacity() == line_capacity &&
+              collector.triangles().capacity() == triangle_capacity,
+          "clear keeps the buffers for the next frame");
+}
+} // namespace
+
+int main()
+{
+    test_lines_and_triangles();
+    test_mesh_is_placed_and_tinted();
+    test_wireframe_mesh();
+    test_clear_keeps_capacity();
+    return check_result("debug draw");
+}
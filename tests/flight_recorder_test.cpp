@@ -0,0 +1,145 @@
+#include "flight_recorder.h"
+
+#include "check.h"
+#include "constants.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+bool in_order(const std::vector<FlightRecord> &records)
+{
+    for (std::size_t record{1}; record < records.size(); ++record)
+    {
+        if (records[record]._sequence <= records[record - 1]._sequence ||
+            records[record]._nanoseconds < records[record - 1]._nanoseconds)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_keeps_the_latest()
+{
+    // about a megabyte, too much for the stack
+    const auto recorder{std::make_unique<FlightRecorder>()};
+    const std::uint64_t frames{constants::kFlightRecorderCapacity + 10};
+    for (std::uint64_t frame{0}; frame < frames; ++frame)
+    {
+        recorder->record_frame(frame, 16.F);
+    }
+    std::vector<FlightRecord> records;
+    recorder->snapshot(records);
+    check(recorder->recorded() == frames, "counts every record");
+    check(records.size() == constants::kFlightRecorderCapacity,
+          "keeps a full ring");
+    check(!records.empty() && records.front()._index == 10 &&
+              records.back()._index == frames - 1,
+          "keeps the latest records");
+    check(in_order(records), "returns records oldest first");
+}
+
+void test_text_is_truncated()
+{
+    const auto recorder{std::make_unique<FlightRecorder>()};
+    recorder->record_log(3, std::string(200, 'x'));
+    recorder->record_assert(
+        "inNumBodies > 0", "Too few bodies", "/src/Jolt/Physics/Body.cpp", 42);
+    std::vector<FlightRecord> records;
+    recorder->snapshot(records);
+    check(records.size() == 2 && records[0]._level == 3 &&
+              std::string_view{records[0]._text.data()}.size() ==
+                  records[0]._text.size() - 1,
+          "truncates long log messages");
+    check(records.size() == 2 && records[1]._count == 42 &&
+              std::string_view{records[1]._text.data()} ==
+                  "Body.cpp: inNumBodies > 0 Too few bodies",
+          "records the file name and expression of an assert");
+}
+
+void test_concurrent_records_are_whole()
+{
+    const auto recorder{std::make_unique<FlightRecorder>()};
+    constexpr std::uint64_t kThreads{4};
+    constexpr std::uint64_t kRecordsPerThread{20'000};
+    std::vector<std::thread> threads{};
+    for (std::uint64_t thread{0}; thread < kThreads; ++thread)
+    {
+        threads.emplace_back([&recorder]() {
+            for (std::uint64_t record{0}; record < kRecordsPerThread; ++record)
+            {
+                // every field derived from one value, to spot torn records
+                recorder->record_physics_step(
+                    record, static_cast<float>(record), record % 1'000);
+            }
+        });
+    }
+    // read while the writers run
+    std::vector<FlightRecord> records;
+    bool whole{true};
+    for (int pass{0}; pass < 50; ++pass)
+    {
+        recorder->snapshot(records);
+        for (const FlightRecord &record : records)
+        {
+            whole = whole &&
+                    record._values[0] == static_cast<float>(record._index) &&
+                    record._count == record._index % 1'000;
+        }
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    check(whole, "never returns a record torn by a writer");
+    check(recorder->recorded() == kThreads * kRecordsPerThread,
+          "counts records from every thread");
+}
+
+void test_dump_round_trip()
+{
+    const std::string path{(std::filesystem::temp_directory_path() /
+                            "flight_recorder_test.bin")
+                               .string()};
+    const auto recorder{std::make_unique<FlightRecorder>()};
+    recorder->set_dump_path(path);
+    recorder->record_key(300);
+    recorder->record_mouse(0, 12.F, 34.F);
+    recorder->record_frame(7, 16.6F);
+    check(recorder->dump(FlightDumpReason::kSignal, 11), "writes a dump");
+
+    FlightRecordingHeader header{};
+    std::vector<FlightRecord> records;
+    check(read_flight_recording(path, header, records), "reads a dump back");
+    check(header._reason == FlightDumpReason::kSignal &&
+              header._detail == 11 && records.size() == 3,
+          "keeps the reason and every record");
+    check(records.size() == 3 && records[0]._type == FlightRecordType::kKey &&
+              records[0]._count == 300 && records[1]._values[1] == 34.F &&
+              records[2]._index == 7,
+          "records survive the round trip");
+
+    std::error_code error{};
+    std::filesystem::remove(path, error);
+    check(!read_flight_recording(path, header, records),
+          "a missing dump fails to read");
+}
+} // namespace
+
+int main()
+{
+    test_keeps_the_latest();
+    test_text_is_truncated();
+    test_concurrent_records_are_whole();
+    test_dump_round_trip();
+    return check_result("flight recorder");
+}
@@ -0,0 +1,94 @@
+#include "history.h"
+
+#include "check.h"
+#include "constants.h"
+
+#include <cstddef>
+
+namespace
+{
+void test_ring_wraps()
+{
+    HistoryRing ring{};
+    check(ring.size() == 0, "starts empty");
+    const std::size_t pushed{constants::kHistoryCapacity + 10};
+    for (std::size_t sample{0}; sample < pushed; ++sample)
+    {
+        ring.push(static_cast<float>(sample));
+    }
+    check(ring.size() == constants::kHistoryCapacity, "holds at most capacity");
+    check(ring.at(0) == 10.F, "drops the oldest samples");
+    check(ring.at(ring.size() - 1) == static_cast<float>(pushed - 1),
+          "keeps the newest sample last");
+    ring.clear();
+    check(ring.size() == 0, "clear empties the ring");
+}
+
+void test_short_window_is_copied()
+{
+    HistoryRing ring{};
+    for (int sample{0}; sample < 100; ++sample)
+    {
+        ring.push(static_cast<float>(sample));
+    }
+    HistoryPlot plot{};
+    const std::size_t points{decimate_min_max(ring, 50, plot)};
+    check(points == 50, "plots every sample of a short window");
+    check(plot[0] == 50.F && plot[49] == 99.F,
+          "plots the newest samples, oldest first");
+    check(decimate_min_max(ring, 1'000, plot) == 100,
+          "a window longer than the history plots what there is");
+}
+
+void test_long_window_keeps_spikes()
+{
+    HistoryRing ring{};
+    for (std::size_t sample{0}; sample < constants::kHistoryCapacity; ++sample)
+    {
+        ring.push(0.F);
+    }
+    // one spike up and one down, each a single sample wide
+    HistoryRing spiky{};
+    for (std::size_t sample{0}; sample < constants::kHistoryCapacity; ++sample)
+    {
+        const float value{sample == 1'000 ? 5.F
+                          : sample == 3'000 ? -3.F
+                                            : 0.F};
+        spiky.push(value);
+    }
+    HistoryPlot plot{};
+    const std::size_t points{
+        decimate_min_max(spiky, constants::kHistoryCapacity, plot)};
+    check(points == plot.size(), "a long window fills every column");
+    float highest{0.F};
+    float lowest{0.F};
+    std::size_t highest_point{0};
+    std::size_t lowest_point{0};
+    for (std::size_t point{0}; point < points; ++point)
+    {
+        if (plot[point] > highest)
+        {
+            highest = plot[point];
+            highest_point = point;
+        }
+        if (plot[point] < lowest)
+        {
+            lowest = plot[point];
+            lowest_point = point;
+        }
+    }
+    check(highest == 5.F && lowest == -3.F, "keeps single sample spikes");
+    check(highest_point < lowest_point, "keeps spikes in order");
+    check(decimate_min_max(ring, constants::kHistoryCapacity, plot) ==
+              plot.size(),
+          "a flat history still fills every column");
+}
+} // namespace
+
+int main()
+{
+    test_ring_wraps();
+    test_short_window_is_copied();
+    test_long_window_keeps_spikes();
+    return check_result("history");
+}
@@ -0,0 +1,164 @@
+#include "particles.h"
+
+#include "check.h"
+#include "constants.h"
+
+#include <raylib.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+bool near(const float lhs, const float rhs)
+{
+    // the vector kernel may fuse a multiply and add the scalar one rounds
+    constexpr float kTolerance{1e-4F};
+    return std::fabs(lhs - rhs) <= kTolerance * (1.F + std::fabs(rhs));
+}
+
+bool same_particles(const ParticleSystem &lhs, const ParticleSystem &rhs)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    for (std::size_t particle{0}; particle < lhs.size(); ++particle)
+    {
+        const Vector3 lhs_position{lhs.position(particle)};
+        const Vector3 rhs_position{rhs.position(particle)};
+        const Vector3 lhs_velocity{lhs.velocity(particle)};
+        const Vector3 rhs_velocity{rhs.velocity(particle)};
+        if (!near(lhs_position.x, rhs_position.x) ||
+            !near(lhs_position.y, rhs_position.y) ||
+            !near(lhs_position.z, rhs_position.z) ||
+            !near(lhs_velocity.x, rhs_velocity.x) ||
+            !near(lhs_velocity.y, rhs_velocity.y) ||
+            !near(lhs_velocity.z, rhs_velocity.z) ||
+            lhs.lifetime(particle) != rhs.lifetime(particle))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// An odd count, so the vector kernel leaves a scalar tail
+void fill(ParticleSystem &particles, const int count)
+{
+    std::uint32_t seed{7};
+    constexpr float kSpeed{6.F};
+    for (int particle{0}; particle < count; ++particle)
+    {
+        particles.emit(Vector3{0.F, 2.F * next_particle_random(seed), 0.F},
+                       Vector3{kSpeed * (next_particle_random(seed) - 0.5F),
+                               kSpeed * (next_particle_random(seed) - 0.5F),
+                               kSpeed * (next_particle_random(seed) - 0.5F)},
+                       0.1F + next_particle_random(seed),
+                       WHITE);
+    }
+}
+
+void test_kernel_matches_scalar()
+{
+    constexpr int kParticles{1'003};
+    constexpr float kDeltaTime{1.F / 60.F};
+    const ParticleSettings settings{};
+    ParticleSystem vectorised{};
+    ParticleSystem scalar{};
+    fill(vectorised, kParticles);
+    fill(scalar, kParticles);
+
+    bool same{true};
+    std::size_t removed{0};
+    for (int tick{0}; tick < 30; ++tick)
+    {
+        removed += vectorised.integrate(kDeltaTime, settings);
+        scalar.integrate_scalar(kDeltaTime, settings);
+        same = same && same_particles(vectorised, scalar);
+    }
+    check(same, "the vector kernel matches the scalar one");
+    check(removed > 0 && vectorised.size() == kParticles - removed,
+          "expired particles are removed");
+}
+
+void test_bounces_off_the_ground()
+{
+    ParticleSettings settings{};
+    settings._gravity = 0.F;
+    settings._drag = 0.F;
+    settings._restitution = 0.5F;
+    ParticleSystem particles{};
+    for (int particle{0}; particle < 9; ++particle)
+    {
+        particles.emit(
+            Vector3{0.F, 0.05F, 0.F}, Vector3{0.F, -1.F, 0.F}, 1.F, WHITE);
+    }
+    particles.integrate(0.1F, settings);
+
+    bool bounced{true};
+    for (std::size_t particle{0}; particle < particles.size(); ++particle)
+    {
+        bounced = bounced && particles.position(particle).y == 0.F &&
+                  near(particles.velocity(particle).y, 0.5F);
+    }
+    check(bounced, "stops at the ground and bounces back up");
+}
+
+void test_drag_and_gravity()
+{
+    ParticleSettings settings{};
+    settings._gravity = -10.F;
+    settings._drag = 1.F;
+    settings._ground_height = -100.F;
+    ParticleSystem particles{};
+    particles.emit(
+        Vector3{0.F, 0.F, 0.F}, Vector3{2.F, 0.F, 0.F}, 2.F, WHITE);
+    particles.integrate(1.F, settings);
+    check(near(particles.velocity(0).x, 1.F) &&
+              near(particles.velocity(0).y, -5.F),
+          "gravity then drag are applied to the velocity");
+    check(near(particles.position(0).x, 1.F) &&
+              near(particles.position(0).y, -5.F),
+          "moves by the new velocity");
+    check(near(particles.lifetime(0), 1.F), "counts its lifetime down");
+}
+
+void test_capacity()
+{
+    ParticleSystem particles{};
+    check(!particles.emit(Vector3{}, Vector3{}, 0.F, WHITE),
+          "does not emit particles that are already dead");
+    bool emitted{true};
+    for (std::size_t particle{0}; particle < constants::kMaxParticles;
+         ++particle)
+    {
+        emitted = emitted && particles.emit(Vector3{}, Vector3{}, 1.F, WHITE);
+    }
+    check(emitted && !particles.emit(Vector3{}, Vector3{}, 1.F, WHITE),
+          "stops at the particle limit");
+}
+
+void test_random()
+{
+    std::uint32_t seed{0};
+    bool in_range{true};
+    for (int sample{0}; sample < 1'000; ++sample)
+    {
+        const float value{next_particle_random(seed)};
+        in_range = in_range && value >= 0.F && value < 1.F;
+    }
+    check(in_range && seed != 0, "random values are in [0, 1)");
+}
+} // namespace
+
+int main()
+{
+    test_kernel_matches_scalar();
+    test_bounces_off_the_ground();
+    test_drag_and_gravity();
+    test_capacity();
+    test_random();
+    return check_result("particle");
+}
@@ -0,0 +1,119 @@
+#include "physics_commands.h"
+
+#include "check.h"
+#include "shape_type.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+constexpr std::uint64_t kEntity{42};
+constexpr std::uint64_t kOtherEntity{43};
+constexpr std::uint32_t kBody{7};
+constexpr std::uint32_t kOtherBody{8};
+
+std::size_t count(const PhysicsCommandBuffer &buffer,
+                  const PhysicsCommandType type,
+                  const std::uint64_t entity)
+{
+    std::size_t matching{0};
+    for (const PhysicsCommand &command : buffer.commands())
+    {
+        if (command._type == type && command._entity == entity)
+        {
+            ++matching;
+        }
+    }
+    return matching;
+}
+
+void test_repeats_dropped()
+{
+    PhysicsCommandBuffer buffer;
+    buffer.create(kEntity, ShapeType::kSphere);
+    buffer.create(kEntity, ShapeType::kSphere);
+    buffer.update(kOtherEntity, ShapeType::kBox, kOtherBody);
+    buffer.update(kOtherEntity, ShapeType::kBox, kOtherBody);
+    check(buffer.size() == 2, "one create or update per entity");
+}
+
+void test_create_cancelled_by_destroy()
+{
+    PhysicsCommandBuffer buffer;
+    buffer.create(kEntity, ShapeType::kSphere);
+    buffer.destroy(kEntity, kNoPhysicsBody);
+    check(buffer.empty(), "a destroy before the body is made cancels it");
+
+    // the cancelled create is swapped with the last command
+    buffer.create(kEntity, ShapeType::kSphere);
+    buffer.update(kOtherEntity, ShapeType::kBox, kOtherBody);
+    buffer.destroy(kEntity, kNoPhysicsBody);
+    check(buffer.size() == 1 &&
+              count(buffer, PhysicsCommandType::kUpdate, kOtherEntity) == 1,
+          "cancelling keeps the other entity's update");
+    buffer.destroy(kOtherEntity, kOtherBody);
+    check(buffer.size() == 1 &&
+              count(buffer, PhysicsCommandType::kDestroy, kOtherEntity) == 1,
+          "the moved update is still found and cancelled");
+}
+
+void test_remove_then_set()
+{
+    // remove<SphereCollider>() then set<BoxCollider>() in one frame, as the
+    // collider observers record it
+    PhysicsCommandBuffer buffer;
+    buffer.destroy(kEntity, kBody);
+    buffer.update(kEntity, ShapeType::kBox, kBody);
+    check(buffer.size() == 2, "a destroy and a create");
+    check(count(buffer, PhysicsCommandType::kDestroy, kEntity) == 1,
+          "the old body is destroyed");
+    check(count(buffer, PhysicsCommandType::kUpdate, kEntity) == 0,
+          "the destroyed body is not updated");
+    check(count(buffer, PhysicsCommandType::kCreate, kEntity) == 1,
+          "the new collider gets a body of its own");
+
+    // removed again before the sync point
+    buffer.destroy(kEntity, kBody);
+    check(buffer.size() == 1 &&
+              count(buffer, PhysicsCommandType::kDestroy, kEntity) == 1,
+          "the create is cancelled and the body destroyed once");
+
+    buffer.clear();
+    buffer.update(kEntity, ShapeType::kSphere, kBody);
+    check(count(buffer, PhysicsCommandType::kUpdate, kEntity) == 1,
+          "a destroy is forgotten once the buffer is cleared");
+}
+
+void test_shape_change()
+{
+    // set<BoxCollider>() on an entity with a sphere body, as record_set does
+    // when the shapes differ
+    PhysicsCommandBuffer buffer;
+    buffer.destroy(kEntity, kBody);
+    buffer.create(kEntity, ShapeType::kBox);
+    buffer.update(kEntity, ShapeType::kBox, kBody);
+    check(buffer.size() == 2 &&
+              count(buffer, PhysicsCommandType::kDestroy, kEntity) == 1 &&
+              count(buffer, PhysicsCommandType::kCreate, kEntity) == 1,
+          "a replaced body is destroyed and created, never updated");
+    const std::vector<PhysicsCommand> &commands{buffer.commands()};
+    for (const PhysicsCommand &command : commands)
+    {
+        if (command._type == PhysicsCommandType::kCreate)
+        {
+            check(command._shape == ShapeType::kBox, "the new body is a box");
+        }
+    }
+}
+} // namespace
+
+int main()
+{
+    test_repeats_dropped();
+    test_create_cancelled_by_destroy();
+    test_remove_then_set();
+    test_shape_change();
+    return check_result("physics_commands");
+}
@@ -0,0 +1,112 @@
+#include "sphere_lod.h"
+
+#include "check.h"
+#include "components.h"
+
+#include <raylib.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+Camera3D perspective_camera()
+{
+    Camera3D camera{};
+    camera.position = Vector3{0.F, 0.F, 0.F};
+    camera.target = Vector3{0.F, 0.F, 1.F};
+    camera.up = Vector3{0.F, 1.F, 0.F};
+    camera.fovy = 90.F;
+    camera.projection = CAMERA_PERSPECTIVE;
+    return camera;
+}
+
+void test_hysteresis()
+{
+    const float finest{kSphereLodLevels[0]._min_radius_pixels};
+    check(select_sphere_lod(0, 2.F * finest) == 0, "large spheres stay fine");
+    check(select_sphere_lod(0, finest * (1.F - kSphereLodHysteresis / 2.F)) ==
+              0,
+          "a sphere just under its threshold keeps its level");
+    check(select_sphere_lod(0, finest * (1.F - 2.F * kSphereLodHysteresis)) ==
+              1,
+          "a sphere well under its threshold coarsens");
+    check(select_sphere_lod(1, finest * (1.F + kSphereLodHysteresis / 2.F)) ==
+              1,
+          "a sphere just over the finer threshold keeps its level");
+    check(select_sphere_lod(1, finest * (1.F + 2.F * kSphereLodHysteresis)) ==
+              0,
+          "a sphere well over the finer threshold refines");
+    check(select_sphere_lod(0, 0.1F) == kSphereImpostorLevel,
+          "tiny spheres skip straight to the impostor");
+    check(select_sphere_lod(kSphereImpostorLevel, 2.F * finest) == 0,
+          "impostors refine straight to full detail");
+    check(select_sphere_lod(200, 0.1F) == kSphereImpostorLevel,
+          "levels past the impostor are clamped");
+}
+
+void test_screen_scale()
+{
+    Camera3D camera{perspective_camera()};
+    check(std::fabs(sphere_lod_screen_scale(camera, 600.F) - 300.F) < 0.01F,
+          "a 90 degree view spans its height at twice the distance");
+    camera.projection = CAMERA_ORTHOGRAPHIC;
+    camera.fovy = 20.F;
+    check(sphere_lod_screen_scale(camera, 600.F) == 30.F,
+          "an orthographic view spans fovy world units");
+}
+
+void test_distance()
+{
+    const Camera3D camera{perspective_camera()};
+    // a unit sphere, the SphereMesh default, covers 300 pixels at unit
+    // distance
+    constexpr float kScreenScale{300.F};
+    const std::array<Position, 4> positions{
+        Position{Vector3{0.F, 0.F, 2.F}},
+        Position{Vector3{0.F, 0.F, 10.F}},
+        Position{Vector3{0.F, 0.F, 1'000.F}},
+        Position{Vector3{0.F, 0.F, 0.5F}}};
+    const std::array<SphereMesh, 4> sphere_meshes{};
+    std::array<SphereLod, 4> sphere_lods{};
+    sphere_lods[0]._level = kSphereImpostorLevel;
+    sphere_lods[3]._level = kSphereImpostorLevel;
+
+    check(first_sphere_lod_change(camera,
+                                  kScreenScale,
+                                  positions.data(),
+                                  sphere_meshes.data(),
+                                  sphere_lods.data(),
+                                  sphere_lods.size()) == 0,
+          "finds the first sphere whose level changes");
+    select_sphere_lods(camera,
+                       kScreenScale,
+                       positions.data(),
+                       sphere_meshes.data(),
+                       sphere_lods.data(),
+                       sphere_lods.size());
+    check(sphere_lods[0]._level == 0, "near spheres get full detail");
+    check(sphere_lods[1]._level == 1, "spheres further away coarsen");
+    check(sphere_lods[2]._level == kSphereImpostorLevel,
+          "distant spheres become impostors");
+    check(sphere_lods[3]._level == 0,
+          "a camera inside a sphere keeps full detail");
+    check(first_sphere_lod_change(camera,
+                                  kScreenScale,
+                                  positions.data(),
+                                  sphere_meshes.data(),
+                                  sphere_lods.data(),
+                                  sphere_lods.size()) == sphere_lods.size(),
+          "selecting again changes nothing");
+}
+} // namespace
+
+int main()
+{
+    test_hysteresis();
+    test_screen_scale();
+    test_distance();
+    return check_result("sphere LOD");
+}
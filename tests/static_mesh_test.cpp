@@ -0,0 +1,159 @@
+#include "static_mesh.h"
+
+#include "check.h"
+
+#include <raylib.h>
+
+#include <cmath>
+#include <cstddef>
+
+namespace
+{
+Vector3 vertex(const StaticMeshData &mesh, const std::size_t index)
+{
+    return Vector3{mesh._positions[3 * index],
+                   mesh._positions[3 * index + 1],
+                   mesh._positions[3 * index + 2]};
+}
+
+Vector3 normal(const StaticMeshData &mesh, const std::size_t index)
+{
+    return Vector3{mesh._normals[3 * index],
+                   mesh._normals[3 * index + 1],
+                   mesh._normals[3 * index + 2]};
+}
+
+// Every triangle has to be wound so its face points along its vertex
+// normals, otherwise backface culling hides it
+bool windings_match_normals(const StaticMeshData &mesh)
+{
+    for (std::size_t triangle{0}; triangle < mesh.triangle_count(); ++triangle)
+    {
+        const Vector3 a{vertex(mesh, mesh._indices[3 * triangle])};
+        const Vector3 b{vertex(mesh, mesh._indices[3 * triangle + 1])};
+        const Vector3 c{vertex(mesh, mesh._indices[3 * triangle + 2])};
+        const Vector3 ab{b.x - a.x, b.y - a.y, b.z - a.z};
+        const Vector3 ac{c.x - a.x, c.y - a.y, c.z - a.z};
+        const Vector3 face{ab.y * ac.z - ab.z * ac.y,
+                           ab.z * ac.x - ab.x * ac.z,
+                           ab.x * ac.y - ab.y * ac.x};
+        const Vector3 n{normal(mesh, mesh._indices[3 * triangle])};
+        if (face.x * n.x + face.y * n.y + face.z * n.z <= 0.F)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool indices_in_range(const StaticMeshData &mesh)
+{
+    for (const unsigned short index : mesh._indices)
+    {
+        if (index >= mesh.vertex_count())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool attributes_consistent(const StaticMeshData &mesh)
+{
+    return mesh._normals.size() == mesh._positions.size() &&
+           mesh._colours.size() == 4 * mesh.vertex_count() &&
+           mesh._indices.size() == 3 * mesh.triangle_count();
+}
+
+void test_grid()
+{
+    StaticMeshData mesh{};
+    check(append_grid(mesh, 10, 1.F, 0.02F), "grid fits");
+
+    // 11 lines each way, one quad per line
+    check(mesh.vertex_count() == 22 * 4, "grid vertex count");
+    check(mesh.triangle_count() == 22 * 2, "grid triangle count");
+    check(attributes_consistent(mesh), "grid attributes consistent");
+    check(indices_in_range(mesh), "grid indices in range");
+    check(windings_match_normals(mesh), "grid faces up");
+
+    float min_x{0.F};
+    float max_x{0.F};
+    float max_height{0.F};
+    for (std::size_t index{0}; index < mesh.vertex_count(); ++index)
+    {
+        const Vector3 position{vertex(mesh, index)};
+        min_x = std::fmin(min_x, position.x);
+        max_x = std::fmax(max_x, position.x);
+        max_height = std::fmax(max_height, std::fabs(position.y));
+    }
+    check(std::fabs(min_x + 5.01F) < 1e-4F && std::fabs(max_x - 5.01F) < 1e-4F,
+          "grid spans DrawGrid's extent plus half a line width");
+    check(max_height < 0.01F, "grid lies on the floor plane");
+}
+
+void test_box()
+{
+    StaticMeshData mesh{};
+    const Vector3 centre{1.F, -1.F, 2.F};
+    const Vector3 half_extent{5.F, 1.F, 3.F};
+    check(append_box(mesh, centre, half_extent, Color{200, 200, 200, 255}),
+          "box fits");
+
+    check(mesh.vertex_count() == 24, "box vertex count");
+    check(mesh.triangle_count() == 12, "box triangle count");
+    check(attributes_consistent(mesh), "box attributes consistent");
+    check(indices_in_range(mesh), "box indices in range");
+    check(windings_match_normals(mesh), "box faces point outwards");
+
+    bool inside_bounds{true};
+    for (std::size_t index{0}; index < mesh.vertex_count(); ++index)
+    {
+        const Vector3 position{vertex(mesh, index)};
+        inside_bounds = inside_bounds &&
+                        std::fabs(position.x - centre.x) <= half_extent.x &&
+                        std::fabs(position.y - centre.y) <= half_extent.y &&
+                        std::fabs(position.z - centre.z) <= half_extent.z;
+    }
+    check(inside_bounds, "box vertices on its bounds");
+
+    // top face is the first quad and is not darkened
+    check(mesh._colours[0] == 200, "top face keeps the base colour");
+    check(mesh._colours[4 * 4] < 200, "bottom face is shaded");
+}
+
+void test_appending()
+{
+    StaticMeshData mesh{};
+    append_box(mesh, Vector3{0.F, 0.F, 0.F}, Vector3{1.F, 1.F, 1.F}, WHITE);
+    append_box(mesh, Vector3{4.F, 0.F, 0.F}, Vector3{1.F, 1.F, 1.F}, WHITE);
+    check(mesh.vertex_count() == 48, "two boxes share one mesh");
+    check(indices_in_range(mesh), "second box indices offset");
+    check(mesh._indices[36] == 24, "second box starts after the first");
+}
+
+void test_index_limit()
+{
+    StaticMeshData mesh{};
+    std::size_t boxes{0};
+    while (append_box(
+        mesh, Vector3{0.F, 0.F, 0.F}, Vector3{1.F, 1.F, 1.F}, WHITE))
+    {
+        ++boxes;
+    }
+    check(boxes == kMaxStaticMeshVertices / 24, "stops at the index limit");
+    check(mesh.vertex_count() <= kMaxStaticMeshVertices,
+          "never exceeds 16-bit indices");
+    check(!append_grid(mesh, 10, 1.F, 0.02F), "full mesh rejects a grid");
+    check(indices_in_range(mesh), "indices valid when full");
+}
+} // namespace
+
+int main()
+{
+    test_grid();
+    test_box();
+    test_appending();
+    test_index_limit();
+    return check_result("static mesh");
+}
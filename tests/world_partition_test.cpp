@@ -0,0 +1,147 @@
+#include "world_partition.h"
+
+#include "check.h"
+#include "constants.h"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+std::size_t load_all(WorldPartition &partition,
+                     std::vector<std::uint64_t> &entities)
+{
+    std::size_t cells{0};
+    while (partition.load_next(entities))
+    {
+        ++cells;
+    }
+    return cells;
+}
+
+void test_cells()
+{
+    constexpr float kCellSize{10.F};
+    check(partition_cell_of(Vector3{5.F, 100.F, 15.F}, kCellSize) ==
+              PartitionCell{0, 1},
+          "height does not matter");
+    check(partition_cell_of(Vector3{-0.5F, 0.F, -10.F}, kCellSize) ==
+              PartitionCell{-1, -1},
+          "negative positions round down");
+    check(partition_cell_distance(PartitionCell{0, 0}, PartitionCell{2, -1}) ==
+              2,
+          "distance is along the furthest axis");
+}
+
+void test_loads_nearest_first()
+{
+    WorldPartition partition{};
+    check(partition.update_centre(PartitionCell{0, 0}, 1, 2),
+          "the first centre needs a sweep");
+    check(partition.queued_cell_count() == 9, "queues the square around it");
+
+    std::vector<std::uint64_t> entities;
+    check(partition.load_next(entities), "loads a queued cell");
+    check(partition.loaded_cell_count() == 1 &&
+              partition.is_wanted(PartitionCell{0, 0}),
+          "loads the centre cell first");
+    check(load_all(partition, entities) == 8, "loads the rest");
+    check(!partition.load_next(entities), "stops once everything is loaded");
+    check(!partition.is_wanted(PartitionCell{2, 0}),
+          "does not want cells past the load radius");
+}
+
+void test_parked_entities_come_back()
+{
+    WorldPartition partition{};
+    partition.update_centre(PartitionCell{0, 0}, 1, 1);
+    std::vector<std::uint64_t> entities;
+    load_all(partition, entities);
+
+    partition.park(PartitionCell{3, 0}, 7);
+    partition.park(PartitionCell{3, 0}, 8);
+    partition.park(PartitionCell{-5, 0}, 9);
+    check(partition.parked_entity_count() == 3 &&
+              partition.parked_cell_count() == 2,
+          "counts parked entities and cells");
+
+    partition.update_centre(PartitionCell{2, 0}, 1, 1);
+    check(!partition.is_wanted(PartitionCell{0, 0}),
+          "drops cells past the unload radius");
+    check(partition.is_wanted(PartitionCell{1, 0}),
+          "keeps loaded cells within the unload radius");
+    bool sizes_match{true};
+    while (partition.queued_cell_count() > 0)
+    {
+        const std::size_t next{partition.next_load_size()};
+        const std::size_t loaded{entities.size()};
+        partition.load_next(entities);
+        sizes_match &= entities.size() - loaded == next;
+    }
+    check(sizes_match && partition.next_load_size() == 0,
+          "tells how many entities the next cell hands back");
+    std::sort(entities.begin(), entities.end());
+    check(entities == std::vector<std::uint64_t>{7, 8},
+          "hands back the entities parked in a loaded cell");
+    check(partition.parked_entity_count() == 1, "keeps the far ones parked");
+
+    entities.clear();
+    partition.reset(entities);
+    check(entities == std::vector<std::uint64_t>{9} && !partition.active(),
+          "reset hands back everything");
+}
+
+void test_hysteresis()
+{
+    WorldPartition partition{};
+    partition.update_centre(PartitionCell{0, 0}, 1, 3);
+    std::vector<std::uint64_t> entities;
+    load_all(partition, entities);
+    partition.update_centre(PartitionCell{1, 0}, 1, 3);
+    check(partition.queued_cell_count() == 3,
+          "only queues the newly wanted column");
+    load_all(partition, entities);
+    partition.update_centre(PartitionCell{0, 0}, 1, 3);
+    check(partition.queued_cell_count() == 0,
+          "moving back over a border loads nothing");
+    check(partition.is_wanted(PartitionCell{2, 0}),
+          "keeps cells until past the unload radius");
+}
+
+void test_sweeps_periodically()
+{
+    WorldPartition partition{};
+    partition.update_centre(PartitionCell{0, 0}, 1, 1);
+    int sweeps{0};
+    for (int frame{0}; frame < constants::kPartitionSweepFrames; ++frame)
+    {
+        sweeps += partition.update_centre(PartitionCell{0, 0}, 1, 1) ? 1 : 0;
+    }
+    check(sweeps == 1, "sweeps again once the interval has passed");
+}
+
+void test_load_estimate()
+{
+    WorldPartition partition{};
+    check(partition.estimated_load_milliseconds(100) == 0.0,
+          "starts without an estimate");
+    partition.record_load_cost(100, 2.0);
+    check(partition.estimated_load_milliseconds(50) == 1.0,
+          "scales the measured cost per body");
+}
+} // namespace
+
+int main()
+{
+    test_cells();
+    test_loads_nearest_first();
+    test_parked_entities_come_back();
+    test_hysteresis();
+    test_sweeps_periodically();
+    test_load_estimate();
+    return check_result("world partition");
+}
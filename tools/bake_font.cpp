@@ -0,0 +1,132 @@
+// Build step: rasterises a TTF the way raylib's LoadFont does and writes the
+// glyph metrics and atlas out as a C++ source file holding one byte array, so
+// the game links in the finished atlas instead of building it at startup.
+// Only CPU side raylib calls are used, no window or GL context is needed.
+//
+// Usage: bake_font <font.ttf> <output.cpp>
+
+#include "baked_font.h"
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+template <typename Value>
+void append_bytes(std::vector<unsigned char> &blob, const Value &value)
+{
+    const std::size_t offset{blob.size()};
+    blob.resize(offset + sizeof(value));
+    std::memcpy(blob.data() + offset, &value, sizeof(value));
+}
+
+bool write_source(const std::vector<unsigned char> &blob,
+                  const std::string_view font_path,
+                  const char *output_path)
+{
+    std::ofstream output{output_path};
+    if (!output)
+    {
+        return false;
+    }
+    output << "// Generated by tools/bake_font.cpp from " << font_path
+           << ", do not edit\n\n"
+           << "#include \"baked_font.h\"\n\n"
+           << "#include <cstddef>\n\n"
+           << "alignas(16) const unsigned char kBakedFontData[]{";
+    constexpr std::size_t kBytesPerLine{24};
+    for (std::size_t index{0}; index < blob.size(); ++index)
+    {
+        output << (index % kBytesPerLine == 0 ? "\n    " : " ")
+               << static_cast<unsigned int>(blob[index]) << ',';
+    }
+    output << "};\n\n"
+           << "const std::size_t kBakedFontDataSize{sizeof(kBakedFontData)};\n";
+    return static_cast<bool>(output);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::vector<std::string_view> arguments(argv, argv + argc);
+    if (arguments.size() != 3)
+    {
+        std::cerr << "usage: bake_font <font.ttf> <output.cpp>\n";
+        return EXIT_FAILURE;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    int file_size{0};
+    unsigned char *file_data{LoadFileData(argv[1], &file_size)};
+    if (file_data == nullptr)
+    {
+        std::cerr << "bake_font: could not read " << arguments[1] << '\n';
+        return EXIT_FAILURE;
+    }
+
+    // nullptr codepoints means kBakedFontGlyphCount characters from 32 up
+    GlyphInfo *glyphs{LoadFontData(file_data,
+                                   file_size,
+                                   kBakedFontBaseSize,
+                                   nullptr,
+                                   kBakedFontGlyphCount,
+                                   FONT_DEFAULT)};
+    UnloadFileData(file_data);
+    if (glyphs == nullptr)
+    {
+        std::cerr << "bake_font: could not rasterise " << arguments[1] << '\n';
+        return EXIT_FAILURE;
+    }
+
+    Rectangle *rectangles{nullptr};
+    const Image atlas{GenImageFontAtlas(glyphs,
+                                        &rectangles,
+                                        kBakedFontGlyphCount,
+                                        kBakedFontBaseSize,
+                                        kBakedFontGlyphPadding,
+                                        0)};
+
+    std::vector<unsigned char> blob;
+    BakedFontHeader header{};
+    header._base_size = kBakedFontBaseSize;
+    header._glyph_count = kBakedFontGlyphCount;
+    header._glyph_padding = kBakedFontGlyphPadding;
+    header._atlas_width = atlas.width;
+    header._atlas_height = atlas.height;
+    header._atlas_format = atlas.format;
+    append_bytes(blob, header);
+    for (int index{0}; index < kBakedFontGlyphCount; ++index)
+    {
+        const GlyphInfo &glyph_info{glyphs[index]};
+        BakedGlyph glyph{};
+        glyph._value = glyph_info.value;
+        glyph._offset_x = glyph_info.offsetX;
+        glyph._offset_y = glyph_info.offsetY;
+        glyph._advance_x = glyph_info.advanceX;
+        glyph._atlas_rectangle = rectangles[index];
+        append_bytes(blob, glyph);
+    }
+    const auto *pixels{static_cast<const unsigned char *>(atlas.data)};
+    blob.insert(blob.end(),
+                pixels,
+                pixels + GetPixelDataSize(
+                             atlas.width, atlas.height, atlas.format));
+
+    UnloadImage(atlas);
+    MemFree(rectangles);
+    UnloadFontData(glyphs, kBakedFontGlyphCount);
+
+    if (!write_source(blob, arguments[1], argv[2]))
+    {
+        std::cerr << "bake_font: could not write " << arguments[2] << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,630 @@
+// Microbenchmarks of the ways this project uses flecs, on its own components,
+// from 1k entities up to a million. Each benchmark runs in a fresh world and
+// is repeated after one discarded warm-up run, and the median, fastest and
+// slowest runs are reported, on the console and as JSON so runs can be
+// compared across flecs versions.
+//
+// Usage: ecs_benchmark [--output path] [--max-entities n] [--repetitions n]
+//                      [--filter text]
+//
+// Iteration: a query with the DevPanelState singleton as a term, as the Dev
+// Panel and sphere drawing queries have, against the same query with the
+// singleton read once beforehand, each with per entity each and per table
+// iter. Writes: entity.set per entity, the same deferred, and writing
+// through a query. Creation: entities built one set at a time against
+// ecs_bulk_init. Fragmentation: the same entities spread over more and more
+// archetypes by tags.
+
+#include "command_line.h"
+#include "components.h"
+
+#include <flecs.h> // NOLINT [misc-include-cleaner]
+#include <flecs/addons/cpp/entity.hpp>
+#include <flecs/addons/cpp/flecs.hpp>
+#include <flecs/addons/cpp/iter.hpp>
+#include <flecs/addons/cpp/mixins/query/impl.hpp>
+#include <flecs/addons/cpp/world.hpp>
+#include <fmt/core.h>
+#include <raylib.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <ratio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+constexpr float kDeltaTime{1.F / 60.F};
+constexpr std::array<std::int32_t, 4> kEntityCounts{
+    1'000, 10'000, 100'000, 1'000'000};
+constexpr std::array<std::int32_t, 4> kArchetypeCounts{1, 16, 256, 4'096};
+// Runs timed and thrown away before the repetitions, so the first page
+// faults and cold caches do not land in the results
+constexpr std::int32_t kWarmUpRuns{1};
+
+struct BenchmarkOptions
+{
+    std::string _output{"ecs_benchmark.json"};
+    std::int32_t _max_entities{1'000'000};
+    std::int32_t _repetitions{10};
+    std::string _filter{};
+};
+
+struct BenchmarkResult
+{
+    std::string _name{};
+    std::int32_t _entities{0};
+    std::int32_t _archetypes{0}; // tables the benchmark's query matched
+    double _median_milliseconds{0.0};
+    double _min_milliseconds{0.0};
+    double _max_milliseconds{0.0};
+
+    [[nodiscard]] double nanoseconds_per_entity() const
+    {
+        constexpr double kNanosecondsPerMillisecond{1'000'000.0};
+        return _median_milliseconds * kNanosecondsPerMillisecond /
+               static_cast<double>(_entities);
+    }
+};
+
+bool parse_options(const std::vector<std::string_view> &arguments,
+                   BenchmarkOptions &options)
+{
+    constexpr std::int32_t kLargest{std::numeric_limits<std::int32_t>::max()};
+    for (std::size_t index{1}; index + 1 < arguments.size(); index += 2)
+    {
+        const std::string_view value{arguments[index + 1]};
+        bool parsed{true};
+        if (arguments[index] == "--output")
+        {
+            options._output = value;
+        }
+        else if (arguments[index] == "--max-entities")
+        {
+            parsed = parse_number(value, 1, kLargest, options._max_entities);
+        }
+        else if (arguments[index] == "--repetitions")
+        {
+            parsed = parse_number(value, 1, kLargest, options._repetitions);
+        }
+        else if (arguments[index] == "--filter")
+        {
+            options._filter = value;
+        }
+        else
+        {
+            parsed = false;
+        }
+        if (!parsed)
+        {
+            return false;
+        }
+    }
+    return arguments.size() % 2 == 1;
+}
+
+template <typename Function>
+double time_milliseconds(Function &&function)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    function();
+    return std::chrono::duration<double, std::milli>{
+        std::chrono::steady_clock::now() - start}
+        .count();
+}
+
+// Runs set_up, then times run, once per repetition after kWarmUpRuns, each
+// in a new world. Only run is timed, so anything it needs ready made belongs
+// in set_up. Benchmarks not matching the filter are skipped.
+template <typename SetUp, typename Run>
+void measure(const BenchmarkOptions &options,
+             const char *name,
+             const std::int32_t entities,
+             SetUp &&set_up,
+             Run &&run,
+             std::vector<BenchmarkResult> &results)
+{
+    if (!options._filter.empty() &&
+        std::string_view{name}.find(options._filter) == std::string_view::npos)
+    {
+        return;
+    }
+    const std::int32_t repetitions{options._repetitions};
+    BenchmarkResult result{};
+    result._name = name;
+    result._entities = entities;
+    std::vector<double> milliseconds{};
+    milliseconds.reserve(static_cast<std::size_t>(repetitions));
+    for (std::int32_t pass{0}; pass < kWarmUpRuns + repetitions; ++pass)
+    {
+        const flecs::world world;
+        auto state{set_up(world)};
+        const double elapsed{
+            time_milliseconds([&run, &world, &state]() { run(world, state); })};
+        if (pass < kWarmUpRuns)
+        {
+            continue;
+        }
+        milliseconds.push_back(elapsed);
+        result._archetypes = state.table_count();
+    }
+    std::sort(milliseconds.begin(), milliseconds.end());
+    result._median_milliseconds = milliseconds[milliseconds.size() / 2];
+    result._min_milliseconds = milliseconds.front();
+    result._max_milliseconds = milliseconds.back();
+    results.push_back(result);
+}
+
+void spawn_spheres(const flecs::world &world,
+                   const std::int32_t count,
+                   std::vector<flecs::entity> &entities)
+{
+    world.set<DevPanelState>(DevPanelState{});
+    entities.reserve(static_cast<std::size_t>(count));
+    for (std::int32_t sphere{0}; sphere < count; ++sphere)
+    {
+        const auto offset{static_cast<float>(sphere)};
+        entities.push_back(
+            world.entity()
+                .set<Position>(Position{Vector3{offset, 10.F, 0.F}})
+                .set<Velocity>(Velocity{Vector3{0.5F, 0.F, 0.F}})
+                .set<SphereMesh>(SphereMesh{RED, 0.5F})
+                .add<SphereLod>());
+    }
+}
+
+void move_sphere(Position &position,
+                 const Velocity &velocity,
+                 const SphereMesh &mesh)
+{
+    position._centre.x += velocity._value.x * kDeltaTime;
+    position._centre.y =
+        std::max(position._centre.y + velocity._value.y * kDeltaTime,
+                 mesh._radius);
+}
+
+// The spheres a benchmark works on and the query it runs over them
+template <typename... Components> struct QueryState
+{
+    std::vector<flecs::entity> _entities{};
+    flecs::query<Components...> _query{};
+
+    [[nodiscard]] std::int32_t table_count() const
+    {
+        return ecs_query_table_count(_query.c_ptr());
+    }
+};
+
+using SingletonTermState = QueryState<Position,
+                                      const Velocity,
+                                      const SphereMesh,
+                                      const DevPanelState>;
+using SphereState = QueryState<Position, const Velocity, const SphereMesh>;
+using VelocityState = QueryState<Velocity>;
+
+struct EmptyState
+{
+    [[nodiscard]] static std::int32_t table_count()
+    {
+        return 1;
+    }
+};
+
+// Component columns ready for ecs_bulk_init
+struct BulkState
+{
+    std::vector<Position> _positions{};
+    std::vector<Velocity> _velocities{};
+    std::vector<SphereMesh> _meshes{};
+    std::vector<SphereLod> _lods{};
+    ecs_bulk_desc_t _desc{};
+
+    [[nodiscard]] static std::int32_t table_count()
+    {
+        return 1;
+    }
+};
+
+void run_iteration_benchmarks(const BenchmarkOptions &options,
+                              const std::int32_t entities,
+                              std::vector<BenchmarkResult> &results)
+{
+    const auto singleton_term{[entities](const flecs::world &world) {
+        SingletonTermState state{};
+        spawn_spheres(world, entities, state._entities);
+        state._query = world
+                           .query_builder<Position,
+                                          const Velocity,
+                                          const SphereMesh,
+                                          const DevPanelState>()
+                           .term_at(4)
+                           .singleton()
+                           .build();
+        return state;
+    }};
+    const auto hoisted{[entities](const flecs::world &world) {
+        SphereState state{};
+        spawn_spheres(world, entities, state._entities);
+        state._query =
+            world.query_builder<Position, const Velocity, const SphereMesh>()
+                .build();
+        return state;
+    }};
+
+    measure(
+        options,
+        "each_singleton_term",
+        entities,
+        singleton_term,
+        [](const flecs::world & /* world */, const SingletonTermState &state) {
+            state._query.each([](Position &position,
+                                 const Velocity &velocity,
+                                 const SphereMesh &mesh,
+                                 const DevPanelState &dev_panel_state) {
+                if (!dev_panel_state._paused)
+                {
+                    move_sphere(position, velocity, mesh);
+                }
+            });
+        },
+        results);
+    measure(
+        options,
+        "each_hoisted_singleton",
+        entities,
+        hoisted,
+        [](const flecs::world &world, const SphereState &state) {
+            if (world.get<DevPanelState>()->_paused)
+            {
+                return;
+            }
+            state._query.each([](Position &position,
+                                 const Velocity &velocity,
+                                 const SphereMesh &mesh) {
+                move_sphere(position, velocity, mesh);
+            });
+        },
+        results);
+    measure(
+        options,
+        "iter_singleton_term",
+        entities,
+        singleton_term,
+        [](const flecs::world & /* world */, const SingletonTermState &state) {
+            // the singleton is not owned by the table, so it is one value
+            // rather than an array
+            state._query.iter([](flecs::iter &iter,
+                                 Position *positions,
+                                 const Velocity *velocities,
+                                 const SphereMesh *meshes,
+                                 const DevPanelState *dev_panel_state) {
+                if (dev_panel_state->_paused)
+                {
+                    return;
+                }
+                for (std::size_t row{0}; row < iter.count(); ++row)
+                {
+                    move_sphere(positions[row], velocities[row], meshes[row]);
+                }
+            });
+        },
+        results);
+    measure(
+        options,
+        "iter_hoisted_singleton",
+        entities,
+        hoisted,
+        [](const flecs::world &world, const SphereState &state) {
+            if (world.get<DevPanelState>()->_paused)
+            {
+                return;
+            }
+            state._query.iter([](flecs::iter &iter,
+                                 Position *positions,
+                                 const Velocity *velocities,
+                                 const SphereMesh *meshes) {
+                for (std::size_t row{0}; row < iter.count(); ++row)
+                {
+                    move_sphere(positions[row], velocities[row], meshes[row]);
+                }
+            });
+        },
+        results);
+}
+
+void run_write_benchmarks(const BenchmarkOptions &options,
+                          const std::int32_t entities,
+                          std::vector<BenchmarkResult> &results)
+{
+    const auto spheres{[entities](const flecs::world &world) {
+        SphereState state{};
+        spawn_spheres(world, entities, state._entities);
+        state._query =
+            world.query_builder<Position, const Velocity, const SphereMesh>()
+                .build();
+        return state;
+    }};
+    const Velocity velocity{Vector3{0.F, -1.F, 0.F}};
+
+    measure(
+        options,
+        "set_per_entity",
+        entities,
+        spheres,
+        [&velocity](const flecs::world & /* world */, const SphereState &state) {
+            for (const flecs::entity &entity : state._entities)
+            {
+                entity.set<Velocity>(velocity);
+            }
+        },
+        results);
+    measure(
+        options,
+        "set_per_entity_deferred",
+        entities,
+        spheres,
+        [&velocity](const flecs::world &world, const SphereState &state) {
+            world.defer_begin();
+            for (const flecs::entity &entity : state._entities)
+            {
+                entity.set<Velocity>(velocity);
+            }
+            world.defer_end();
+        },
+        results);
+    measure(
+        options,
+        "set_through_query",
+        entities,
+        [entities](const flecs::world &world) {
+            VelocityState state{};
+            spawn_spheres(world, entities, state._entities);
+            state._query = world.query_builder<Velocity>().build();
+            return state;
+        },
+        [&velocity](const flecs::world & /* world */,
+                    const VelocityState &state) {
+            state._query.each([&velocity](Velocity &value) { value = velocity; });
+        },
+        results);
+}
+
+void run_creation_benchmarks(const BenchmarkOptions &options,
+                             const std::int32_t entities,
+                             std::vector<BenchmarkResult> &results)
+{
+    const auto register_components{[](const flecs::world &world) {
+        world.component<Position>();
+        world.component<Velocity>();
+        world.component<SphereMesh>();
+        world.component<SphereLod>();
+        return EmptyState{};
+    }};
+
+    measure(
+        options,
+        "create_per_entity",
+        entities,
+        register_components,
+        [entities](const flecs::world &world, const EmptyState & /* state */) {
+            for (std::int32_t sphere{0}; sphere < entities; ++sphere)
+            {
+                world.entity()
+                    .set<Position>(Position{Vector3{0.F, 10.F, 0.F}})
+                    .set<Velocity>(Velocity{Vector3{0.5F, 0.F, 0.F}})
+                    .set<SphereMesh>(SphereMesh{RED, 0.5F})
+                    .add<SphereLod>();
+            }
+        },
+        results);
+    // the input columns are filled in before the clock starts, so only
+    // flecs copying them in is timed
+    measure(
+        options,
+        "create_bulk",
+        entities,
+        [entities](const flecs::world &world) {
+            const auto count{static_cast<std::size_t>(entities)};
+            BulkState state{};
+            state._positions.assign(count, Position{Vector3{0.F, 10.F, 0.F}});
+            state._velocities.assign(count, Velocity{Vector3{0.5F, 0.F, 0.F}});
+            state._meshes.assign(count, SphereMesh{RED, 0.5F});
+            state._lods.resize(count);
+            state._desc.count = entities;
+            state._desc.ids[0] = world.component<Position>().id();
+            state._desc.ids[1] = world.component<Velocity>().id();
+            state._desc.ids[2] = world.component<SphereMesh>().id();
+            state._desc.ids[3] = world.component<SphereLod>().id();
+            return state;
+        },
+        [](const flecs::world &world, BulkState &state) {
+            std::array<void *, 4> data{state._positions.data(),
+                                       state._velocities.data(),
+                                       state._meshes.data(),
+                                       state._lods.data()};
+            state._desc.data = data.data();
+            ecs_bulk_init(world.c_ptr(), &state._desc);
+        },
+        results);
+}
+
+void run_fragmentation_benchmarks(const BenchmarkOptions &options,
+                                  const std::int32_t entities,
+                                  std::vector<BenchmarkResult> &results)
+{
+    for (const std::int32_t archetypes : kArchetypeCounts)
+    {
+        if (archetypes > entities)
+        {
+            break;
+        }
+        // a tag per archetype, so every table holds the same components
+        const auto fragmented{[entities, archetypes](const flecs::world &world) {
+            SphereState state{};
+            std::vector<flecs::entity> tags{};
+            for (std::int32_t tag{0}; tag < archetypes; ++tag)
+            {
+                tags.push_back(world.entity());
+            }
+            spawn_spheres(world, entities, state._entities);
+            std::size_t tag{0};
+            for (const flecs::entity &entity : state._entities)
+            {
+                entity.add(tags[tag]);
+                tag = (tag + 1) % tags.size();
+            }
+            state._query =
+                world.query_builder<Position, const Velocity, const SphereMesh>()
+                    .build();
+            return state;
+        }};
+
+        measure(
+            options,
+            "fragmented_each",
+            entities,
+            fragmented,
+            [](const flecs::world & /* world */, const SphereState &state) {
+                state._query.each([](Position &position,
+                                     const Velocity &velocity,
+                                     const SphereMesh &mesh) {
+                    move_sphere(position, velocity, mesh);
+                });
+            },
+            results);
+        measure(
+            options,
+            "fragmented_iter",
+            entities,
+            fragmented,
+            [](const flecs::world & /* world */, const SphereState &state) {
+                state._query.iter([](flecs::iter &iter,
+                                     Position *positions,
+                                     const Velocity *velocities,
+                                     const SphereMesh *meshes) {
+                    for (std::size_t row{0}; row < iter.count(); ++row)
+                    {
+                        move_sphere(
+                            positions[row], velocities[row], meshes[row]);
+                    }
+                });
+            },
+            results);
+    }
+}
+
+bool write_results(const std::vector<BenchmarkResult> &results,
+                   const BenchmarkOptions &options)
+{
+    const std::filesystem::path output_path{options._output};
+    if (output_path.has_parent_path())
+    {
+        std::filesystem::create_directories(output_path.parent_path());
+    }
+    std::ofstream output{output_path};
+    if (!output)
+    {
+        std::cerr << "Could not write benchmark results to " << options._output
+                  << '\n';
+        return false;
+    }
+#ifdef NDEBUG
+    constexpr bool kOptimised{true};
+#else
+    constexpr bool kOptimised{false};
+#endif
+    output << fmt::format("{{\n"
+                          "  \"flecs_version\": \"{}.{}.{}\",\n"
+                          "  \"optimised\": {},\n"
+                          "  \"repetitions\": {},\n"
+                          "  \"warm_up_runs\": {},\n"
+                          "  \"results\": [",
+                          FLECS_VERSION_MAJOR,
+                          FLECS_VERSION_MINOR,
+                          FLECS_VERSION_PATCH,
+                          kOptimised,
+                          options._repetitions,
+                          kWarmUpRuns);
+    const char *separator{"\n"};
+    for (const BenchmarkResult &result : results)
+    {
+        output << separator
+               << fmt::format("    {{\"benchmark\": \"{}\", \"entities\": {}, "
+                              "\"archetypes\": {}, \"median_ms\": {:.4f}, "
+                              "\"min_ms\": {:.4f}, \"max_ms\": {:.4f}, "
+                              "\"ns_per_entity\": {:.2f}}}",
+                              result._name,
+                              result._entities,
+                              result._archetypes,
+                              result._median_milliseconds,
+                              result._min_milliseconds,
+                              result._max_milliseconds,
+                              result.nanoseconds_per_entity());
+        separator = ",\n";
+    }
+    output << "\n  ]\n}\n";
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::vector<std::string_view> arguments(argv, argv + argc);
+    BenchmarkOptions options{};
+    if (!parse_options(arguments, options))
+    {
+        std::cerr << "Usage: ecs_benchmark [--output path] [--max-entities n] "
+                     "[--repetitions n] [--filter text]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BenchmarkResult> results{};
+    for (const std::int32_t entities : kEntityCounts)
+    {
+        if (entities > options._max_entities)
+        {
+            break;
+        }
+        std::cout << "Running " << entities << " entities\n";
+        run_iteration_benchmarks(options, entities, results);
+        run_write_benchmarks(options, entities, results);
+        run_creation_benchmarks(options, entities, results);
+        run_fragmentation_benchmarks(options, entities, results);
+    }
+    if (!options._filter.empty())
+    {
+        results.erase(std::remove_if(results.begin(),
+                                     results.end(),
+                                     [&options](const BenchmarkResult &result) {
+                                         return result._name.find(
+                                                    options._filter) ==
+                                                std::string::npos;
+                                     }),
+                      results.end());
+    }
+
+    std::cout << std::fixed << std::setprecision(3) << std::setw(26)
+              << "benchmark" << std::setw(10) << "entities" << std::setw(12)
+              << "archetypes" << std::setw(12) << "median ms" << std::setw(12)
+              << "min ms" << std::setw(12) << "ns/entity" << '\n';
+    for (const BenchmarkResult &result : results)
+    {
+        std::cout << std::setw(26) << result._name << std::setw(10)
+                  << result._entities << std::setw(12) << result._archetypes
+                  << std::setw(12) << result._median_milliseconds
+                  << std::setw(12) << result._min_milliseconds << std::setw(12)
+                  << result.nanoseconds_per_entity() << '\n';
+    }
+    return write_results(results, options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
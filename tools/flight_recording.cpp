@@ -0,0 +1,109 @@
+// Prints a flight recording dumped by the game, oldest record first, with
+// times in seconds before the dump.
+//
+// Usage: flight_recording <recording> [--type frame|step|key|mouse|log|assert]
+
+#include "flight_recorder.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+constexpr std::array<const char *, 6> kTypeNames{
+    "frame", "step", "key", "mouse", "log", "assert"};
+// spdlog's levels, in order
+constexpr std::array<const char *, 7> kLevelNames{
+    "trace", "debug", "info", "warning", "error", "critical", "off"};
+constexpr std::array<const char *, 3> kReasonNames{
+    "requested", "assert", "signal"};
+
+template <std::size_t Size>
+const char *name_of(const std::array<const char *, Size> &names,
+                    const std::size_t index)
+{
+    return index < names.size() ? names[index] : "unknown";
+}
+
+void print_record(const FlightRecord &record, const std::int64_t dumped)
+{
+    constexpr double kNanosecondsPerSecond{1'000'000'000.0};
+    const auto type{static_cast<std::size_t>(record._type)};
+    std::cout << std::setw(10)
+              << static_cast<double>(record._nanoseconds - dumped) /
+                     kNanosecondsPerSecond
+              << " s  " << std::setw(6) << name_of(kTypeNames, type) << "  ";
+    switch (record._type)
+    {
+    case FlightRecordType::kFrame:
+        std::cout << "frame " << record._index << ", " << record._values[0]
+                  << " ms";
+        break;
+    case FlightRecordType::kPhysicsStep:
+        std::cout << "step " << record._index << ", " << record._values[0]
+                  << " ms, " << record._count << " bodies";
+        break;
+    case FlightRecordType::kKey:
+        std::cout << "key " << record._count;
+        break;
+    case FlightRecordType::kMouse:
+        std::cout << "button " << record._count << " at ("
+                  << record._values[0] << ", " << record._values[1] << ")";
+        break;
+    case FlightRecordType::kLog:
+        std::cout << name_of(kLevelNames, record._level) << ": "
+                  << record._text.data();
+        break;
+    case FlightRecordType::kAssert:
+        std::cout << "line " << record._count << ", " << record._text.data();
+        break;
+    }
+    std::cout << '\n';
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::vector<std::string_view> arguments(argv, argv + argc);
+    const bool filtered{arguments.size() == 4 && arguments[2] == "--type"};
+    if (arguments.size() != 2 && !filtered)
+    {
+        std::cerr << "Usage: flight_recording <recording> "
+                     "[--type frame|step|key|mouse|log|assert]\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::string path{arguments[1]};
+    FlightRecordingHeader header{};
+    std::vector<FlightRecord> records;
+    if (!read_flight_recording(path, header, records))
+    {
+        std::cerr << "Could not read flight recording " << path << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cout << records.size() << " records, dumped on "
+              << name_of(kReasonNames, static_cast<std::size_t>(header._reason));
+    if (header._reason == FlightDumpReason::kSignal)
+    {
+        std::cout << " " << header._detail;
+    }
+    std::cout << '\n' << std::fixed << std::setprecision(3);
+    for (const FlightRecord &record : records)
+    {
+        if (!filtered ||
+            arguments[3] ==
+                name_of(kTypeNames, static_cast<std::size_t>(record._type)))
+        {
+            print_record(record, header._nanoseconds);
+        }
+    }
+    return EXIT_SUCCESS;
+}
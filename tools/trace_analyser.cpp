@@ -0,0 +1,259 @@
+// Offline analysis of a body trace recorded with --trace. Streams the trace one
+// step at a time, so traces far larger than memory can be read, and reports
+// the body count over time, energy drift and bodies tunnelling through the
+// floor.
+//
+// Usage: trace_analyser <trace> [--floor height] [--extent half_extent]
+//                       [--gravity g] [--every steps]
+//
+// Energy is per unit mass, 0.5 |v|^2 + g y, summed over the bodies. Rotation
+// is not traced, so spin is left out. A body tunnels if its centre goes from
+// above the floor height to below it between two steps while inside the
+// floor's half extent on x and z, or anywhere when no extent is given.
+
+#include "body_trace.h"
+#include "command_line.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+struct AnalyserOptions
+{
+    std::string _path{};
+    float _floor_height{0.F};
+    float _floor_extent{0.F};
+    float _gravity{9.81F};
+    std::uint64_t _every{60};
+};
+
+struct Tunnelling
+{
+    std::uint64_t _step{0};
+    std::uint64_t _entity{0};
+    float _from{0.F};
+    float _to{0.F};
+};
+
+bool parse_options(const std::vector<std::string_view> &arguments,
+                   AnalyserOptions &options)
+{
+    if (arguments.size() < 2)
+    {
+        return false;
+    }
+    options._path = arguments[1];
+    constexpr float kLargest{std::numeric_limits<float>::max()};
+    for (std::size_t index{2}; index + 1 < arguments.size(); index += 2)
+    {
+        const std::string_view value{arguments[index + 1]};
+        bool parsed{false};
+        if (arguments[index] == "--floor")
+        {
+            parsed = parse_number(
+                value, -kLargest, kLargest, options._floor_height);
+        }
+        else if (arguments[index] == "--extent")
+        {
+            parsed = parse_number(value, 0.F, kLargest, options._floor_extent);
+        }
+        else if (arguments[index] == "--gravity")
+        {
+            parsed =
+                parse_number(value, -kLargest, kLargest, options._gravity);
+        }
+        else if (arguments[index] == "--every")
+        {
+            parsed = parse_number(value,
+                                  std::uint64_t{1},
+                                  std::numeric_limits<std::uint64_t>::max(),
+                                  options._every);
+        }
+        if (!parsed)
+        {
+            return false;
+        }
+    }
+    return arguments.size() % 2 == 0;
+}
+
+double energy(const BodyTraceColumns &columns, const float gravity)
+{
+    double total{0.0};
+    for (std::size_t index{0}; index < columns.size(); ++index)
+    {
+        const double speed_squared{
+            static_cast<double>(columns._velocity[0][index]) *
+                columns._velocity[0][index] +
+            static_cast<double>(columns._velocity[1][index]) *
+                columns._velocity[1][index] +
+            static_cast<double>(columns._velocity[2][index]) *
+                columns._velocity[2][index]};
+        total += 0.5 * speed_squared +
+                 static_cast<double>(gravity) * columns._position[1][index];
+    }
+    return total;
+}
+
+bool over_floor(const BodyTraceColumns &columns,
+                const std::size_t index,
+                const float extent)
+{
+    return extent <= 0.F || (std::abs(columns._position[0][index]) <= extent &&
+                             std::abs(columns._position[2][index]) <= extent);
+}
+
+// Bodies that crossed the floor since the previous step. The same entity can
+// sit at a different index once bodies are added or removed.
+void find_tunnelling(const BodyTraceColumns &previous,
+                     const BodyTraceColumns &columns,
+                     const AnalyserOptions &options,
+                     std::unordered_map<std::uint64_t, std::size_t> &indices,
+                     std::vector<Tunnelling> &tunnelling)
+{
+    indices.clear();
+    for (std::size_t index{0}; index < previous.size(); ++index)
+    {
+        indices.emplace(previous._entities[index], index);
+    }
+    for (std::size_t index{0}; index < columns.size(); ++index)
+    {
+        const auto found{indices.find(columns._entities[index])};
+        if (found == indices.end())
+        {
+            continue;
+        }
+        const float from{previous._position[1][found->second]};
+        const float to{columns._position[1][index]};
+        if (from >= options._floor_height && to < options._floor_height &&
+            over_floor(columns, index, options._floor_extent))
+        {
+            tunnelling.push_back(
+                Tunnelling{columns._step, columns._entities[index], from, to});
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::vector<std::string_view> arguments(argv, argv + argc);
+    AnalyserOptions options{};
+    if (!parse_options(arguments, options))
+    {
+        std::cerr << "Usage: trace_analyser <trace> [--floor height] "
+                     "[--extent half_extent] [--gravity g] [--every steps]\n";
+        return EXIT_FAILURE;
+    }
+
+    BodyTraceReader reader{};
+    if (!reader.open(options._path))
+    {
+        std::cerr << "Could not read body trace " << options._path << '\n';
+        return EXIT_FAILURE;
+    }
+
+    BodyTraceColumns previous{};
+    BodyTraceColumns columns{};
+    std::unordered_map<std::uint64_t, std::size_t> indices{};
+    std::vector<Tunnelling> tunnelling{};
+    std::uint64_t steps{0};
+    std::size_t min_bodies{std::numeric_limits<std::size_t>::max()};
+    std::size_t max_bodies{0};
+    double total_bodies{0.0};
+    double first_energy{0.0};
+    double last_energy{0.0};
+    double max_energy_gain{0.0};
+    std::uint64_t max_energy_gain_step{0};
+
+    std::cout << std::fixed << std::setprecision(3) << std::setw(10) << "step"
+              << std::setw(10) << "bodies" << std::setw(10) << "sleeping"
+              << std::setw(10) << "contacts" << std::setw(16) << "energy"
+              << '\n';
+    while (reader.read(columns))
+    {
+        const double step_energy{energy(columns, options._gravity)};
+        if (steps == 0)
+        {
+            first_energy = step_energy;
+        }
+        else
+        {
+            // Spawning and despawning change the energy legitimately, so only
+            // compare steps with the same bodies
+            if (columns._entities == previous._entities &&
+                step_energy - last_energy > max_energy_gain)
+            {
+                max_energy_gain = step_energy - last_energy;
+                max_energy_gain_step = columns._step;
+            }
+            find_tunnelling(previous, columns, options, indices, tunnelling);
+        }
+
+        const std::size_t bodies{columns.size()};
+        min_bodies = std::min(min_bodies, bodies);
+        max_bodies = std::max(max_bodies, bodies);
+        total_bodies += static_cast<double>(bodies);
+        if (steps % options._every == 0)
+        {
+            const auto sleeping{
+                std::count(columns._sleeping.begin(), columns._sleeping.end(),
+                           std::uint8_t{1})};
+            std::uint64_t contacts{0};
+            for (const std::uint16_t body_contacts : columns._contacts)
+            {
+                contacts += body_contacts;
+            }
+            std::cout << std::setw(10) << columns._step << std::setw(10)
+                      << bodies << std::setw(10) << sleeping << std::setw(10)
+                      << contacts << std::setw(16) << step_energy << '\n';
+        }
+
+        last_energy = step_energy;
+        std::swap(previous, columns);
+        ++steps;
+    }
+    if (reader.failed())
+    {
+        std::cerr << "Body trace is corrupt after " << steps << " steps\n";
+        return EXIT_FAILURE;
+    }
+    if (steps == 0)
+    {
+        std::cout << "Body trace is empty\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cout << '\n'
+              << "Steps: " << steps << '\n'
+              << "Bodies: min " << min_bodies << ", max " << max_bodies
+              << ", mean " << total_bodies / static_cast<double>(steps)
+              << '\n'
+              << "Energy: first " << first_energy << ", last " << last_energy
+              << ", drift " << last_energy - first_energy << '\n'
+              << "Largest energy gain in one step: " << max_energy_gain
+              << " at step " << max_energy_gain_step << '\n'
+              << "Tunnelling through the floor: " << tunnelling.size()
+              << '\n';
+    constexpr std::size_t kListedTunnelling{10};
+    for (std::size_t index{0};
+         index < std::min(tunnelling.size(), kListedTunnelling);
+         ++index)
+    {
+        const Tunnelling &event{tunnelling[index]};
+        std::cout << "  step " << event._step << ", entity " << event._entity
+                  << ", y " << event._from << " -> " << event._to << '\n';
+    }
+    return tunnelling.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}